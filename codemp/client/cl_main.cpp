@@ -2528,6 +2528,8 @@ void CL_InitRef( void ) {
 	ri.PD_Store = PD_Store;
 	ri.PD_Load = PD_Load;
 
+	ri.Com_RunJobs = Com_RunJobs;
+
 	// Vulkan 
 	ri.VK_IsMinimized = WIN_VK_IsMinimized;
 	ri.VK_GetInstanceProcAddress = WIN_VK_GetInstanceProcAddress;
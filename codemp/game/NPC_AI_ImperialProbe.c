@@ -313,7 +313,7 @@ void ImperialProbe_FireBlaster(void)
 
 	missile = CreateMissile( muzzle1, forward, 1600, 10000, NPCS.NPC, qfalse );
 
-	missile->classname = "bryar_proj";
+	G_SetClassname( missile, "bryar_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	if ( g_npcspskill.integer <= 1 )
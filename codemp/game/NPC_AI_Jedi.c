@@ -465,7 +465,7 @@ void Boba_StartFlameThrower( gentity_t *self )
 		VectorCopy( org, fire->s.origin );
 		VectorCopy( ang, fire->s.angles );
 
-		fire->targetname = "bobafire";
+		G_SetTargetname( fire, "bobafire" );
 		SP_fx_explosion_trail( fire );
 		fire->damage = 1;
 		fire->radius = 10;
@@ -161,7 +161,7 @@ void Mark1Dead_FireRocket (void)
 
 	missile = CreateMissile( muzzle1, muzzle_dir, BOWCASTER_VELOCITY, 10000, NPCS.NPC, qfalse );
 
-	missile->classname = "bowcaster_proj";
+	G_SetClassname( missile, "bowcaster_proj" );
 	missile->s.weapon = WP_BOWCASTER;
 
 	VectorSet( missile->r.maxs, BOWCASTER_SIZE, BOWCASTER_SIZE, BOWCASTER_SIZE );
@@ -209,7 +209,7 @@ void Mark1Dead_FireBlaster (void)
 
 	G_Sound( NPCS.NPC, CHAN_AUTO, G_SoundIndex("sound/chars/mark1/misc/mark1_fire"));
 
-	missile->classname = "bryar_proj";
+	G_SetClassname( missile, "bryar_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	missile->damage = 1;
@@ -495,7 +495,7 @@ void Mark1_FireBlaster(void)
 
 	missile = CreateMissile( muzzle1, forward, 1600, 10000, NPCS.NPC, qfalse );
 
-	missile->classname = "bryar_proj";
+	G_SetClassname( missile, "bryar_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	missile->damage = 1;
@@ -598,7 +598,7 @@ void Mark1_FireRocket(void)
 
 	missile = CreateMissile( muzzle1, forward, BOWCASTER_VELOCITY, 10000, NPCS.NPC, qfalse );
 
-	missile->classname = "bowcaster_proj";
+	G_SetClassname( missile, "bowcaster_proj" );
 	missile->s.weapon = WP_BOWCASTER;
 
 	VectorSet( missile->r.maxs, BOWCASTER_SIZE, BOWCASTER_SIZE, BOWCASTER_SIZE );
@@ -268,7 +268,7 @@ void Remote_Fire (void)
 
 	G_PlayEffectID( G_EffectIndex("bryar/muzzle_flash"), NPCS.NPC->r.currentOrigin, forward );
 
-	missile->classname = "briar";
+	G_SetClassname( missile, "briar" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	missile->damage = 10;
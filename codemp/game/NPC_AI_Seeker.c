@@ -325,7 +325,7 @@ void Seeker_Fire( void )
 
 	G_PlayEffectID( G_EffectIndex("blaster/muzzle_flash"), NPCS.NPC->r.currentOrigin, dir );
 
-	missile->classname = "blaster";
+	G_SetClassname( missile, "blaster" );
 	missile->s.weapon = WP_BLASTER;
 
 	missile->damage = 5;
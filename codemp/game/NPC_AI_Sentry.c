@@ -197,7 +197,7 @@ void Sentry_Fire (void)
 
 	missile = CreateMissile( muzzle, forward, 1600, 10000, NPCS.NPC, qfalse );
 
-	missile->classname = "bryar_proj";
+	G_SetClassname( missile, "bryar_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	missile->dflags = DAMAGE_DEATH_KNOCKBACK;
@@ -949,7 +949,7 @@ void NPC_BSRemove (void)
 		NPCS.NPC->s.eType = ET_INVISIBLE;
 		NPCS.NPC->r.contents = 0;
 		NPCS.NPC->health = 0;
-		NPCS.NPC->targetname = NULL;
+		G_SetTargetname( NPCS.NPC, NULL );
 
 		//Disappear in half a second
 		NPCS.NPC->think = G_FreeEntity;
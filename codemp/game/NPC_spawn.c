@@ -995,7 +995,7 @@ void NPC_Begin (gentity_t *ent)
 	ent->mass = 10;
 	ent->takedamage = qtrue;
 	ent->inuse = qtrue;
-	ent->classname = "NPC";
+	G_SetClassname( ent, "NPC" );
 //	if ( ent->client->race == RACE_HOLOGRAM )
 //	{//can shoot through holograms, but not walk through them
 //		ent->contents = CONTENTS_PLAYERCLIP|CONTENTS_MONSTERCLIP|CONTENTS_ITEM;//contents_corspe to make them show up in ID and use traces
@@ -1429,7 +1429,7 @@ gentity_t *NPC_Spawn_Do( gentity_t *ent )
 	//	return NULL;
 	}
 
-	newent->NPC->tempGoal->classname = "NPC_goal";
+	G_SetClassname( newent->NPC->tempGoal, "NPC_goal" );
 	newent->NPC->tempGoal->parent = newent;
 	newent->NPC->tempGoal->r.svFlags |= SVF_NOCLIENT;
 
@@ -1602,7 +1602,7 @@ gentity_t *NPC_Spawn_Do( gentity_t *ent )
 				}
 			}
 			newent->NPC->defaultBehavior = newent->NPC->behaviorState = BS_WAIT;
-			newent->classname = "NPC";
+			G_SetClassname( newent, "NPC" );
 	//		newent->r.svFlags |= SVF_NOPUSH;
 		}
 	}
@@ -1613,7 +1613,7 @@ gentity_t *NPC_Spawn_Do( gentity_t *ent )
 		newent->health = ent->health;
 	}
 	newent->script_targetname = ent->NPC_targetname;
-	newent->targetname = ent->NPC_targetname;
+	G_SetTargetname( newent, ent->NPC_targetname );
 	newent->target = ent->NPC_target;//death
 	newent->target2 = ent->target2;//knocked out death
 	newent->target3 = ent->target3;//???
@@ -1628,7 +1628,7 @@ gentity_t *NPC_Spawn_Do( gentity_t *ent )
 		}
 	}
 
-	newent->classname = "NPC";
+	G_SetClassname( newent, "NPC" );
 	newent->NPC_type = ent->NPC_type;
 	trap->UnlinkEntity((sharedEntity_t *)newent);
 
@@ -1731,7 +1731,7 @@ gentity_t *NPC_Spawn_Do( gentity_t *ent )
 		{//last guy should fire this target when he dies
 			newent->target = ent->closetarget;
 		}
-		ent->targetname = NULL;
+		G_SetTargetname( ent, NULL );
 		//why not remove me...?  Because of all the string pointers?  Just do G_NewStrings?
 		G_FreeEntity( ent );//bye!
 	}
@@ -2178,7 +2178,7 @@ void SP_NPC_Vehicle( gentity_t *self)
 
 	if ( !self->classname )
 	{
-		self->classname = "NPC_Vehicle";
+		G_SetClassname( self, "NPC_Vehicle" );
 	}
 
 	if ( !self->wait )
@@ -4018,7 +4018,7 @@ gentity_t *NPC_SpawnType( gentity_t *ent, char *npc_type, char *targetname, qboo
 
 	if ( isVehicle )
 	{
-		NPCspawner->classname = "NPC_Vehicle";
+		G_SetClassname( NPCspawner, "NPC_Vehicle" );
 	}
 
 	//call precache funcs for James' builds
@@ -1105,7 +1105,7 @@ void Q3_RemoveEnt( gentity_t *victim )
 		victim->s.eType = ET_INVISIBLE;
 		victim->contents = 0;
 		victim->health = 0;
-		victim->targetname = NULL;
+		G_SetTargetname( victim, NULL );
 
 		if ( victim->NPC && victim->NPC->tempGoal != NULL )
 		{
@@ -3788,11 +3788,11 @@ static void Q3_SetTargetName (int entID, const char *targetname)
 
 	if(!Q_stricmp("NULL", ((char *)targetname)))
 	{
-		self->targetname = NULL;
+		G_SetTargetname( self, NULL );
 	}
 	else
 	{
-		self->targetname = G_NewString( targetname );
+		G_SetTargetname( self, G_NewString( targetname ) );
 	}
 }
 
@@ -125,7 +125,7 @@ Targets will be fired when someone spawns in on them.
 equivelant to info_player_deathmatch
 */
 void SP_info_player_start(gentity_t *ent) {
-	ent->classname = "info_player_deathmatch";
+	G_SetClassname( ent, "info_player_deathmatch" );
 	SP_info_player_deathmatch( ent );
 }
 
@@ -188,7 +188,7 @@ void SP_info_player_siegeteam1(gentity_t *ent) {
 
 	if (level.gametype != GT_SIEGE)
 	{ //turn into a DM spawn if not in siege game mode
-		ent->classname = "info_player_deathmatch";
+		G_SetClassname( ent, "info_player_deathmatch" );
 		SP_info_player_deathmatch( ent );
 
 		return;
@@ -224,7 +224,7 @@ void SP_info_player_siegeteam2(gentity_t *ent) {
 
 	if (level.gametype != GT_SIEGE)
 	{ //turn into a DM spawn if not in siege game mode
-		ent->classname = "info_player_deathmatch";
+		G_SetClassname( ent, "info_player_deathmatch" );
 		SP_info_player_deathmatch( ent );
 
 		return;
@@ -1012,7 +1012,7 @@ void InitBodyQue (void) {
 	level.bodyQueIndex = 0;
 	for (i=0; i<BODY_QUEUE_SIZE ; i++) {
 		ent = G_Spawn();
-		ent->classname = "bodyque";
+		G_SetClassname( ent, "bodyque" );
 		ent->neverFree = qtrue;
 		level.bodyQue[i] = ent;
 	}
@@ -2421,7 +2421,7 @@ char *ClientConnect( int clientNum, qboolean firstTime, qboolean isBot ) {
 	ent = &g_entities[ clientNum ];
 
 	ent->s.number = clientNum;
-	ent->classname = "connecting";
+	G_SetClassname( ent, "connecting" );
 
 	trap->GetUserinfo( clientNum, userinfo, sizeof( userinfo ) );
 
@@ -3363,7 +3363,7 @@ void ClientSpawn(gentity_t *ent) {
 	ent->playerState = &ent->client->ps;
 	ent->takedamage = qtrue;
 	ent->inuse = qtrue;
-	ent->classname = "player";
+	G_SetClassname( ent, "player" );
 	ent->r.contents = CONTENTS_BODY;
 	ent->clipmask = MASK_PLAYERSOLID;
 	ent->die = player_die;
@@ -4007,7 +4007,7 @@ void ClientDisconnect( int clientNum ) {
 	trap->UnlinkEntity ((sharedEntity_t *)ent);
 	ent->s.modelindex = 0;
 	ent->inuse = qfalse;
-	ent->classname = "disconnected";
+	G_SetClassname( ent, "disconnected" );
 	ent->client->pers.connected = CON_DISCONNECTED;
 	ent->client->ps.persistant[PERS_TEAM] = TEAM_FREE;
 	ent->client->sess.sessionTeam = TEAM_FREE;
@@ -174,6 +174,13 @@ extern void *g2SaberInstance;
 extern qboolean gEscaping;
 extern int gEscapeTime;
 
+// fields G_Find looks up through a hash index instead of a scan, see g_utils.c
+typedef enum {
+	FINDKEY_CLASSNAME,
+	FINDKEY_TARGETNAME,
+	NUM_FINDKEYS
+} findKey_t;
+
 struct gentity_s {
 	//rww - entstate must be first, to correspond with the bg shared entity structure
 	entityState_t	s;				// communicated by server to clients
@@ -404,6 +411,11 @@ struct gentity_s {
 
 	// OpenJK add
 	int			useDebounceTime;	// for cultist_destroyer
+
+	// G_Find index
+	char		*findKey[NUM_FINDKEYS];		// value the entity is indexed under, NULL if not indexed
+	gentity_t	*findNext[NUM_FINDKEYS];
+	gentity_t	*findPrev[NUM_FINDKEYS];
 };
 
 #define DAMAGEREDIRECT_HEAD		1
@@ -1085,6 +1097,10 @@ qboolean	G_PlayerHasCustomSkeleton(gentity_t *ent);
 void	G_TeamCommand( team_t team, char *cmd );
 void	G_ScaleNetHealth(gentity_t *self);
 void	G_KillBox (gentity_t *ent);
+void	G_ClearFindIndex( void );
+void	G_UpdateFindIndex( gentity_t *ent );
+void	G_SetClassname( gentity_t *ent, const char *classname );
+void	G_SetTargetname( gentity_t *ent, const char *targetname );
 gentity_t *G_Find (gentity_t *from, int fieldofs, const char *match);
 int		G_RadiusList ( vec3_t origin, float radius,	gentity_t *ignore, qboolean takeDamage, gentity_t *ent_list[MAX_GENTITIES]);
 
@@ -117,8 +117,8 @@ void G_FindTeams( void ) {
 
 				// make sure that targets only point at the master
 				if ( e2->targetname ) {
-					e->targetname = e2->targetname;
-					e2->targetname = NULL;
+					G_SetTargetname( e, e2->targetname );
+					G_SetTargetname( e2, NULL );
 				}
 			}
 		}
@@ -268,6 +268,7 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 	// initialize all entities for this game
 	memset( g_entities, 0, MAX_GENTITIES * sizeof(g_entities[0]) );
 	level.gentities = g_entities;
+	G_ClearFindIndex();
 
 	// initialize all clients for this game
 	level.maxclients = sv_maxclients.integer;
@@ -285,7 +286,7 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 	level.num_entities = MAX_CLIENTS;
 
 	for ( i=0 ; i<MAX_CLIENTS ; i++ ) {
-		g_entities[i].classname = "clientslot";
+		G_SetClassname( &g_entities[i], "clientslot" );
 	}
 
 	// let the server system know where the entites are
@@ -2898,6 +2899,38 @@ int BG_GetTime(void)
 	return level.time;
 }
 
+/*
+================
+G_ConstructSkeletons
+
+Every client and NPC skeleton is out of date once the time moves on. Hand them
+to the engine together, so the bolt lookups and Ghoul2 traces of the frame find
+them built instead of building them one at a time as they come up
+================
+*/
+static void G_ConstructSkeletons( void ) {
+	static void		*ghoul2[MAX_GENTITIES];
+	static vec3_t	scales[MAX_GENTITIES];
+	gentity_t		*ent;
+	int				i, count = 0;
+
+	for ( i = 0, ent = g_entities; i < level.num_entities; i++, ent++ ) {
+		if ( !ent->inuse || !ent->client || !ent->ghoul2 ) {
+			continue;
+		}
+		if ( i >= MAX_CLIENTS && ent->s.eType != ET_NPC ) {
+			continue;
+		}
+		ghoul2[count] = ent->ghoul2;
+		VectorCopy( ent->modelScale, scales[count] );
+		count++;
+	}
+
+	if ( count ) {
+		trap->G2API_ConstructGhoulSkeletons( ghoul2, scales, count, level.time );
+	}
+}
+
 /*
 ================
 G_RunFrame
@@ -3063,6 +3096,9 @@ void G_RunFrame( int levelTime ) {
 	// get any cvar changes
 	G_UpdateCvars();
 
+	// build the client and NPC skeletons up front, on the worker threads if there are any
+	G_ConstructSkeletons();
+
 
 
 #ifdef _G_FRAME_PERFANAL
@@ -2141,7 +2141,7 @@ gentity_t *CreateNewDamageBox( gentity_t *ent )
 	//We do not want the client to have any real knowledge of the entity whatsoever. It will only
 	//ever be used on the server.
 	dmgBox = G_Spawn();
-	dmgBox->classname = "dmg_box";
+	G_SetClassname( dmgBox, "dmg_box" );
 
 	dmgBox->r.svFlags = SVF_USE_CURRENT_ORIGIN;
 	dmgBox->r.ownerNum = ent->s.number;
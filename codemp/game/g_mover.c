@@ -866,7 +866,7 @@ void UnLockDoors(gentity_t *const ent)
 	{	// want to allow locked toggle doors, so keep the targetname
 		if( !(slave->spawnflags & MOVER_TOGGLE) )
 		{
-			slave->targetname = NULL;//not usable ever again
+			G_SetTargetname( slave, NULL );//not usable ever again
 		}
 		slave->spawnflags &= ~MOVER_LOCKED;
 		slave->s.frame = 1;//second stage of anim
@@ -1241,7 +1241,7 @@ void Think_SpawnNewDoorTrigger( gentity_t *ent )
 	other->r.contents = CONTENTS_TRIGGER;
 	other->touch = Touch_DoorTrigger;
 	trap->LinkEntity ((sharedEntity_t *)other);
-	other->classname = "trigger_door";
+	G_SetClassname( other, "trigger_door" );
 	// remember the thinnest axis
 	other->count = best;
 
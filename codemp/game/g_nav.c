@@ -1309,7 +1309,7 @@ void SP_waypoint ( gentity_t *ent )
 		trap->LinkEntity( (sharedEntity_t *)ent );
 
 		ent->count = -1;
-		ent->classname = "waypoint";
+		G_SetClassname( ent, "waypoint" );
 
 		if( !(ent->spawnflags&1) && G_CheckInSolid (ent, qtrue))
 		{//if not SOLID_OK, and in solid
@@ -1350,7 +1350,7 @@ void SP_waypoint_small (gentity_t *ent)
 		trap->LinkEntity( (sharedEntity_t *)ent );
 
 		ent->count = -1;
-		ent->classname = "waypoint";
+		G_SetClassname( ent, "waypoint" );
 
 		if ( !(ent->spawnflags&1) && G_CheckInSolid( ent, qtrue ) )
 		{
@@ -1403,7 +1403,7 @@ void SP_waypoint_navgoal( gentity_t *ent )
 	}
 	TAG_Add( ent->targetname, NULL, ent->s.origin, ent->s.angles, radius, RTF_NAVGOAL );
 
-	ent->classname = "navgoal";
+	G_SetClassname( ent, "navgoal" );
 	G_FreeEntity( ent );//can't do this, they need to be found later by some functions, though those could be fixed, maybe?
 }
 
@@ -1434,7 +1434,7 @@ void SP_waypoint_navgoal_8( gentity_t *ent )
 
 	TAG_Add( ent->targetname, NULL, ent->s.origin, ent->s.angles, 8, RTF_NAVGOAL );
 
-	ent->classname = "navgoal";
+	G_SetClassname( ent, "navgoal" );
 	G_FreeEntity( ent );//can't do this, they need to be found later by some functions, though those could be fixed, maybe?
 }
 
@@ -1465,7 +1465,7 @@ void SP_waypoint_navgoal_4( gentity_t *ent )
 
 	TAG_Add( ent->targetname, NULL, ent->s.origin, ent->s.angles, 4, RTF_NAVGOAL );
 
-	ent->classname = "navgoal";
+	G_SetClassname( ent, "navgoal" );
 	G_FreeEntity( ent );//can't do this, they need to be found later by some functions, though those could be fixed, maybe?
 }
 
@@ -1496,7 +1496,7 @@ void SP_waypoint_navgoal_2( gentity_t *ent )
 
 	TAG_Add( ent->targetname, NULL, ent->s.origin, ent->s.angles, 2, RTF_NAVGOAL );
 
-	ent->classname = "navgoal";
+	G_SetClassname( ent, "navgoal" );
 	G_FreeEntity( ent );//can't do this, they need to be found later by some functions, though those could be fixed, maybe?
 }
 
@@ -1527,7 +1527,7 @@ void SP_waypoint_navgoal_1( gentity_t *ent )
 
 	TAG_Add( ent->targetname, NULL, ent->s.origin, ent->s.angles, 1, RTF_NAVGOAL );
 
-	ent->classname = "navgoal";
+	G_SetClassname( ent, "navgoal" );
 	G_FreeEntity( ent );//can't do this, they need to be found later by some functions, though those could be fixed, maybe?
 }
 
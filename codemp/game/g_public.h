@@ -29,7 +29,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #define Q3_INFINITE			16777216
 
-#define	GAME_API_VERSION	1
+#define	GAME_API_VERSION	3
 
 // entity->svFlags
 // the server does not know how to interpret most of the values
@@ -711,7 +711,9 @@ typedef enum gameImportLegacy_e {
 	G_CM_REGISTER_TERRAIN,
 	G_RMG_INIT,
 	G_BOT_UPDATEWAYPOINTS,
-	G_BOT_CALCULATEPATHS
+	G_BOT_CALCULATEPATHS,
+	G_TRACEBATCH,
+	G_G2_CONSTRUCTGHOULSKELETONS
 } gameImportLegacy_t;
 
 typedef enum gameExportLegacy_e {
@@ -757,6 +759,18 @@ typedef enum gameExportLegacy_e {
 	GAME_GETITEMINDEXBYTAG
 } gameExportLegacy_t;
 
+// one trace for TraceBatch, same parameters as Trace
+typedef struct traceRequest_s {
+	vec3_t		start;
+	vec3_t		mins, maxs;
+	vec3_t		end;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;
+	int			traceFlags;
+	int			useLod;
+} traceRequest_t;
+
 typedef struct gameImport_s {
 	// misc
 	void		(*Print)								( const char *msg, ... );
@@ -1093,6 +1107,13 @@ typedef struct gameImport_s {
 	void		(*G2API_CleanEntAttachments)			( void );
 	qboolean	(*G2API_OverrideServer)					( void *serverInstance );
 	void		(*G2API_GetSurfaceName)					( void *ghoul2, int surfNumber, int modelIndex, char *fillBuf );
+
+	// same as calling Trace for each request, but cheaper for many traces in one place
+	void		(*TraceBatch)							( trace_t *results, const traceRequest_t *requests, int count );
+
+	// builds the skeletons the frame's GetBoltMatrix and CollisionDetect calls will need, all at once and
+	// on the worker threads if there are any. Only a head start, results are the same without it
+	void		(*G2API_ConstructGhoulSkeletons)		( void **ghoul2, vec3_t *scales, int count, int frameNum );
 } gameImport_t;
 
 typedef struct gameExport_s {
@@ -484,8 +484,8 @@ void SP_gametype_item ( gentity_t* ent )
 
 		if (item)
 		{
-			ent->targetname = NULL;
-			ent->classname = item->classname;
+			G_SetTargetname( ent, NULL );
+			G_SetClassname( ent, item->classname );
 			G_SpawnItem( ent, item );
 		}
 	}
@@ -824,6 +824,7 @@ void G_ParseField( const char *key, const char *value, gentity_t *ent )
 		switch( f->type ) {
 		case F_STRING:
 			*(char **)(b+f->ofs) = G_NewString (value);
+			G_UpdateFindIndex( ent );
 			break;
 		case F_VECTOR:
 			if ( sscanf( value, "%f %f %f", &vec[0], &vec[1], &vec[2] ) == 3 ) {
@@ -1469,11 +1470,11 @@ void SP_worldspawn( void )
 
 	g_entities[ENTITYNUM_WORLD].s.number = ENTITYNUM_WORLD;
 	g_entities[ENTITYNUM_WORLD].r.ownerNum = ENTITYNUM_NONE;
-	g_entities[ENTITYNUM_WORLD].classname = "worldspawn";
+	G_SetClassname( &g_entities[ENTITYNUM_WORLD], "worldspawn" );
 
 	g_entities[ENTITYNUM_NONE].s.number = ENTITYNUM_NONE;
 	g_entities[ENTITYNUM_NONE].r.ownerNum = ENTITYNUM_NONE;
-	g_entities[ENTITYNUM_NONE].classname = "nothing";
+	G_SetClassname( &g_entities[ENTITYNUM_NONE], "nothing" );
 
 	// see if we want a warmup time
 	trap->SetConfigstring( CS_WARMUP, "" );
@@ -993,6 +993,12 @@ void trap_Bot_UpdateWaypoints(int wpnum, wpobject_t **wps) {
 void trap_Bot_CalculatePaths(int rmg) {
 	Q_syscall(G_BOT_CALCULATEPATHS, rmg);
 }
+void trap_TraceBatch( trace_t *results, const traceRequest_t *requests, int count ) {
+	Q_syscall( G_TRACEBATCH, results, requests, count );
+}
+void trap_G2API_ConstructGhoulSkeletons( void **ghoul2, vec3_t *scales, int count, int frameNum ) {
+	Q_syscall( G_G2_CONSTRUCTGHOULSKELETONS, ghoul2, scales, count, frameNum );
+}
 
 
 // Translate import table funcptrs to syscalls
@@ -1354,4 +1360,6 @@ static void TranslateSyscalls( void ) {
 	trap->G2API_CleanEntAttachments			= trap_G2API_CleanEntAttachments;
 	trap->G2API_OverrideServer				= trap_G2API_OverrideServer;
 	trap->G2API_GetSurfaceName				= trap_G2API_GetSurfaceName;
+	trap->TraceBatch						= trap_TraceBatch;
+	trap->G2API_ConstructGhoulSkeletons		= trap_G2API_ConstructGhoulSkeletons;
 }
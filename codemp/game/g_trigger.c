@@ -1902,7 +1902,7 @@ void asteroid_field_think(gentity_t *self)
 
 				G_SetOrigin( newAsteroid, copyAsteroid->s.origin );
 				G_SetAngles( newAsteroid, copyAsteroid->s.angles );
-				newAsteroid->classname = "func_rotating";
+				G_SetClassname( newAsteroid, "func_rotating" );
 
 				SP_func_rotating( newAsteroid );
 
@@ -168,7 +168,7 @@ static void turret_fire ( gentity_t *ent, vec3_t start, vec3_t dir )
 	//use a custom impact effect
 	bolt->s.emplacedOwner = ent->genericValue15;
 
-	bolt->classname = "turret_proj";
+	G_SetClassname( bolt, "turret_proj" );
 	bolt->nextthink = level.time + 10000;
 	bolt->think = G_FreeEntity;
 	bolt->s.eType = ET_MISSILE;
@@ -392,7 +392,7 @@ static void turretG2_fire ( gentity_t *ent, vec3_t start, vec3_t dir )
 		G_PlayEffectID( G_EffectIndex("blaster/muzzle_flash"), org, ang );
 		bolt = G_Spawn();
 
-		bolt->classname = "turret_proj";
+		G_SetClassname( bolt, "turret_proj" );
 		bolt->nextthink = level.time + 10000;
 		bolt->think = G_FreeEntity;
 		bolt->s.eType = ET_MISSILE;
@@ -228,6 +228,140 @@ void G_TeamCommand( team_t team, char *cmd ) {
 }
 
 
+/*
+=============
+G_Find index
+
+Entities are hashed on classname and targetname, with each chain kept in
+entity number order so G_Find returns the same entity a full scan would.
+Anything that changes either field has to go through G_SetClassname or
+G_SetTargetname, or call G_UpdateFindIndex after writing it.
+=============
+*/
+
+#define FIND_HASH_SIZE	1024
+
+static gentity_t	*findHash[NUM_FINDKEYS][FIND_HASH_SIZE];
+
+static int G_FindHashValue( const char *name ) {
+	int		i;
+	int		hash;
+
+	hash = 0;
+	for ( i = 0 ; name[i] ; i++ ) {
+		hash += tolower( (unsigned char)name[i] ) * ( i + 119 );
+	}
+	return hash & ( FIND_HASH_SIZE - 1 );
+}
+
+static char *G_FindKeyField( gentity_t *ent, int key ) {
+	return key == FINDKEY_CLASSNAME ? ent->classname : ent->targetname;
+}
+
+static void G_UnlinkFindKey( gentity_t *ent, int key ) {
+	if ( !ent->findKey[key] ) {
+		return;
+	}
+
+	if ( ent->findPrev[key] ) {
+		ent->findPrev[key]->findNext[key] = ent->findNext[key];
+	} else {
+		findHash[key][G_FindHashValue( ent->findKey[key] )] = ent->findNext[key];
+	}
+	if ( ent->findNext[key] ) {
+		ent->findNext[key]->findPrev[key] = ent->findPrev[key];
+	}
+
+	ent->findKey[key] = NULL;
+	ent->findNext[key] = ent->findPrev[key] = NULL;
+}
+
+static void G_LinkFindKey( gentity_t *ent, int key ) {
+	char		*value = G_FindKeyField( ent, key );
+	gentity_t	**link, *prev;
+
+	if ( !value ) {
+		return;
+	}
+
+	prev = NULL;
+	link = &findHash[key][G_FindHashValue( value )];
+	while ( *link && *link < ent ) {
+		prev = *link;
+		link = &prev->findNext[key];
+	}
+
+	ent->findKey[key] = value;
+	ent->findPrev[key] = prev;
+	ent->findNext[key] = *link;
+	if ( *link ) {
+		(*link)->findPrev[key] = ent;
+	}
+	*link = ent;
+}
+
+static void G_UnlinkFindKeys( gentity_t *ent ) {
+	int		key;
+
+	for ( key = 0 ; key < NUM_FINDKEYS ; key++ ) {
+		G_UnlinkFindKey( ent, key );
+	}
+}
+
+void G_ClearFindIndex( void ) {
+	memset( findHash, 0, sizeof( findHash ) );
+}
+
+/*
+=============
+G_UpdateFindIndex
+
+Rehashes whichever of the indexed fields changed since the entity was last indexed
+=============
+*/
+void G_UpdateFindIndex( gentity_t *ent ) {
+	int		key;
+
+	for ( key = 0 ; key < NUM_FINDKEYS ; key++ ) {
+		if ( ent->findKey[key] != G_FindKeyField( ent, key ) ) {
+			G_UnlinkFindKey( ent, key );
+			G_LinkFindKey( ent, key );
+		}
+	}
+}
+
+void G_SetClassname( gentity_t *ent, const char *classname ) {
+	ent->classname = (char *)classname;
+	G_UpdateFindIndex( ent );
+}
+
+void G_SetTargetname( gentity_t *ent, const char *targetname ) {
+	ent->targetname = (char *)targetname;
+	G_UpdateFindIndex( ent );
+}
+
+static gentity_t *G_FindIndexed( gentity_t *from, int key, const char *match ) {
+	gentity_t	*ent;
+
+	if ( from && from->findKey[key] && !Q_stricmp( from->findKey[key], match ) ) {
+		// carrying on from the last match, which sits in the same chain
+		ent = from->findNext[key];
+	} else {
+		ent = findHash[key][G_FindHashValue( match )];
+		while ( from && ent && ent <= from ) {
+			ent = ent->findNext[key];
+		}
+	}
+
+	for ( ; ent && ent < &g_entities[level.num_entities] ; ent = ent->findNext[key] ) {
+		if ( ent->inuse && !Q_stricmp( ent->findKey[key], match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
 /*
 =============
 G_Find
@@ -244,6 +378,13 @@ gentity_t *G_Find (gentity_t *from, int fieldofs, const char *match)
 {
 	char	*s;
 
+	if ( match && fieldofs == FOFS(classname) ) {
+		return G_FindIndexed( from, FINDKEY_CLASSNAME, match );
+	}
+	if ( match && fieldofs == FOFS(targetname) ) {
+		return G_FindIndexed( from, FINDKEY_TARGETNAME, match );
+	}
+
 	if (!from)
 		from = g_entities;
 	else
@@ -702,7 +843,7 @@ void G_SetMovedir( vec3_t angles, vec3_t movedir ) {
 
 void G_InitGentity( gentity_t *e ) {
 	e->inuse = qtrue;
-	e->classname = "noclass";
+	G_SetClassname( e, "noclass" );
 	e->s.number = e - g_entities;
 	e->r.ownerNum = ENTITYNUM_NONE;
 	e->s.modelGhoul2 = 0; //assume not
@@ -1040,8 +1181,9 @@ void G_FreeEntity( gentity_t *ed ) {
 		trap->SendServerCommand(-1, va("kls %i %i", ed->s.trickedentindex, ed->s.number));
 	}
 
+	G_UnlinkFindKeys( ed );
 	memset (ed, 0, sizeof(*ed));
-	ed->classname = "freed";
+	ed->classname = "freed";	// freed entities stay out of the G_Find index
 	ed->freetime = level.time;
 	ed->inuse = qfalse;
 }
@@ -1062,7 +1204,7 @@ gentity_t *G_TempEntity( vec3_t origin, int event ) {
 	e = G_Spawn();
 	e->s.eType = ET_EVENTS + event;
 
-	e->classname = "tempEntity";
+	G_SetClassname( e, "tempEntity" );
 	e->eventTime = level.time;
 	e->freeAfterEvent = qtrue;
 
@@ -1097,7 +1239,7 @@ gentity_t *G_SoundTempEntity( vec3_t origin, int event, int channel ) {
 	e->s.eType = ET_EVENTS + event;
 	e->inuse = qtrue;
 
-	e->classname = "tempEntity";
+	G_SetClassname( e, "tempEntity" );
 	e->eventTime = level.time;
 	e->freeAfterEvent = qtrue;
 
@@ -259,7 +259,7 @@ static void WP_FireBryarPistol( gentity_t *ent, qboolean altFire )
 
 	gentity_t	*missile = CreateMissile( muzzle, forward, BRYAR_PISTOL_VEL, 10000, ent, altFire );
 
-	missile->classname = "bryar_proj";
+	G_SetClassname( missile, "bryar_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	if ( altFire )
@@ -326,7 +326,7 @@ void WP_FireTurretMissile( gentity_t *ent, vec3_t start, vec3_t dir, qboolean al
 
 	missile = CreateMissile( start, dir, velocity, 10000, ent, altFire );
 
-	missile->classname = "generic_proj";
+	G_SetClassname( missile, "generic_proj" );
 	missile->s.weapon = WP_TURRET;
 
 	missile->damage = damage;
@@ -406,7 +406,7 @@ void WP_FireGenericBlasterMissile( gentity_t *ent, vec3_t start, vec3_t dir, qbo
 
 	missile = CreateMissile( start, dir, velocity, 10000, ent, altFire );
 
-	missile->classname = "generic_proj";
+	G_SetClassname( missile, "generic_proj" );
 	missile->s.weapon = WP_BRYAR_PISTOL;
 
 	missile->damage = damage;
@@ -441,7 +441,7 @@ void WP_FireBlasterMissile( gentity_t *ent, vec3_t start, vec3_t dir, qboolean a
 
 	missile = CreateMissile( start, dir, velocity, 10000, ent, altFire );
 
-	missile->classname = "blaster_proj";
+	G_SetClassname( missile, "blaster_proj" );
 	missile->s.weapon = WP_BLASTER;
 
 	missile->damage = damage;
@@ -467,7 +467,7 @@ void WP_FireTurboLaserMissile( gentity_t *ent, vec3_t start, vec3_t dir )
 	//use a custom impact effect
 	missile->s.emplacedOwner = ent->genericValue15;
 
-	missile->classname = "turbo_proj";
+	G_SetClassname( missile, "turbo_proj" );
 	missile->s.weapon = WP_TURRET;
 
 	missile->damage = ent->damage;		//FIXME: externalize
@@ -499,7 +499,7 @@ void WP_FireEmplacedMissile( gentity_t *ent, vec3_t start, vec3_t dir, qboolean
 
 	missile = CreateMissile( start, dir, velocity, 10000, ent, altFire );
 
-	missile->classname = "emplaced_gun_proj";
+	G_SetClassname( missile, "emplaced_gun_proj" );
 	missile->s.weapon = WP_TURRET;//WP_EMPLACED_GUN;
 
 	missile->activator = ignore;
@@ -1009,7 +1009,7 @@ static void WP_BowcasterAltFire( gentity_t *ent )
 
 	gentity_t *missile = CreateMissile( muzzle, forward, BOWCASTER_VELOCITY, 10000, ent, qfalse);
 
-	missile->classname = "bowcaster_proj";
+	G_SetClassname( missile, "bowcaster_proj" );
 	missile->s.weapon = WP_BOWCASTER;
 
 	VectorSet( missile->r.maxs, BOWCASTER_SIZE, BOWCASTER_SIZE, BOWCASTER_SIZE );
@@ -1095,7 +1095,7 @@ static void WP_BowcasterMainFire( gentity_t *ent )
 
 		missile = CreateMissile( muzzle, dir, vel, 10000, ent, qtrue );
 
-		missile->classname = "bowcaster_alt_proj";
+		G_SetClassname( missile, "bowcaster_alt_proj" );
 		missile->s.weapon = WP_BOWCASTER;
 
 		VectorSet( missile->r.maxs, BOWCASTER_SIZE, BOWCASTER_SIZE, BOWCASTER_SIZE );
@@ -1143,7 +1143,7 @@ static void WP_RepeaterMainFire( gentity_t *ent, vec3_t dir )
 
 	gentity_t *missile = CreateMissile( muzzle, dir, REPEATER_VELOCITY, 10000, ent, qfalse );
 
-	missile->classname = "repeater_proj";
+	G_SetClassname( missile, "repeater_proj" );
 	missile->s.weapon = WP_REPEATER;
 
 	missile->damage = damage;
@@ -1163,7 +1163,7 @@ static void WP_RepeaterAltFire( gentity_t *ent )
 
 	gentity_t *missile = CreateMissile( muzzle, forward, REPEATER_ALT_VELOCITY, 10000, ent, qtrue );
 
-	missile->classname = "repeater_alt_proj";
+	G_SetClassname( missile, "repeater_alt_proj" );
 	missile->s.weapon = WP_REPEATER;
 
 	VectorSet( missile->r.maxs, REPEATER_ALT_SIZE, REPEATER_ALT_SIZE, REPEATER_ALT_SIZE );
@@ -1228,7 +1228,7 @@ static void WP_DEMP2_MainFire( gentity_t *ent )
 
 	gentity_t *missile = CreateMissile( muzzle, forward, DEMP2_VELOCITY, 10000, ent, qfalse);
 
-	missile->classname = "demp2_proj";
+	G_SetClassname( missile, "demp2_proj" );
 	missile->s.weapon = WP_DEMP2;
 
 	VectorSet( missile->r.maxs, DEMP2_SIZE, DEMP2_SIZE, DEMP2_SIZE );
@@ -1466,7 +1466,7 @@ static void WP_DEMP2_AltFire( gentity_t *ent )
 
 	missile->count = count;
 
-	missile->classname = "demp2_alt_proj";
+	G_SetClassname( missile, "demp2_alt_proj" );
 	missile->s.weapon = WP_DEMP2;
 
 	missile->think = DEMP2_AltDetonate;
@@ -1531,7 +1531,7 @@ static void WP_FlechetteMainFire( gentity_t *ent )
 
 		missile = CreateMissile( muzzle, fwd, FLECHETTE_VEL, 10000, ent, qfalse);
 
-		missile->classname = "flech_proj";
+		G_SetClassname( missile, "flech_proj" );
 		missile->s.weapon = WP_FLECHETTE;
 
 		VectorSet( missile->r.maxs, FLECHETTE_SIZE, FLECHETTE_SIZE, FLECHETTE_SIZE );
@@ -1650,7 +1650,7 @@ static void WP_CreateFlechetteBouncyThing( vec3_t start, vec3_t fwd, gentity_t *
 	missile->activator = self;
 
 	missile->s.weapon = WP_FLECHETTE;
-	missile->classname = "flech_alt";
+	G_SetClassname( missile, "flech_alt" );
 	missile->mass = 4;
 
 	// How 'bout we give this thing a size...
@@ -1956,7 +1956,7 @@ static void WP_FireRocket( gentity_t *ent, qboolean altFire )
 		ent->client->ps.rocketTargetTime = 0;
 	}
 
-	missile->classname = "rocket_proj";
+	G_SetClassname( missile, "rocket_proj" );
 	missile->s.weapon = WP_ROCKET_LAUNCHER;
 
 	// Make it easier to hit things
@@ -2080,7 +2080,7 @@ gentity_t *WP_FireThermalDetonator( gentity_t *ent, qboolean altFire )
 
 	bolt->physicsObject = qtrue;
 
-	bolt->classname = "thermal_detonator";
+	G_SetClassname( bolt, "thermal_detonator" );
 	bolt->think = thermalThinkStandard;
 	bolt->nextthink = level.time;
 	bolt->touch = touch_NULL;
@@ -2559,7 +2559,7 @@ void TrapThink(gentity_t *ent)
 
 void CreateLaserTrap( gentity_t *laserTrap, vec3_t start, gentity_t *owner )
 { //create a laser trap entity
-	laserTrap->classname = "laserTrap";
+	G_SetClassname( laserTrap, "laserTrap" );
 	laserTrap->flags |= FL_BOUNCE_HALF;
 	laserTrap->s.eFlags |= EF_MISSILE_STICK;
 	laserTrap->splashDamage = LT_SPLASH_DAM;
@@ -2881,7 +2881,7 @@ void drop_charge (gentity_t *self, vec3_t start, vec3_t dir)
 	VectorNormalize (dir);
 
 	bolt = G_Spawn();
-	bolt->classname = "detpack";
+	G_SetClassname( bolt, "detpack" );
 	bolt->nextthink = level.time + FRAMETIME;
 	bolt->think = G_RunObject;
 	bolt->s.eType = ET_GENERAL;
@@ -3362,7 +3362,7 @@ static void WP_FireConcussion( gentity_t *ent )
 
 	missile = CreateMissile( start, forward, vel, 10000, ent, qfalse );
 
-	missile->classname = "conc_proj";
+	G_SetClassname( missile, "conc_proj" );
 	missile->s.weapon = WP_CONCUSSION;
 	missile->mass = 10;
 
@@ -3742,7 +3742,7 @@ gentity_t *WP_FireVehicleWeapon( gentity_t *ent, vec3_t start, vec3_t dir, vehWe
 		//QUERY: alt_fire true or not?  Does it matter?
 		missile = CreateMissile( start, dir, vehWeapon->fSpeed, 10000, ent, qfalse );
 
-		missile->classname = "vehicle_proj";
+		G_SetClassname( missile, "vehicle_proj" );
 
 		missile->s.genericenemyindex = ent->s.number+MAX_GENTITIES;
 		missile->damage = vehWeapon->iDamage;
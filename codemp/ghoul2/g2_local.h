@@ -44,6 +44,8 @@ public:
 	virtual bool IsValid(int handle) const=0;
 	virtual std::vector<CGhoul2Info> &Get(int handle)=0;
 	virtual const std::vector<CGhoul2Info> &Get(int handle) const=0;
+	// fills an empty instance with copies of another's models
+	virtual void Copy(int handle, int fromHandle) { Get(handle)=Get(fromHandle); }
 };
 
 IGhoul2InfoArray &TheGhoul2InfoArray();
@@ -107,7 +109,7 @@ public:
 		if (other.mItem)
 		{
 			Alloc();
-			Array()=other.Array();
+			InfoArray().Copy(mItem, other.mItem);
 			int i;
 			for (i=0;i<size();i++)
 			{
@@ -223,6 +225,19 @@ qboolean	G2_Set_Bone_Anim_Index(boneInfo_v &blist, const int index, const int st
 qboolean	G2_Get_Bone_Anim_Index( boneInfo_v &blist, const int index, const int currentTime, float *currentFrame, int *startFrame, int *endFrame, int *flags, float *retAnimSpeed, qhandle_t *modelList, int modelIndex);
 
 // misc functions G2_misc.cpp
+
+// the model space ray a collision transform is done for, see G2_TransformModel
+class CTraceBounds
+{
+public:
+	vec3_t				rayStart;
+	vec3_t				rayEnd;
+	bool				radiusTrace;
+	vec3_t				axes[3];		// radius traces only: saxis, taxis and rayDir from G2_RadiusTraceAxes
+
+	CTraceBounds(const vec3_t initrayStart, const vec3_t initrayEnd, float fRadius);
+};
+
 void		G2_List_Model_Surfaces(const char *fileName);
 void		G2_List_Model_Bones(const char *fileName, int frame);
 qboolean	G2_GetAnimFileName(const char *fileName, char **filename);
@@ -233,9 +248,9 @@ void		G2_TraceModels(CGhoul2Info_v &ghoul2, vec3_t rayStart, vec3_t rayEnd, Coll
 #endif
 void		TransformAndTranslatePoint (const vec3_t in, vec3_t out, mdxaBone_t *mat);
 #ifdef _G2_GORE
-void		G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore);
+void		G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore, const CTraceBounds *traceBounds = NULL);
 #else
-void		G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod);
+void		G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, const CTraceBounds *traceBounds = NULL);
 #endif
 void		G2_GenerateWorldMatrix(const vec3_t angles, const vec3_t origin);
 void		TransformPoint (const vec3_t in, vec3_t out, mdxaBone_t *mat);
@@ -299,6 +314,7 @@ qboolean	G2API_AttachEnt(int *boltInfo, CGhoul2Info_v& ghoul2, int modelIndex, i
 void		G2API_DetachEnt(int *boltInfo);
 
 qboolean	G2API_GetBoltMatrix(CGhoul2Info_v &ghoul2, const int modelIndex, const int boltIndex, mdxaBone_t *matrix, const vec3_t angles, const vec3_t position, const int frameNum, qhandle_t *modelList, vec3_t scale);
+void		G2API_ConstructGhoulSkeletons(CGhoul2Info_v **ghoul2, vec3_t *scales, const int count, const int frameNum);
 
 void		G2API_ListSurfaces(CGhoul2Info *ghlInfo);
 void		G2API_ListBones(CGhoul2Info *ghlInfo, int frame);
@@ -365,6 +381,8 @@ extern qboolean gG2_GBMNoReconstruct;
 extern qboolean gG2_GBMUseSPMethod;
 // From tr_ghoul2.cpp
 void		G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool checkForNewOrigin,const vec3_t scale);
+void		G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool checkForNewOrigin,const vec3_t scale,bool keepCurrent);
+void		G2_ConstructGhoulSkeletons( CGhoul2Info_v **ghoul2, vec3_t *scales, const int count, const int frameNum );
 
 qboolean	G2API_SkinlessModel(CGhoul2Info_v& ghoul2, int modelIndex);
 
@@ -24,6 +24,9 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 // cmodel.c -- model loading
 #include "cm_local.h"
 #include "qcommon/qfiles.h"
+#ifndef BSPC
+#include "qcommon/jobs.h"
+#endif
 
 #ifdef BSPC
 
@@ -44,11 +47,13 @@ void SetPlaneSignbits (cplane_t *out) {
 #endif //BSPC
 
 // to allow boxes to be treated as brush models, we allocate
-// some extra indexes along with those needed by the map
+// some extra indexes along with those needed by the map,
+// one set for each trace context
 #define	BOX_BRUSHES		1
 #define	BOX_SIDES		6
 #define	BOX_LEAFS		2
 #define	BOX_PLANES		12
+#define	BOX_SIDES4		2		// ( BOX_SIDES + 3 ) / 4
 
 #define	LL(x) x=LittleLong(x)
 
@@ -63,13 +68,15 @@ byte		*cmod_base;
 #ifndef BSPC
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
+cvar_t		*cm_noSimd;
+cvar_t		*cm_patchCache;
 cvar_t		*cm_playerCurveClip;
 cvar_t		*cm_extraVerbose;
+cvar_t		*cm_debugSurfaceUpdate;
 #endif
 
-cmodel_t	box_model;
-cplane_t	*box_planes;
-cbrush_t	*box_brush;
+cmTraceContext_t	cm_traceContexts[MAX_TRACE_CONTEXTS];
+int			cm_numTraceContexts = 1;
 
 
 
@@ -239,6 +246,29 @@ void CM_BoundBrush( cbrush_t *b ) {
 	b->bounds[1][2] = b->sides[5].plane->dist;
 }
 
+#ifdef CM_SIMD
+/*
+=================
+CM_SetBrushSides4
+
+Copies the side planes into the brush's groups of four
+=================
+*/
+static void CM_SetBrushSides4( cbrush_t *b ) {
+	int			i, j;
+	cplane_t	*plane;
+
+	Com_Memset( b->sides4, 0, ( ( b->numsides + 3 ) / 4 ) * sizeof( *b->sides4 ) );
+	for ( i = 0 ; i < b->numsides ; i++ ) {
+		plane = b->sides[i].plane;
+		for ( j = 0 ; j < 3 ; j++ ) {
+			b->sides4[i >> 2].normal[j][i & 3] = plane->normal[j];
+		}
+		b->sides4[i >> 2].dist[i & 3] = plane->dist;
+	}
+}
+#endif
+
 
 /*
 =================
@@ -250,6 +280,9 @@ void CMod_LoadBrushes( const lump_t *l, clipMap_t &cm ) {
 	dbrush_t	*in;
 	cbrush_t	*out;
 	int			i, count;
+#ifdef CM_SIMD
+	cbrushSides4_t	*sides4;
+#endif
 
 	in = (dbrush_t *)(cmod_base + l->fileofs);
 	if (l->filelen % sizeof(*in)) {
@@ -257,7 +290,7 @@ void CMod_LoadBrushes( const lump_t *l, clipMap_t &cm ) {
 	}
 	count = l->filelen / sizeof(*in);
 
-	cm.brushes = (cbrush_t *)Hunk_Alloc( ( BOX_BRUSHES + count ) * sizeof( *cm.brushes ), h_high );
+	cm.brushes = (cbrush_t *)Hunk_Alloc( ( BOX_BRUSHES * cm_numTraceContexts + count ) * sizeof( *cm.brushes ), h_high );
 	cm.numBrushes = count;
 
 	out = cm.brushes;
@@ -275,6 +308,20 @@ void CMod_LoadBrushes( const lump_t *l, clipMap_t &cm ) {
 		CM_BoundBrush( out );
 	}
 
+#ifdef CM_SIMD
+	cm.numBrushSides4 = 0;
+	for ( i=0 ; i<count ; i++ ) {
+		cm.numBrushSides4 += ( cm.brushes[i].numsides + 3 ) / 4;
+	}
+	cm.brushSides4 = (cbrushSides4_t *)Hunk_Alloc( ( BOX_SIDES4 * cm_numTraceContexts + cm.numBrushSides4 ) * sizeof( *cm.brushSides4 ), h_high );
+
+	sides4 = cm.brushSides4;
+	for ( i=0, out=cm.brushes ; i<count ; i++, out++ ) {
+		out->sides4 = sides4;
+		sides4 += ( out->numsides + 3 ) / 4;
+		CM_SetBrushSides4( out );
+	}
+#endif
 }
 
 /*
@@ -340,7 +387,7 @@ static void CMod_LoadPlanes (const lump_t *l, clipMap_t &cm)
 
 	if (count < 1)
 		Com_Error (ERR_DROP, "Map with no planes");
-	cm.planes = (struct cplane_s *)Hunk_Alloc( ( BOX_PLANES + count ) * sizeof( *cm.planes ), h_high );
+	cm.planes = (struct cplane_s *)Hunk_Alloc( ( BOX_PLANES * cm_numTraceContexts + count ) * sizeof( *cm.planes ), h_high );
 	cm.numPlanes = count;
 
 	out = cm.planes;
@@ -378,7 +425,7 @@ static void CMod_LoadLeafBrushes (const lump_t *l, clipMap_t &cm)
 		Com_Error (ERR_DROP, "CMod_LoadLeafBrushes: funny lump size");
 	count = l->filelen / sizeof(*in);
 
-	cm.leafbrushes = (int *)Hunk_Alloc( (count + BOX_BRUSHES) * sizeof( *cm.leafbrushes ), h_high );
+	cm.leafbrushes = (int *)Hunk_Alloc( (count + BOX_BRUSHES * cm_numTraceContexts) * sizeof( *cm.leafbrushes ), h_high );
 	cm.numLeafBrushes = count;
 
 	out = cm.leafbrushes;
@@ -434,7 +481,7 @@ static void CMod_LoadBrushSides (const lump_t *l, clipMap_t &cm)
 	}
 	count = l->filelen / sizeof(*in);
 
-	cm.brushsides = (cbrushside_t *)Hunk_Alloc( ( BOX_SIDES + count ) * sizeof( *cm.brushsides ), h_high );
+	cm.brushsides = (cbrushside_t *)Hunk_Alloc( ( BOX_SIDES * cm_numTraceContexts + count ) * sizeof( *cm.brushsides ), h_high );
 	cm.numBrushSides = count;
 
 	out = cm.brushsides;
@@ -514,10 +561,13 @@ static void CMod_LoadVisibility( const lump_t *l, clipMap_t &cm ) {
 /*
 =================
 CMod_LoadPatches
+
+The collision for the patches comes from the cache file of the map when
+there is an up to date one, and is generated and saved otherwise
 =================
 */
 #define	MAX_PATCH_VERTS		1024
-static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_t &cm ) {
+static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_t &cm, const char *name, int checksum ) {
 	drawVert_t	*dv, *dv_p;
 	dsurface_t	*in;
 	int			count;
@@ -527,6 +577,7 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_
 	vec3_t		points[MAX_PATCH_VERTS];
 	int			width, height;
 	int			shaderNum;
+	int			numPatches;
 
 	in = (dsurface_t *)(cmod_base + surfs->fileofs);
 	if (surfs->filelen % sizeof(*in))
@@ -540,6 +591,7 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_
 
 	// scan through all the surfaces, but only load patches,
 	// not planar faces
+	numPatches = 0;
 	for ( i = 0 ; i < count ; i++, in++ ) {
 		if ( LittleLong( in->surfaceType ) != MST_PATCH ) {
 			continue;		// ignore other surfaces
@@ -548,6 +600,29 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_
 
 		cm.surfaces[ i ] = patch = (cPatch_t *)Hunk_Alloc( sizeof( *patch ), h_high );
 
+		shaderNum = LittleLong( in->shaderNum );
+		patch->contents = cm.shaders[shaderNum].contentFlags;
+		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
+		numPatches++;
+	}
+
+	if ( !numPatches ) {
+		return;
+	}
+
+#ifndef BSPC
+	if ( CM_LoadPatchCache( name, checksum, cm ) ) {
+		return;
+	}
+#endif
+
+	in = (dsurface_t *)(cmod_base + surfs->fileofs);
+	for ( i = 0 ; i < count ; i++, in++ ) {
+		patch = cm.surfaces[ i ];
+		if ( !patch ) {
+			continue;
+		}
+
 		// load the full drawverts onto the stack
 		width = LittleLong( in->patchWidth );
 		height = LittleLong( in->patchHeight );
@@ -563,17 +638,31 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, clipMap_
 			points[j][2] = LittleFloat( dv_p->xyz[2] );
 		}
 
-		shaderNum = LittleLong( in->shaderNum );
-		patch->contents = cm.shaders[shaderNum].contentFlags;
-		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
-
 		// create the internal facet structure
 		patch->pc = CM_GeneratePatchCollide( width, height, points );
 	}
+
+#ifndef BSPC
+	CM_SavePatchCache( name, checksum, cm );
+#endif
 }
 
 //==================================================================
 
+/*
+=================
+CMod_AllocTraceChecks
+
+Each trace context gets its own row of checkcounts, the box brushes
+at the end of the brush array included
+=================
+*/
+static void CMod_AllocTraceChecks( clipMap_t &cm ) {
+	cm.brushCheckStride = cm.numBrushes + BOX_BRUSHES * cm_numTraceContexts;
+	cm.brushChecks = (int *)Hunk_Alloc( cm_numTraceContexts * cm.brushCheckStride * sizeof( *cm.brushChecks ), h_high );
+	cm.patchChecks = (int *)Hunk_Alloc( cm_numTraceContexts * cm.numSurfaces * sizeof( *cm.patchChecks ), h_high );
+}
+
 /*
 ==================
 CM_LoadMap
@@ -585,6 +674,21 @@ void *gpvCachedMapDiskImage = NULL;
 char  gsCachedMapDiskImage[MAX_QPATH];
 qboolean gbUsingCachedMapDataRightNow = qfalse;	// if true, signifies that you can't delete this at the moment!! (used during z_malloc()-fail recovery attempt)
 
+#ifndef BSPC
+// the FS_MapFile image a dedicated server loads from, held here so an ERR_DROP part way through the load
+//	doesn't leak it - CM_ClearMap (SV_Shutdown) releases it, which always happens before the next FS_Restart
+static const void *gpvMappedMapDiskImage = NULL;
+
+static void CM_UnmapMapDiskImage( void )
+{
+	if ( gpvMappedMapDiskImage )
+	{
+		FS_UnmapFile( gpvMappedMapDiskImage );
+		gpvMappedMapDiskImage = NULL;
+	}
+}
+#endif
+
 // called in response to a "devmapbsp blah" or "devmapall blah" command, do NOT use inside CM_Load unless you pass in qtrue
 //
 // new bool return used to see if anything was freed, used during z_malloc failure re-try
@@ -633,8 +737,11 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 #ifndef BSPC
 	cm_noAreas = Cvar_Get ("cm_noAreas", "0", CVAR_CHEAT);
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
+	cm_noSimd = Cvar_Get( "cm_noSimd", "0", CVAR_CHEAT, "Test brush sides one at a time instead of four at once" );
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE_ND|CVAR_CHEAT );
+	cm_patchCache = Cvar_Get( "cm_patchCache", "1", CVAR_ARCHIVE_ND, "Keep generated curve collision in a cache file next to the map" );
 	cm_extraVerbose = Cvar_Get ("cm_extraVerbose", "0", CVAR_TEMP );
+	cm_debugSurfaceUpdate = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -651,6 +758,13 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 		// free old stuff
 		CM_ClearMap();
 		CM_ClearLevelPatches();
+
+		// sub bsps are sized for the same contexts as the world
+#ifndef BSPC
+		cm_numTraceContexts = Q_min( 1 + Com_JobThreads(), MAX_TRACE_CONTEXTS );
+#else
+		cm_numTraceContexts = 1;
+#endif
 	}
 
 	// free old stuff
@@ -684,8 +798,19 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 	//	then discard it after that...
 	//
 	buf = NULL;
-	fileHandle_t h;
-	const int iBSPLen = FS_FOpenFileRead( name, &h, qfalse );
+	int iBSPLen;
+	fileHandle_t h = 0;
+	if ( com_dedicated->integer )
+	{
+		// nothing keeps the image around for a renderer, so read it in place when it's in a mapped pk3
+		CM_UnmapMapDiskImage();
+		iBSPLen = FS_MapFile( name, &gpvMappedMapDiskImage );
+		buf = (int *)gpvMappedMapDiskImage;
+	}
+	else
+	{
+		iBSPLen = FS_FOpenFileRead( name, &h, qfalse );
+	}
 	if (h)
 	{
 		newBuff = Z_Malloc( iBSPLen, TAG_BSP_DISKIMAGE );
@@ -722,6 +847,9 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 	if ( header.version != BSP_VERSION ) {
 		Z_Free(	gpvCachedMapDiskImage);
 				gpvCachedMapDiskImage = NULL;
+#ifndef BSPC
+		CM_UnmapMapDiskImage();
+#endif
 
 		Com_Error (ERR_DROP, "CM_LoadMap: %s has wrong version number (%i should be %i)"
 		, name, header.version, BSP_VERSION );
@@ -741,7 +869,8 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 	CMod_LoadNodes (&header.lumps[LUMP_NODES], cm);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES], cm, name);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY], cm );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], cm );
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], cm, origName, last_checksum );
+	CMod_AllocTraceChecks( cm );
 
 	TotalSubModels += cm.numSubModels;
 
@@ -770,6 +899,8 @@ static void CM_LoadMap_Actual( const char *name, qboolean clientload, int *check
 		// ... do nothing, and let the renderer free it after it's finished playing with it...
 		//
 	}
+
+	CM_UnmapMapDiskImage();
 #else
 	FS_FreeFile (buf);
 #endif
@@ -807,6 +938,9 @@ void CM_ClearMap( void )
 
 	Com_Memset( &cmg, 0, sizeof( cmg ) );
 	CM_ClearLevelPatches();
+#ifndef BSPC
+	CM_UnmapMapDiskImage();
+#endif
 
 	for(i = 0; i < NumSubBSP; i++)
 	{
@@ -821,7 +955,7 @@ void CM_ClearMap( void )
 CM_ClipHandleToModel
 ==================
 */
-cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap ) {
+cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap, cmTraceContext_t *context ) {
 	int		i;
 	int		count;
 
@@ -843,7 +977,7 @@ cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap ) {
 		{
 			*clipMap = &cmg;
 		}
-		return &box_model;
+		return context ? &context->boxModel : &cm_traceContexts[0].boxModel;
 	}
 
 	count = cmg.numSubModels;
@@ -918,52 +1052,86 @@ CM_InitBoxHull
 
 Set up the planes and nodes so that the six floats of a bounding box
 can just be stored out and get a proper clipping hull structure.
+Every trace context gets its own box.
 ===================
 */
 void CM_InitBoxHull (void)
 {
-	int			i;
+	int			i, c;
 	int			side;
 	cplane_t	*p;
 	cbrushside_t	*s;
+	cmTraceContext_t	*context;
+
+	for (c=0 ; c<cm_numTraceContexts ; c++)
+	{
+		context = &cm_traceContexts[c];
+		context->index = c;
 
-	box_planes = &cmg.planes[cmg.numPlanes];
+		context->boxPlanes = &cmg.planes[cmg.numPlanes + c*BOX_PLANES];
 
-	box_brush = &cmg.brushes[cmg.numBrushes];
-	box_brush->numsides = 6;
-	box_brush->sides = cmg.brushsides + cmg.numBrushSides;
-	box_brush->contents = CONTENTS_BODY;
+		context->boxBrush = &cmg.brushes[cmg.numBrushes + c*BOX_BRUSHES];
+		context->boxBrush->numsides = 6;
+		context->boxBrush->sides = cmg.brushsides + cmg.numBrushSides + c*BOX_SIDES;
+		context->boxBrush->contents = CONTENTS_BODY;
 
-	box_model.firstNode = -1;
-	box_model.leaf.numLeafBrushes = 1;
-//	box_model.leaf.firstLeafBrush = cmg.numBrushes;
-	box_model.leaf.firstLeafBrush = cmg.numLeafBrushes;
-	cmg.leafbrushes[cmg.numLeafBrushes] = cmg.numBrushes;
+		Com_Memset( &context->boxModel, 0, sizeof( context->boxModel ) );
+		context->boxModel.firstNode = -1;
+		context->boxModel.leaf.numLeafBrushes = 1;
+		context->boxModel.leaf.firstLeafBrush = cmg.numLeafBrushes + c*BOX_BRUSHES;
+		cmg.leafbrushes[cmg.numLeafBrushes + c*BOX_BRUSHES] = cmg.numBrushes + c*BOX_BRUSHES;
 
-	for (i=0 ; i<6 ; i++)
-	{
-		side = i&1;
-
-		// brush sides
-		s = &cmg.brushsides[cmg.numBrushSides+i];
-		s->plane = 	cmg.planes + (cmg.numPlanes+i*2+side);
-		s->shaderNum = cmg.numShaders;
-
-		// planes
-		p = &box_planes[i*2];
-		p->type = i>>1;
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = 1;
-
-		p = &box_planes[i*2+1];
-		p->type = 3 + (i>>1);
-		p->signbits = 0;
-		VectorClear (p->normal);
-		p->normal[i>>1] = -1;
-
-		SetPlaneSignbits( p );
+		for (i=0 ; i<6 ; i++)
+		{
+			side = i&1;
+
+			// brush sides
+			s = &context->boxBrush->sides[i];
+			s->plane = 	context->boxPlanes + (i*2+side);
+			s->shaderNum = cmg.numShaders;
+
+			// planes
+			p = &context->boxPlanes[i*2];
+			p->type = i>>1;
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = 1;
+
+			p = &context->boxPlanes[i*2+1];
+			p->type = 3 + (i>>1);
+			p->signbits = 0;
+			VectorClear (p->normal);
+			p->normal[i>>1] = -1;
+
+			SetPlaneSignbits( p );
+		}
+
+#ifdef CM_SIMD
+		context->boxBrush->sides4 = cmg.brushSides4 + cmg.numBrushSides4 + c*BOX_SIDES4;
+		CM_SetBrushSides4( context->boxBrush );
+#endif
+	}
+}
+
+/*
+===================
+CM_NumTraceContexts
+===================
+*/
+int CM_NumTraceContexts( void ) {
+	return cm_numTraceContexts;
+}
+
+/*
+===================
+CM_TraceContext
+===================
+*/
+cmTraceContext_t *CM_TraceContext( int index ) {
+	if ( index < 0 || index >= cm_numTraceContexts ) {
+		Com_Error( ERR_DROP, "CM_TraceContext: bad index %i", index );
 	}
+	return &cm_traceContexts[index];
 }
 
 /*
@@ -975,10 +1143,11 @@ BSP trees instead of being compared directly.
 Capsules are handled differently though.
 ===================
 */
-clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule, cmTraceContext_t *context ) {
+	cplane_t	*box_planes = context->boxPlanes;
 
-	VectorCopy( mins, box_model.mins );
-	VectorCopy( maxs, box_model.maxs );
+	VectorCopy( mins, context->boxModel.mins );
+	VectorCopy( maxs, context->boxModel.maxs );
 
 	if ( capsule ) {
 		return CAPSULE_MODEL_HANDLE;
@@ -997,25 +1166,37 @@ clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
-	VectorCopy( mins, box_brush->bounds[0] );
-	VectorCopy( maxs, box_brush->bounds[1] );
+	VectorCopy( mins, context->boxBrush->bounds[0] );
+	VectorCopy( maxs, context->boxBrush->bounds[1] );
+
+#ifdef CM_SIMD
+	CM_SetBrushSides4( context->boxBrush );
+#endif
 
 	return BOX_MODEL_HANDLE;
 }
 
+clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule ) {
+	return CM_TempBoxModel( mins, maxs, capsule, &cm_traceContexts[0] );
+}
+
 /*
 ===================
 CM_ModelBounds
 ===================
 */
-void CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs ) {
+void CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs, cmTraceContext_t *context ) {
 	cmodel_t	*cmod;
 
-	cmod = CM_ClipHandleToModel( model );
+	cmod = CM_ClipHandleToModel( model, NULL, context );
 	VectorCopy( cmod->mins, mins );
 	VectorCopy( cmod->maxs, maxs );
 }
 
+void CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs ) {
+	CM_ModelBounds( model, mins, maxs, &cm_traceContexts[0] );
+}
+
 int CM_LoadSubBSP(const char *name, qboolean clientload)
 {
 	int		i;
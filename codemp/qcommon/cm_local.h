@@ -31,6 +31,20 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #define	BOX_MODEL_HANDLE		(MAX_SUBMODELS-1)
 #define CAPSULE_MODEL_HANDLE	(MAX_SUBMODELS-2)
 
+// the main thread plus one for each job thread, see jobs.cpp
+#define	MAX_TRACE_CONTEXTS		33
+
+// brush sides are tested four at a time where SSE or AArch64 NEON is available
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define CM_SIMD_SSE
+#elif ( defined(__aarch64__) && defined(__ARM_NEON) ) || defined(_M_ARM64)
+	#define CM_SIMD_NEON
+#endif
+
+#if defined(CM_SIMD_SSE) || defined(CM_SIMD_NEON)
+	#define CM_SIMD
+#endif
+
 struct Point
 {
 	long x, y;
@@ -63,13 +77,22 @@ typedef struct cbrushside_s {
 	int			shaderNum;
 } cbrushside_t;
 
+// the side planes of a brush, four at a time: lane i of group g is side g*4+i,
+// unused lanes at the end are zero
+typedef struct cbrushSides4_s {
+	float		normal[3][4];
+	float		dist[4];
+} cbrushSides4_t;
+
 typedef struct cbrush_s {
 	int					shaderNum;		// the shader that determined the contents
 	int					contents;
 	vec3_t				bounds[2];
 	cbrushside_t		*sides;
 	unsigned short		numsides;
-	unsigned short		checkcount;		// to avoid repeated testings
+#ifdef CM_SIMD
+	cbrushSides4_t		*sides4;		// ( numsides + 3 ) / 4 groups
+#endif
 } cbrush_t;
 
 class CCMShader
@@ -87,7 +110,6 @@ public:
 };
 
 typedef struct cPatch_s {
-	int			checkcount;				// to avoid repeated testings
 	int			surfaceFlags;
 	int			contents;
 	struct patchCollide_s	*pc;
@@ -129,6 +151,11 @@ typedef struct clipMap_s {
 	int			numBrushes;
 	cbrush_t	*brushes;
 
+#ifdef CM_SIMD
+	int			numBrushSides4;		// groups used by the map's own brushes
+	cbrushSides4_t *brushSides4;	// followed by the groups of the box brushes
+#endif
+
 	int			numClusters;
 	int			clusterBytes;
 	byte		*visibility;
@@ -145,21 +172,40 @@ typedef struct clipMap_s {
 	cPatch_t	**surfaces;			// non-patches will be NULL
 
 	int			floodvalid;
-	int			checkcount;					// incremented on each trace
+
+	// to avoid repeated testings, one row of trace counts per trace context
+	int			brushCheckStride;
+	int			*brushChecks;		// [ numTraceContexts * brushCheckStride ]
+	int			*patchChecks;		// [ numTraceContexts * numSurfaces ]
 } clipMap_t;
 
+// everything a trace writes to besides its own traceWork_t, so that traces
+// made with different contexts can run at the same time
+struct cmTraceContext_s {
+	int			index;
+	int			checkcount;			// incremented on each trace
+	cmodel_t	boxModel;			// set by CM_TempBoxModel
+	cplane_t	*boxPlanes;
+	cbrush_t	*boxBrush;
+};
+
 
 // keep 1/8 unit away to keep the position valid before network snapping
 // and to avoid various numeric issues
 #define	SURFACE_CLIP_EPSILON	(0.125)
 
 extern	clipMap_t	cmg; //rwwRMG - changed from cm
+extern	cmTraceContext_t	cm_traceContexts[MAX_TRACE_CONTEXTS];
+extern	int			cm_numTraceContexts;
 extern	int			c_pointcontents;
-extern	int			c_traces, c_brush_traces, c_patch_traces;
+extern	int			c_traces, c_brush_traces, c_patch_traces;	// only approximate with traces on several threads
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
+extern	cvar_t		*cm_noSimd;
+extern	cvar_t		*cm_patchCache;
 extern	cvar_t		*cm_playerCurveClip;
 extern	cvar_t		*cm_extraVerbose;
+extern	cvar_t		*cm_debugSurfaceUpdate;
 
 // cm_test.c
 
@@ -181,6 +227,7 @@ typedef struct traceWork_s { //rwwRMG - modified
 	vec3_t		modelOrigin;// origin of the model tracing through
 	int			contents;	// ored contents of the model tracing through
 	qboolean	isPoint;	// optimized case
+	cmTraceContext_t	*context;	// per thread state of the trace
 //	trace_t		trace;		// returned from trace call
 	sphere_t	sphere;		// sphere for oriendted capsule collision
 
@@ -206,6 +253,7 @@ typedef struct leafList_s {
 	int		*list;
 	vec3_t	bounds[2];
 	int		lastLeaf;		// for overflows where each leaf can't be stored individually
+	cmTraceContext_t	*context;	// only used by CM_StoreBrushes
 	void	(*storeLeafs)( struct leafList_s *ll, int nodenum );
 } leafList_t;
 
@@ -214,7 +262,36 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum );
 
 void CM_BoxLeafnums_r( leafList_t *ll, int nodenum );
 
-cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap = 0 );
+cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle, clipMap_t **clipMap = 0, cmTraceContext_t *context = 0 );
+
+/*
+================
+CM_BrushChecked
+
+Marks the brush as tested by the current trace of the context,
+returns qtrue if it already was
+================
+*/
+static inline qboolean CM_BrushChecked( const cmTraceContext_t *context, clipMap_t *local, int brushnum ) {
+	int *check = &local->brushChecks[context->index * local->brushCheckStride + brushnum];
+
+	if ( *check == context->checkcount ) {
+		return qtrue;
+	}
+	*check = context->checkcount;
+	return qfalse;
+}
+
+// same for the patch of a surface
+static inline qboolean CM_PatchChecked( const cmTraceContext_t *context, clipMap_t *local, int surfnum ) {
+	int *check = &local->patchChecks[context->index * local->numSurfaces + surfnum];
+
+	if ( *check == context->checkcount ) {
+		return qtrue;
+	}
+	*check = context->checkcount;
+	return qfalse;
+}
 
 // cm_patch.c
 
@@ -222,6 +299,10 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 void CM_TraceThroughPatchCollide( traceWork_t *tw, trace_t &trace, const struct patchCollide_s *pc );
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
+#ifndef BSPC
+qboolean CM_LoadPatchCache( const char *name, int checksum, clipMap_t &cm );
+void CM_SavePatchCache( const char *name, int checksum, const clipMap_t &cm );
+#endif
 
 // cm_shader.cpp
 void CM_SetupShaderProperties( void );
@@ -414,6 +414,12 @@ static	patchPlane_t	planes[MAX_PATCH_PLANES];
 //static	facet_t			facets[MAX_PATCH_PLANES]; //maybe MAX_FACETS ??
 static		facet_t			*facets = NULL;
 
+#define	MAX_PATCH_NODES		( 2 * MAX_FACETS / PATCH_NODE_FACETS )
+
+static	vec3_t			facetBounds[MAX_FACETS][2];
+static	int				numPatchNodes;
+static	patchNode_t		patchNodes[MAX_PATCH_NODES];
+
 #define	NORMAL_EPSILON	0.00015
 #define	DIST_EPSILON	0.0235
 
@@ -801,9 +807,12 @@ static inline qboolean CM_ValidateFacet( facet_t *facet ) {
 /*
 ==================
 CM_AddFacetBevels
+
+Also returns the bounds of the facet winding, which the axial bevels keep
+the facet inside of
 ==================
 */
-static inline void CM_AddFacetBevels( facet_t *facet ) {
+static inline void CM_AddFacetBevels( facet_t *facet, vec3_t bounds[2] ) {
 
 	int i, j, k, l;
 	int axis, dir, order, flipped;
@@ -826,10 +835,15 @@ static inline void CM_AddFacetBevels( facet_t *facet ) {
 		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
 	}
 	if ( !w ) {
+		// no axial bevels either, so it can't be culled
+		VectorSet( bounds[0], -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS );
+		VectorSet( bounds[1], MAX_MAP_BOUNDS, MAX_MAP_BOUNDS, MAX_MAP_BOUNDS );
 		return;
 	}
 
 	WindingBounds(w, mins, maxs);
+	VectorCopy( mins, bounds[0] );
+	VectorCopy( maxs, bounds[1] );
 
 	// add the axial planes
 	order = 0;
@@ -974,6 +988,46 @@ typedef enum {
 	EN_LEFT
 } edgeName_t;
 
+/*
+==================
+CM_BuildPatchNodes
+
+Splits a run of facets in half until the runs are small enough for leafs.
+Facets next to each other in the run come from neighbouring grid squares,
+so the halves stay reasonably compact without sorting anything.
+==================
+*/
+static void CM_BuildPatchNodes( int firstFacet, int numFacets ) {
+	patchNode_t	*node;
+	int			i;
+
+	if ( numPatchNodes == MAX_PATCH_NODES ) {
+		Com_Error( ERR_DROP, "MAX_PATCH_NODES" );
+	}
+	node = &patchNodes[numPatchNodes++];
+	node->firstFacet = firstFacet;
+	node->numFacets = numFacets;
+
+	ClearBounds( node->bounds[0], node->bounds[1] );
+	for ( i = firstFacet ; i < firstFacet + numFacets ; i++ ) {
+		AddPointToBounds( facetBounds[i][0], node->bounds[0], node->bounds[1] );
+		AddPointToBounds( facetBounds[i][1], node->bounds[0], node->bounds[1] );
+	}
+
+	// expand by one unit for epsilon purposes, same as the patch bounds
+	for ( i = 0 ; i < 3 ; i++ ) {
+		node->bounds[0][i] -= 1;
+		node->bounds[1][i] += 1;
+	}
+
+	if ( numFacets > PATCH_NODE_FACETS ) {
+		CM_BuildPatchNodes( firstFacet, numFacets / 2 );
+		CM_BuildPatchNodes( firstFacet + numFacets / 2, numFacets - numFacets / 2 );
+	}
+
+	node->skip = numPatchNodes;
+}
+
 /*
 ==================
 CM_PatchCollideFromGrid
@@ -1078,7 +1132,7 @@ static inline void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf )
 				facet->borderNoAdjust[3] = (qboolean)noAdjust[EN_LEFT];
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, facetBounds[numFacets] );
 					numFacets++;
 				}
 			} else {
@@ -1098,7 +1152,7 @@ static inline void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf )
 				}
  				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, facetBounds[numFacets] );
 					numFacets++;
 				}
 
@@ -1123,7 +1177,7 @@ static inline void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf )
 				}
 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
 				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
+					CM_AddFacetBevels( facet, facetBounds[numFacets] );
 					numFacets++;
 				}
 			}
@@ -1145,6 +1199,19 @@ static inline void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf )
 	pf->planes = (patchPlane_t *)Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
 	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
 
+	// a small tree over the facet bounds lets traces skip most of a large patch
+	numPatchNodes = 0;
+	if ( numFacets > PATCH_NODE_FACETS ) {
+		CM_BuildPatchNodes( 0, numFacets );
+		pf->nodes = (patchNode_t *)Hunk_Alloc( numPatchNodes * sizeof( *pf->nodes ), h_high );
+		Com_Memcpy( pf->nodes, patchNodes, numPatchNodes * sizeof( *pf->nodes ) );
+	}
+	else
+	{
+		pf->nodes = 0;
+	}
+	pf->numNodes = numPatchNodes;
+
 	Z_Free(facets);
 }
 
@@ -1227,6 +1294,308 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	return pf;
 }
 
+#ifndef BSPC
+/*
+================================================================================
+
+PATCH COLLIDE CACHE
+
+Generating the facets is a good part of loading a map with a lot of curves,
+so the results are kept in a file next to the map in the home path. The file
+is tied to the bsp by its checksum, and to this code by the version and the
+structure sizes. Anything that doesn't match is generated and saved again.
+
+================================================================================
+*/
+
+#define	PATCH_CACHE_IDENT		(('L'<<24)+('O'<<16)+('C'<<8)+'P')		// little-endian "PCOL"
+#define	PATCH_CACHE_VERSION		1
+
+typedef struct patchCacheHeader_s {
+	int		ident;
+	int		version;
+	int		checksum;			// of the bsp
+	int		numSurfaces;
+	int		numPatches;
+	int		planeSize;
+	int		facetSize;
+	int		nodeSize;
+} patchCacheHeader_t;
+
+// one for each patch, in surface order, followed by its planes, facets and nodes
+typedef struct patchCacheRecord_s {
+	int		surfaceNum;
+	vec3_t	bounds[2];
+	int		numPlanes;
+	int		numFacets;
+	int		numNodes;
+} patchCacheRecord_t;
+
+/*
+==================
+CM_PatchCacheName
+
+The cache lives loose in the game dir under fs_homepath and is opened there
+directly, a pure server's search would never return it to its clients
+==================
+*/
+static void CM_PatchCacheName( const char *name, char *cacheName, int cacheNameSize ) {
+	char	mapName[MAX_QPATH];
+
+	COM_StripExtension( name, mapName, sizeof( mapName ) );
+	Com_sprintf( cacheName, cacheNameSize, "%s/%s.pcol", FS_GetCurrentGameDir(), mapName );
+}
+
+/*
+==================
+CM_PatchCacheRecordSize
+
+Checks a cached patch before anything is allocated for it, so a damaged file
+can't index past its planes or facets. Returns the size of the record with
+its arrays, or 0 if it isn't usable.
+==================
+*/
+static int CM_PatchCacheRecordSize( const byte *data, int remaining ) {
+	const patchCacheRecord_t	*record;
+	const facet_t		*facet;
+	const patchNode_t	*node;
+	int			size;
+	int			i, j;
+	int			nextLeafFacet;
+
+	if ( remaining < (int)sizeof( *record ) ) {
+		return 0;
+	}
+	record = (const patchCacheRecord_t *)data;
+
+	if ( record->numPlanes < 0 || record->numPlanes > MAX_PATCH_PLANES
+		|| record->numFacets < 0 || record->numFacets > MAX_FACETS
+		|| record->numNodes < 0 || record->numNodes > MAX_PATCH_NODES ) {
+		return 0;
+	}
+
+	size = sizeof( *record ) + record->numPlanes * sizeof( patchPlane_t )
+		+ record->numFacets * sizeof( facet_t ) + record->numNodes * sizeof( patchNode_t );
+	if ( size > remaining ) {
+		return 0;
+	}
+
+	facet = (const facet_t *)( data + sizeof( *record ) + record->numPlanes * sizeof( patchPlane_t ) );
+	for ( i = 0 ; i < record->numFacets ; i++, facet++ ) {
+		if ( facet->surfacePlane < 0 || facet->surfacePlane >= record->numPlanes
+			|| facet->numBorders < 0 || facet->numBorders > (int)ARRAY_LEN( facet->borderPlanes ) ) {
+			return 0;
+		}
+		for ( j = 0 ; j < facet->numBorders ; j++ ) {
+			if ( facet->borderPlanes[j] < 0 || facet->borderPlanes[j] >= record->numPlanes ) {
+				return 0;
+			}
+		}
+	}
+
+	// the leafs have to cover the facets once each, in order
+	node = (const patchNode_t *)facet;
+	nextLeafFacet = 0;
+	for ( i = 0 ; i < record->numNodes ; i++, node++ ) {
+		if ( node->firstFacet < 0 || node->numFacets <= 0
+			|| node->firstFacet + node->numFacets > record->numFacets
+			|| node->skip <= i || node->skip > record->numNodes ) {
+			return 0;
+		}
+		if ( node->numFacets <= PATCH_NODE_FACETS ) {
+			if ( node->firstFacet != nextLeafFacet ) {
+				return 0;
+			}
+			nextLeafFacet += node->numFacets;
+		}
+	}
+	if ( record->numNodes && nextLeafFacet != record->numFacets ) {
+		return 0;
+	}
+
+	return size;
+}
+
+/*
+==================
+CM_LoadPatchCache
+
+Fills in the collision of all the patches of the map from its cache file,
+returns qfalse without touching anything if there is no usable one
+==================
+*/
+qboolean CM_LoadPatchCache( const char *name, int checksum, clipMap_t &cm ) {
+	char				cacheName[MAX_OSPATH];
+	fileHandle_t		f;
+	byte				*buffer, *data;
+	patchCacheHeader_t	*header;
+	patchCacheRecord_t	*record;
+	patchCollide_t		*pc;
+	int					len, size, remaining;
+	int					i, j, surfaceNum, numPatches;
+
+	if ( !cm_patchCache->integer ) {
+		return qfalse;
+	}
+
+	CM_PatchCacheName( name, cacheName, sizeof( cacheName ) );
+	len = FS_SV_FOpenFileRead( cacheName, &f );
+	if ( !f ) {
+		return qfalse;
+	}
+	if ( len < (int)sizeof( *header ) ) {
+		Com_DPrintf( "%s is out of date\n", cacheName );
+		FS_FCloseFile( f );
+		return qfalse;
+	}
+	buffer = (byte *)Z_Malloc( len, TAG_TEMP_WORKSPACE, qfalse );
+	len = FS_Read( buffer, len, f );
+	FS_FCloseFile( f );
+
+	numPatches = 0;
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( cm.surfaces[i] ) {
+			numPatches++;
+		}
+	}
+
+	header = (patchCacheHeader_t *)buffer;
+	if ( len < (int)sizeof( *header )
+		|| header->ident != PATCH_CACHE_IDENT
+		|| header->version != PATCH_CACHE_VERSION
+		|| header->checksum != checksum
+		|| header->numSurfaces != cm.numSurfaces
+		|| header->numPatches != numPatches
+		|| header->planeSize != (int)sizeof( patchPlane_t )
+		|| header->facetSize != (int)sizeof( facet_t )
+		|| header->nodeSize != (int)sizeof( patchNode_t ) ) {
+		Com_DPrintf( "%s is out of date\n", cacheName );
+		Z_Free( buffer );
+		return qfalse;
+	}
+
+	// check everything before allocating, the hunk can't give it back
+	data = buffer + sizeof( *header );
+	remaining = len - sizeof( *header );
+	surfaceNum = -1;
+	for ( i = 0 ; i < numPatches ; i++ ) {
+		record = (patchCacheRecord_t *)data;
+		size = CM_PatchCacheRecordSize( data, remaining );
+		if ( !size || record->surfaceNum <= surfaceNum || record->surfaceNum >= cm.numSurfaces
+			|| !cm.surfaces[record->surfaceNum] ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s is damaged, generating the curves again\n", cacheName );
+			Z_Free( buffer );
+			return qfalse;
+		}
+		surfaceNum = record->surfaceNum;
+		data += size;
+		remaining -= size;
+	}
+
+	data = buffer + sizeof( *header );
+	for ( i = 0 ; i < numPatches ; i++ ) {
+		record = (patchCacheRecord_t *)data;
+		data += sizeof( *record );
+
+		pc = (patchCollide_t *)Hunk_Alloc( sizeof( *pc ), h_high );
+		VectorCopy( record->bounds[0], pc->bounds[0] );
+		VectorCopy( record->bounds[1], pc->bounds[1] );
+
+		pc->numPlanes = record->numPlanes;
+		pc->planes = (patchPlane_t *)Hunk_Alloc( pc->numPlanes * sizeof( *pc->planes ), h_high );
+		Com_Memcpy( pc->planes, data, pc->numPlanes * sizeof( *pc->planes ) );
+		data += pc->numPlanes * sizeof( *pc->planes );
+		// the traces index tw->offsets with signbits, so don't take it from the file
+		for ( j = 0 ; j < pc->numPlanes ; j++ ) {
+			pc->planes[j].signbits = CM_SignbitsForNormal( pc->planes[j].plane );
+		}
+
+		pc->numFacets = record->numFacets;
+		if ( pc->numFacets ) {
+			pc->facets = (facet_t *)Hunk_Alloc( pc->numFacets * sizeof( *pc->facets ), h_high );
+			Com_Memcpy( pc->facets, data, pc->numFacets * sizeof( *pc->facets ) );
+			data += pc->numFacets * sizeof( *pc->facets );
+		}
+
+		pc->numNodes = record->numNodes;
+		if ( pc->numNodes ) {
+			pc->nodes = (patchNode_t *)Hunk_Alloc( pc->numNodes * sizeof( *pc->nodes ), h_high );
+			Com_Memcpy( pc->nodes, data, pc->numNodes * sizeof( *pc->nodes ) );
+			data += pc->numNodes * sizeof( *pc->nodes );
+		}
+
+		cm.surfaces[record->surfaceNum]->pc = pc;
+	}
+
+	Z_Free( buffer );
+
+	Com_DPrintf( "Loaded the collision of %i curves from %s\n", numPatches, cacheName );
+	return qtrue;
+}
+
+/*
+==================
+CM_SavePatchCache
+==================
+*/
+void CM_SavePatchCache( const char *name, int checksum, const clipMap_t &cm ) {
+	char				cacheName[MAX_OSPATH];
+	fileHandle_t		f;
+	patchCacheHeader_t	header;
+	patchCacheRecord_t	record;
+	const patchCollide_t	*pc;
+	int					i;
+
+	if ( !cm_patchCache->integer ) {
+		return;
+	}
+
+	header.ident = PATCH_CACHE_IDENT;
+	header.version = PATCH_CACHE_VERSION;
+	header.checksum = checksum;
+	header.numSurfaces = cm.numSurfaces;
+	header.numPatches = 0;
+	header.planeSize = sizeof( patchPlane_t );
+	header.facetSize = sizeof( facet_t );
+	header.nodeSize = sizeof( patchNode_t );
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( cm.surfaces[i] ) {
+			header.numPatches++;
+		}
+	}
+
+	CM_PatchCacheName( name, cacheName, sizeof( cacheName ) );
+	f = FS_SV_FOpenFileWrite( cacheName );
+	if ( !f ) {
+		Com_DPrintf( "Couldn't write %s\n", cacheName );
+		return;
+	}
+
+	FS_Write( &header, sizeof( header ), f );
+	for ( i = 0 ; i < cm.numSurfaces ; i++ ) {
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		pc = cm.surfaces[i]->pc;
+
+		Com_Memset( &record, 0, sizeof( record ) );
+		record.surfaceNum = i;
+		VectorCopy( pc->bounds[0], record.bounds[0] );
+		VectorCopy( pc->bounds[1], record.bounds[1] );
+		record.numPlanes = pc->numPlanes;
+		record.numFacets = pc->numFacets;
+		record.numNodes = pc->numNodes;
+
+		FS_Write( &record, sizeof( record ), f );
+		FS_Write( pc->planes, pc->numPlanes * sizeof( *pc->planes ), f );
+		FS_Write( pc->facets, pc->numFacets * sizeof( *pc->facets ), f );
+		FS_Write( pc->nodes, pc->numNodes * sizeof( *pc->nodes ), f );
+	}
+
+	FS_FCloseFile( f );
+}
+#endif // BSPC
+
 /*
 ================================================================================
 
@@ -1235,6 +1604,49 @@ TRACE TESTING
 ================================================================================
 */
 
+/*
+====================
+CM_PatchFacetsInBounds
+
+Fills list with the numbers of the facets whose tree leafs the bounds of the
+trace touch, in increasing order, and returns how many there are
+====================
+*/
+static inline int CM_PatchFacetsInBounds( const traceWork_t *tw, const struct patchCollide_s *pc, int *list ) {
+	const patchNode_t	*node;
+	int			i, j, count;
+
+	count = 0;
+	if ( !pc->numNodes ) {
+		for ( i = 0 ; i < pc->numFacets ; i++ ) {
+			list[count++] = i;
+		}
+		return count;
+	}
+
+	i = 0;
+	while ( i < pc->numNodes ) {
+		node = &pc->nodes[i];
+		if ( tw->bounds[0][0] > node->bounds[1][0]
+			|| tw->bounds[0][1] > node->bounds[1][1]
+			|| tw->bounds[0][2] > node->bounds[1][2]
+			|| tw->bounds[1][0] < node->bounds[0][0]
+			|| tw->bounds[1][1] < node->bounds[0][1]
+			|| tw->bounds[1][2] < node->bounds[0][2] ) {
+			i = node->skip;
+			continue;
+		}
+
+		if ( node->numFacets <= PATCH_NODE_FACETS ) {
+			for ( j = 0 ; j < node->numFacets ; j++ ) {
+				list[count++] = node->firstFacet + j;
+			}
+		}
+		i++;
+	}
+	return count;
+}
+
 /*
 ====================
 CM_TracePointThroughPatchCollide
@@ -1248,12 +1660,11 @@ static inline void CM_TracePointThroughPatchCollide( traceWork_t *tw, trace_t &t
 	float		intersect;
 	const patchPlane_t	*planes;
 	const facet_t	*facet;
+	int			facetNums[MAX_FACETS];
+	int			numFacetNums;
 	int			i, j, k;
 	float		offset;
 	float		d1, d2;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
 
 #ifndef BSPC
 	if ( !cm_playerCurveClip->integer || !tw->isPoint ) {
@@ -1261,6 +1672,11 @@ static inline void CM_TracePointThroughPatchCollide( traceWork_t *tw, trace_t &t
 	}
 #endif
 
+	numFacetNums = CM_PatchFacetsInBounds( tw, pc, facetNums );
+	if ( !numFacetNums ) {
+		return;
+	}
+
 	// determine the trace's relationship to all planes
 	planes = pc->planes;
 	for ( i = 0 ; i < pc->numPlanes ; i++, planes++ ) {
@@ -1284,8 +1700,8 @@ static inline void CM_TracePointThroughPatchCollide( traceWork_t *tw, trace_t &t
 
 
 	// see if any of the surface planes are intersected
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
+	for ( i = 0 ; i < numFacetNums ; i++ ) {
+		facet = &pc->facets[ facetNums[i] ];
 		if ( !frontFacing[facet->surfacePlane] ) {
 			continue;
 		}
@@ -1311,10 +1727,8 @@ static inline void CM_TracePointThroughPatchCollide( traceWork_t *tw, trace_t &t
 		if ( j == facet->numBorders ) {
 			// we hit this facet
 #ifndef BSPC
-			if (!cv) {
-				cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-			}
-			if (cv->integer) {
+			// only the main thread's traces update the debug surface
+			if ( cm_debugSurfaceUpdate->integer && tw->context->index == 0 ) {
 				debugPatchCollide = pc;
 				debugFacet = facet;
 			}
@@ -1394,11 +1808,9 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, trace_t &trace, const struct
 	float offset, enterFrac, leaveFrac, t;
 	patchPlane_t *planes;
 	facet_t	*facet;
+	int facetNums[MAX_FACETS], numFacetNums;
 	float plane[4] = { 0.0f }, bestplane[4] = { 0.0f };
 	vec3_t startp, endp;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
 
 #ifndef CULL_BBOX
 	// I'm not sure if test is strictly correct.  Are all
@@ -1417,8 +1829,9 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, trace_t &trace, const struct
 		return;
 	}
 	//
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
+	numFacetNums = CM_PatchFacetsInBounds( tw, pc, facetNums );
+	for ( i = 0 ; i < numFacetNums ; i++ ) {
+		facet = &pc->facets[ facetNums[i] ];
 		enterFrac = -1.0;
 		leaveFrac = 1.0;
 		hitnum = -1;
@@ -1508,10 +1921,7 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, trace_t &trace, const struct
 					enterFrac = 0;
 				}
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
+				if ( cm_debugSurfaceUpdate->integer && tw->context->index == 0 ) {
 					debugPatchCollide = pc;
 					debugFacet = facet;
 				}
@@ -1546,6 +1956,7 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 	float offset, t;
 	patchPlane_t *planes;
 	facet_t	*facet;
+	int facetNums[MAX_FACETS], numFacetNums;
 	float plane[4];
 	vec3_t startp;
 
@@ -1553,8 +1964,9 @@ qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchColli
 		return qfalse;
 	}
 	//
-	facet = pc->facets;
-	for ( i = 0 ; i < pc->numFacets ; i++, facet++ ) {
+	numFacetNums = CM_PatchFacetsInBounds( tw, pc, facetNums );
+	for ( i = 0 ; i < numFacetNums ; i++ ) {
+		facet = &pc->facets[ facetNums[i] ];
 		planes = &pc->planes[ facet->surfacePlane ];
 		VectorCopy(planes->plane, plane);
 		plane[3] = planes->plane[3];
@@ -79,12 +79,25 @@ typedef struct facet_s {
 	qboolean	borderNoAdjust[4+6+16];
 } facet_t;
 
+#define	PATCH_NODE_FACETS	4	// most facets in a leaf of the facet tree
+
+// the facet tree is stored in preorder, each node covering a run of facets in their
+// original order, so a walk visits the facets in the same order as a plain loop
+typedef struct patchNode_s {
+	vec3_t	bounds[2];			// of all the facets below, expanded for epsilons
+	int		firstFacet;
+	int		numFacets;
+	int		skip;				// next node once this one and everything below it is done
+} patchNode_t;
+
 typedef struct patchCollide_s {
 	vec3_t	bounds[2];
 	int		numPlanes;			// surface planes plus edge planes
 	patchPlane_t	*planes;
 	int		numFacets;
 	facet_t	*facets;
+	int		numNodes;			// 0 when there are too few facets for a tree
+	patchNode_t	*nodes;
 } patchCollide_t;
 
 #define	MAX_GRID_SIZE	129
@@ -26,13 +26,23 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "qcommon/q_shared.h"
 #include "qfiles.h"
 
+// traces keep their scratch state in a trace context, traces running on
+// different threads at the same time must each use their own context.
+// The calls without a context argument use context 0, the main thread's.
+typedef struct cmTraceContext_s cmTraceContext_t;
+
+int			CM_NumTraceContexts( void );
+cmTraceContext_t *CM_TraceContext( int index );
+
 void		CM_LoadMap( const char *name, qboolean clientload, int *checksum);
 
 void		CM_ClearMap( void );
 clipHandle_t CM_InlineModel( int index );		// 0 = world, 1 + are bmodels
 clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule );
+clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule, cmTraceContext_t *context );
 
 void		CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs );
+void		CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs, cmTraceContext_t *context );
 
 int			CM_NumInlineModels( void );
 char		*CM_EntityString (void);
@@ -40,11 +50,18 @@ char		*CM_EntityString (void);
 // returns an ORed contents mask
 int			CM_PointContents( const vec3_t p, clipHandle_t model );
 int			CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles );
+int			CM_PointContents( const vec3_t p, clipHandle_t model, cmTraceContext_t *context );
+int			CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles, cmTraceContext_t *context );
 
 void		CM_BoxTrace ( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule );
 void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, const vec3_t origin, const vec3_t angles, int capsule );
+void		CM_BoxTrace ( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, int capsule, cmTraceContext_t *context );
+void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs, clipHandle_t model, int brushmask, const vec3_t origin, const vec3_t angles, int capsule, cmTraceContext_t *context );
+
+void		CM_TraceBench_f( void );
 
 byte		*CM_ClusterPVS (int cluster);
+int			CM_NumClusters (void);
 
 int			CM_PointLeafnum( const vec3_t p );
 
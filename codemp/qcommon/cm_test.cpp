@@ -102,10 +102,9 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum ) {
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cmg.leafbrushes[leaf->firstLeafBrush+k];
 		b = &cmg.brushes[brushnum];
-		if ( b->checkcount == cmg.checkcount ) {
+		if ( CM_BrushChecked( ll->context, &cmg, brushnum ) ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cmg.checkcount;
 		for ( i = 0 ; i < 3 ; i++ ) {
 			if ( b->bounds[0][i] >= ll->bounds[1][i] || b->bounds[1][i] <= ll->bounds[0][i] ) {
 				break;
@@ -175,8 +174,6 @@ int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *boxList, int list
 	//rwwRMG - changed to boxList to not conflict with list type
 	leafList_t	ll;
 
-	cmg.checkcount++;
-
 	VectorCopy( mins, ll.bounds[0] );
 	VectorCopy( maxs, ll.bounds[1] );
 	ll.count = 0;
@@ -185,6 +182,7 @@ int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *boxList, int list
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
+	ll.context = NULL;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
@@ -202,7 +200,7 @@ CM_PointContents
 
 ==================
 */
-int CM_PointContents( const vec3_t p, clipHandle_t model ) {
+int CM_PointContents( const vec3_t p, clipHandle_t model, cmTraceContext_t *context ) {
 	int			leafnum;
 	int			i, k;
 	int			brushnum;
@@ -219,7 +217,7 @@ int CM_PointContents( const vec3_t p, clipHandle_t model ) {
 
 	if ( model )
 	{
-		clipm = CM_ClipHandleToModel( model, &local );
+		clipm = CM_ClipHandleToModel( model, &local, context );
 		if (clipm->firstNode != -1)
 		{
 			leafnum = CM_PointLeafnum_r (p, 0, local);
@@ -261,6 +259,10 @@ int CM_PointContents( const vec3_t p, clipHandle_t model ) {
 	return contents;
 }
 
+int CM_PointContents( const vec3_t p, clipHandle_t model ) {
+	return CM_PointContents( p, model, &cm_traceContexts[0] );
+}
+
 /*
 ==================
 CM_TransformedPointContents
@@ -269,7 +271,7 @@ Handles offseting and rotation of the end points for moving and
 rotating entities
 ==================
 */
-int	CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles) {
+int	CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles, cmTraceContext_t *context ) {
 	vec3_t		p_l;
 	vec3_t		temp;
 	vec3_t		forward, right, up;
@@ -289,7 +291,11 @@ int	CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_
 		p_l[2] = DotProduct (temp, up);
 	}
 
-	return CM_PointContents( p_l, model );
+	return CM_PointContents( p_l, model, context );
+}
+
+int	CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles ) {
+	return CM_TransformedPointContents( p, model, origin, angles, &cm_traceContexts[0] );
 }
 
 
@@ -309,6 +315,10 @@ byte	*CM_ClusterPVS (int cluster) {
 	return cmg.visibility + cluster * cmg.clusterBytes;
 }
 
+int		CM_NumClusters (void) {
+	return cmg.numClusters;
+}
+
 /*
 ===============================================================================
 
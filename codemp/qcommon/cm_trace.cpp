@@ -23,6 +23,12 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "cm_local.h"
 
+#if defined(CM_SIMD_SSE)
+#include <xmmintrin.h>
+#elif defined(CM_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
 // always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 //#define ALWAYS_BBOX_VS_BBOX
 // always use capsule vs. capsule collision and never capsule vs. bbox or vice versa
@@ -213,6 +219,7 @@ void CM_TestInLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *l
 {
 	int			k;
 	int			brushnum;
+	int			surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -220,10 +227,9 @@ void CM_TestInLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *l
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = local->leafbrushes[leaf->firstLeafBrush+k];
 		b = &local->brushes[brushnum];
-		if (b->checkcount == local->checkcount) {
+		if ( CM_BrushChecked( tw->context, local, brushnum ) ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -242,14 +248,14 @@ void CM_TestInLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *l
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( CM_PatchChecked( tw->context, local, surfnum ) ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = local->checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -280,7 +286,7 @@ void CM_TestCapsuleInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t mode
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, r;
 
-	CM_ModelBounds(model, mins, maxs);
+	CM_ModelBounds(model, mins, maxs, tw->context);
 
 	VectorAdd(tw->start, tw->sphere.offset, top);
 	VectorSubtract(tw->start, tw->sphere.offset, bottom);
@@ -348,7 +354,7 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	CM_ModelBounds(model, mins, maxs, tw->context);
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -366,9 +372,9 @@ void CM_TestBoundingBoxInCapsule( traceWork_t *tw, trace_t &trace, clipHandle_t
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse, tw->context);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
+	cmod = CM_ClipHandleToModel( h, NULL, tw->context );
 	CM_TestInLeaf( tw, trace, &cmod->leaf, &cmg );
 }
 
@@ -398,14 +404,10 @@ void CM_PositionTest( traceWork_t *tw, trace_t &trace ) {
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
-
-	cmg.checkcount++;
+	ll.context = tw->context;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
-
-	cmg.checkcount++;
-
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
 		CM_TestInLeaf( tw, trace, &cmg.leafs[leafs[i]], &cmg );
@@ -447,25 +449,19 @@ void CM_TraceThroughPatch( traceWork_t *tw, trace_t &trace, cPatch_t *patch ) {
 
 /*
 ================
-CM_PlaneCollision
+CM_SideCollision
 
-  Returns false for a quick getout
+Clips the trace against one side of a brush given the distances of
+its start and end from the side's expanded plane.
+Returns false for a quick getout
 ================
 */
-
-bool CM_PlaneCollision(traceWork_t *tw, cbrushside_t *side)
+static inline bool CM_SideCollision( traceWork_t *tw, cbrushside_t *side, float d1, float d2 )
 {
-	float			dist, f;
-	float			d1, d2;
+	float			f;
 
 	cplane_t		*plane = side->plane;
 
-	// adjust the plane distance appropriately for mins/maxs
-	dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
-
-	d1 = DotProduct( tw->start, plane->normal ) - dist;
-	d2 = DotProduct( tw->end, plane->normal ) - dist;
-
 	if (d2 > 0.0f)
 	{
 		// endpoint is not in solid
@@ -530,14 +526,165 @@ bool CM_PlaneCollision(traceWork_t *tw, cbrushside_t *side)
 
 /*
 ================
-CM_TraceThroughBrush
+CM_PlaneCollision
+
+  Returns false for a quick getout
 ================
 */
-void CM_TraceThroughBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush, bool infoOnly )
+
+bool CM_PlaneCollision(traceWork_t *tw, cbrushside_t *side)
+{
+	float			dist;
+	float			d1, d2;
+
+	cplane_t		*plane = side->plane;
+
+	// adjust the plane distance appropriately for mins/maxs
+	dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
+
+	d1 = DotProduct( tw->start, plane->normal ) - dist;
+	d2 = DotProduct( tw->end, plane->normal ) - dist;
+
+	return CM_SideCollision( tw, side, d1, d2 );
+}
+
+#ifdef CM_SIMD
+/*
+================
+CM_SideDistances4
+
+Does the plane distance part of CM_PlaneCollision for four sides at once,
+with the same operations in the same order so the results are identical.
+Returns a bit for each side the trace is completely in front of.
+================
+*/
+#if defined(CM_SIMD_SSE)
+static inline int CM_SideDistances4( const traceWork_t *tw, const cbrushSides4_t *sides4, float *d1, float *d2 )
+{
+	__m128	zero = _mm_setzero_ps();
+	__m128	n[3], neg, offset[3], dist, v1, v2, front;
+	int		i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		n[i] = _mm_loadu_ps( sides4->normal[i] );
+
+		// tw->offsets[signbits], the corner of the box that hits the plane first
+		neg = _mm_cmplt_ps( n[i], zero );
+		offset[i] = _mm_or_ps( _mm_and_ps( neg, _mm_set1_ps( tw->size[1][i] ) ), _mm_andnot_ps( neg, _mm_set1_ps( tw->size[0][i] ) ) );
+	}
+
+	dist = _mm_sub_ps( _mm_loadu_ps( sides4->dist ),
+		_mm_add_ps( _mm_add_ps( _mm_mul_ps( offset[0], n[0] ), _mm_mul_ps( offset[1], n[1] ) ), _mm_mul_ps( offset[2], n[2] ) ) );
+
+	v1 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( tw->start[0] ), n[0] ), _mm_mul_ps( _mm_set1_ps( tw->start[1] ), n[1] ) ),
+		_mm_mul_ps( _mm_set1_ps( tw->start[2] ), n[2] ) ), dist );
+	v2 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( tw->end[0] ), n[0] ), _mm_mul_ps( _mm_set1_ps( tw->end[1] ), n[1] ) ),
+		_mm_mul_ps( _mm_set1_ps( tw->end[2] ), n[2] ) ), dist );
+
+	front = _mm_and_ps( _mm_cmpgt_ps( v1, zero ),
+		_mm_or_ps( _mm_cmpge_ps( v2, _mm_set1_ps( SURFACE_CLIP_EPSILON ) ), _mm_cmpge_ps( v2, v1 ) ) );
+
+	_mm_storeu_ps( d1, v1 );
+	_mm_storeu_ps( d2, v2 );
+
+	return _mm_movemask_ps( front );
+}
+#elif defined(CM_SIMD_NEON)
+static inline int CM_SideDistances4( const traceWork_t *tw, const cbrushSides4_t *sides4, float *d1, float *d2 )
+{
+	static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+	float32x4_t	zero = vdupq_n_f32( 0.0f );
+	float32x4_t	n[3], offset[3], dist, v1, v2;
+	uint32x4_t	front;
+	int			i;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		n[i] = vld1q_f32( sides4->normal[i] );
+
+		// tw->offsets[signbits], the corner of the box that hits the plane first
+		offset[i] = vbslq_f32( vcltq_f32( n[i], zero ), vdupq_n_f32( tw->size[1][i] ), vdupq_n_f32( tw->size[0][i] ) );
+	}
+
+	dist = vsubq_f32( vld1q_f32( sides4->dist ),
+		vaddq_f32( vaddq_f32( vmulq_f32( offset[0], n[0] ), vmulq_f32( offset[1], n[1] ) ), vmulq_f32( offset[2], n[2] ) ) );
+
+	v1 = vsubq_f32( vaddq_f32( vaddq_f32( vmulq_n_f32( n[0], tw->start[0] ), vmulq_n_f32( n[1], tw->start[1] ) ),
+		vmulq_n_f32( n[2], tw->start[2] ) ), dist );
+	v2 = vsubq_f32( vaddq_f32( vaddq_f32( vmulq_n_f32( n[0], tw->end[0] ), vmulq_n_f32( n[1], tw->end[1] ) ),
+		vmulq_n_f32( n[2], tw->end[2] ) ), dist );
+
+	front = vandq_u32( vcgtq_f32( v1, zero ),
+		vorrq_u32( vcgeq_f32( v2, vdupq_n_f32( SURFACE_CLIP_EPSILON ) ), vcgeq_f32( v2, v1 ) ) );
+
+	vst1q_f32( d1, v1 );
+	vst1q_f32( d2, v2 );
+
+	return (int)vaddvq_u32( vandq_u32( front, vld1q_u32( laneBits ) ) );
+}
+#endif
+
+static qboolean	cm_benchNoSimd;		// set by CM_TraceBench_f for its scalar runs
+#endif // CM_SIMD
+
+/*
+================
+CM_BrushCollision
+
+Clips the trace against all sides of the brush, finding the latest time
+the trace crosses a plane towards the interior and the earliest time the
+trace crosses a plane towards the exterior.
+Returns false for a quick getout
+================
+*/
+static bool CM_BrushCollision( traceWork_t *tw, cbrush_t *brush )
 {
 	int				i;
-	cbrushside_t	*side;
 
+#ifdef CM_SIMD
+#ifdef BSPC
+	if ( !cm_benchNoSimd ) {
+#else
+	if ( !cm_noSimd->integer && !cm_benchNoSimd ) {
+#endif
+		float	d1[4], d2[4];
+		int		j, count;
+
+		for ( i = 0 ; i < brush->numsides ; i += 4 )
+		{
+			count = brush->numsides - i < 4 ? brush->numsides - i : 4;
+
+			// if completely in front of any face, the earlier ones don't matter
+			if ( CM_SideDistances4( tw, &brush->sides4[i >> 2], d1, d2 ) & ( ( 1 << count ) - 1 ) )
+			{
+				return(false);
+			}
+
+			for ( j = 0 ; j < count ; j++ )
+			{
+				CM_SideCollision( tw, brush->sides + i + j, d1[j], d2[j] );
+			}
+		}
+		return(true);
+	}
+#endif
+
+	for (i = 0; i < brush->numsides; i++)
+	{
+		if(!CM_PlaneCollision(tw, brush->sides + i))
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/*
+================
+CM_TraceThroughBrush
+================
+*/
+void CM_TraceThroughBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush, bool infoOnly )
+{
 	tw->enterFrac = -1.0f;
 	tw->leaveFrac = 1.0f;
 	tw->clipplane = NULL;
@@ -566,17 +713,10 @@ void CM_TraceThroughBrush( traceWork_t *tw, trace_t &trace, cbrush_t *brush, boo
 
 	//
 	// compare the trace against all planes of the brush
-	// find the latest time the trace crosses a plane towards the interior
-	// and the earliest time the trace crosses a plane towards the exterior
 	//
-	for (i = 0; i < brush->numsides; i++)
+	if ( !CM_BrushCollision( tw, brush ) )
 	{
-		side = brush->sides + i;
-
-		if(!CM_PlaneCollision(tw, side))
-		{
-			return;
-		}
+		return;
 	}
 
 	//
@@ -651,6 +791,7 @@ CM_TraceThroughLeaf
 void CM_TraceThroughLeaf( traceWork_t *tw, trace_t &trace, clipMap_t *local, cLeaf_t *leaf ) {
 	int			k;
 	int			brushnum;
+	int			surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -659,10 +800,9 @@ void CM_TraceThroughLeaf( traceWork_t *tw, trace_t &trace, clipMap_t *local, cLe
 		brushnum = local->leafbrushes[leaf->firstLeafBrush+k];
 
 		b = &local->brushes[brushnum];
-		if ( b->checkcount == local->checkcount ) {
+		if ( CM_BrushChecked( tw->context, local, brushnum ) ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
 
 		if ( !(b->contents & tw->contents) ) {
 			continue;
@@ -682,14 +822,14 @@ void CM_TraceThroughLeaf( traceWork_t *tw, trace_t &trace, clipMap_t *local, cLe
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( CM_PatchChecked( tw->context, local, surfnum ) ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = local->checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -910,7 +1050,7 @@ void CM_TraceCapsuleThroughCapsule( traceWork_t *tw, trace_t &trace, clipHandle_
 	vec3_t offset, symetricSize[2];
 	float radius, halfwidth, halfheight, offs, h;
 
-	CM_ModelBounds(model, mins, maxs);
+	CM_ModelBounds(model, mins, maxs, tw->context);
 	// test trace bounds vs. capsule bounds
 	if ( tw->bounds[0][0] > maxs[0] + RADIUS_EPSILON
 		|| tw->bounds[0][1] > maxs[1] + RADIUS_EPSILON
@@ -972,7 +1112,7 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, trace_t &trace, clipHan
 	int i;
 
 	// mins maxs of the capsule
-	CM_ModelBounds(model, mins, maxs);
+	CM_ModelBounds(model, mins, maxs, tw->context);
 
 	// offset for capsule center
 	for ( i = 0 ; i < 3 ; i++ ) {
@@ -990,9 +1130,9 @@ void CM_TraceBoundingBoxThroughCapsule( traceWork_t *tw, trace_t &trace, clipHan
 	VectorSet( tw->sphere.offset, 0, 0, size[1][2] - tw->sphere.radius );
 
 	// replace the capsule with the bounding box
-	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse);
+	h = CM_TempBoxModel(tw->size[0], tw->size[1], qfalse, tw->context);
 	// calculate collision
-	cmod = CM_ClipHandleToModel( h );
+	cmod = CM_ClipHandleToModel( h, NULL, tw->context );
 	CM_TraceThroughLeaf( tw, trace, &cmg, &cmod->leaf );
 }
 
@@ -1007,6 +1147,7 @@ void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *
 {
 	int			k;
 	int			brushnum;
+	int			surfnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -1016,11 +1157,10 @@ void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *
 		brushnum = local->leafbrushes[leaf->firstLeafBrush + k];
 
 		b = &local->brushes[brushnum];
-		if ( b->checkcount == local->checkcount )
+		if ( CM_BrushChecked( tw->context, local, brushnum ) )
 		{
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = local->checkcount;
 
 		if ( !(b->contents & tw->contents) )
 		{
@@ -1041,14 +1181,14 @@ void CM_TraceToLeaf( traceWork_t *tw, trace_t &trace, cLeaf_t *leaf, clipMap_t *
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = local->surfaces[ local->leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			surfnum = local->leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = local->surfaces[ surfnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == local->checkcount ) {
+			if ( CM_PatchChecked( tw->context, local, surfnum ) ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = local->checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -1216,16 +1356,17 @@ CM_Trace
 */
 void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 						  const vec3_t mins, const vec3_t maxs,
-						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
+						  clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere,
+						  cmTraceContext_t *context ) {
 	int			i;
 	traceWork_t	tw;
 	vec3_t		offset;
 	cmodel_t	*cmod;
 	clipMap_t	*local = 0;
 
-	cmod = CM_ClipHandleToModel( model, &local );
+	cmod = CM_ClipHandleToModel( model, &local, context );
 
-	local->checkcount++;		// for multi-check avoidance
+	context->checkcount++;		// for multi-check avoidance
 
 	c_traces++;				// for statistics, may be zeroed
 
@@ -1234,6 +1375,7 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 	memset(trace, 0, sizeof(*trace));
 	trace->fraction = 1;	// assume it goes the entire distance until shown otherwise
 	VectorCopy(origin, tw.modelOrigin);
+	tw.context = context;
 
 	if (!local->numNodes) {
 		return;	// map not loaded, shouldn't happen
@@ -1461,10 +1603,16 @@ void CM_Trace( trace_t *trace, const vec3_t start, const vec3_t end,
 CM_BoxTrace
 ==================
 */
+void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  clipHandle_t model, int brushmask, int capsule, cmTraceContext_t *context ) {
+	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL, context );
+}
+
 void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 						  const vec3_t mins, const vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule ) {
-	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
+	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL, &cm_traceContexts[0] );
 }
 
 /*
@@ -1478,7 +1626,7 @@ rotating entities
 void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t end,
 						  const vec3_t mins, const vec3_t maxs,
 						  clipHandle_t model, int brushmask,
-						  const vec3_t origin, const vec3_t angles, int capsule ) {
+						  const vec3_t origin, const vec3_t angles, int capsule, cmTraceContext_t *context ) {
 	vec3_t		start_l, end_l;
 	qboolean	rotated;
 	vec3_t		offset;
@@ -1548,7 +1696,7 @@ void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t en
 	}
 
 	// sweep the box through the model
-	CM_Trace( trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere );
+	CM_Trace( trace, start_l, end_l, symetricSize[0], symetricSize[1], model, origin, brushmask, capsule, &sphere, context );
 
 	// if the bmodel was rotated and there was a collision
 	if ( rotated && trace->fraction != 1.0 ) {
@@ -1564,6 +1712,13 @@ void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t en
 	trace->endpos[2] = start[2] + trace->fraction * (end[2] - start[2]);
 }
 
+void CM_TransformedBoxTrace( trace_t *trace, const vec3_t start, const vec3_t end,
+						  const vec3_t mins, const vec3_t maxs,
+						  clipHandle_t model, int brushmask,
+						  const vec3_t origin, const vec3_t angles, int capsule ) {
+	CM_TransformedBoxTrace( trace, start, end, mins, maxs, model, brushmask, origin, angles, capsule, &cm_traceContexts[0] );
+}
+
 /*
 =================
 CM_CullBox
@@ -1618,3 +1773,93 @@ bool CM_CullWorldBox (const cplane_t *frustum, const vec3pair_t bounds)
 
 	return(CM_CullBox(frustum, transformed));
 }
+
+/*
+=================
+CM_TraceBench_f
+
+Traces the same random points and player sized boxes through the world
+with the brush sides tested one at a time and four at a time, checks
+that both give the same results and reports the times
+=================
+*/
+void CM_TraceBench_f( void ) {
+#ifdef CM_SIMD
+	static const vec3_t	boxMins = { -15, -15, -24 }, boxMaxs = { 15, 15, 40 };
+	int			i, j, pass, count, rounds, seed, hits, mismatches;
+	int			start, msec[2];
+	vec3_t		*points;
+	trace_t		*results[2];
+	cmodel_t	*world;
+
+	if ( !cmg.numNodes ) {
+		Com_Printf( "No map loaded.\n" );
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? Com_Clampi( 1, 1000000, atoi( Cmd_Argv( 1 ) ) ) : 20000;
+	rounds = Cmd_Argc() > 2 ? Com_Clampi( 1, 1000, atoi( Cmd_Argv( 2 ) ) ) : 5;
+
+	points = (vec3_t *)Z_Malloc( count * 2 * sizeof( *points ), TAG_TEMP_WORKSPACE );
+	results[0] = (trace_t *)Z_Malloc( count * sizeof( trace_t ), TAG_TEMP_WORKSPACE );
+	results[1] = (trace_t *)Z_Malloc( count * sizeof( trace_t ), TAG_TEMP_WORKSPACE );
+
+	// the same set every time, starting outside of solids where one can be found
+	world = &cmg.cmodels[0];
+	seed = 0x5eed;
+	for ( i = 0 ; i < count ; i++ ) {
+		float *p = points[i*2], *end = points[i*2+1];
+
+		for ( j = 0 ; j < 16 ; j++ ) {
+			p[0] = world->mins[0] + Q_random( &seed ) * ( world->maxs[0] - world->mins[0] );
+			p[1] = world->mins[1] + Q_random( &seed ) * ( world->maxs[1] - world->mins[1] );
+			p[2] = world->mins[2] + Q_random( &seed ) * ( world->maxs[2] - world->mins[2] );
+			if ( !( CM_PointContents( p, 0 ) & ( CONTENTS_SOLID|CONTENTS_PLAYERCLIP ) ) ) {
+				break;
+			}
+		}
+		end[0] = p[0] + Q_crandom( &seed ) * 1024;
+		end[1] = p[1] + Q_crandom( &seed ) * 1024;
+		end[2] = p[2] + Q_crandom( &seed ) * 256;
+	}
+
+	// one side at a time first, then four
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		cm_benchNoSimd = pass ? qfalse : qtrue;
+		start = Sys_Milliseconds();
+		for ( j = 0 ; j < rounds ; j++ ) {
+			for ( i = 0 ; i < count ; i++ ) {
+				if ( i & 1 ) {
+					CM_BoxTrace( &results[pass][i], points[i*2], points[i*2+1], boxMins, boxMaxs, 0, CONTENTS_SOLID|CONTENTS_PLAYERCLIP, qfalse );
+				} else {
+					CM_BoxTrace( &results[pass][i], points[i*2], points[i*2+1], NULL, NULL, 0, CONTENTS_SOLID|CONTENTS_SHOTCLIP, qfalse );
+				}
+			}
+		}
+		msec[pass] = Sys_Milliseconds() - start;
+	}
+	cm_benchNoSimd = qfalse;
+
+	hits = mismatches = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( results[0][i].fraction < 1.0f ) {
+			hits++;
+		}
+		if ( memcmp( &results[0][i], &results[1][i], sizeof( trace_t ) ) ) {
+			mismatches++;
+		}
+	}
+
+	if ( mismatches ) {
+		Com_Printf( S_COLOR_YELLOW "%i of %i traces differ between one and four sides at a time\n", mismatches, count );
+	}
+	Com_Printf( "%i traces x %i rounds, %i hit: %i msec one side at a time, %i msec four at a time\n",
+		count, rounds, hits, msec[0], msec[1] );
+
+	Z_Free( results[1] );
+	Z_Free( results[0] );
+	Z_Free( points );
+#else
+	Com_Printf( "Brush sides are only tested one at a time on this platform.\n" );
+#endif
+}
@@ -27,6 +27,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "stringed_ingame.h"
 #include "qcommon/cm_public.h"
 #include "qcommon/game_version.h"
+#include "qcommon/jobs.h"
 #include "qcommon/q_version.h"
 #include "../server/NPCNav/navigator.h"
 #include "../shared/sys/sys_local.h"
@@ -35,6 +36,8 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include <windows.h>
 #endif
 
+#include <mutex>
+
 FILE *debuglogfile;
 fileHandle_t logfile;
 fileHandle_t	com_journalFile;			// events are written here
@@ -117,6 +120,8 @@ void Com_EndRedirect (void)
 	rd_flush = NULL;
 }
 
+static std::recursive_mutex com_printLock;
+
 /*
 =============
 Com_Printf
@@ -137,6 +142,9 @@ void QDECL Com_Printf( const char *fmt, ... ) {
 	Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
 	va_end (argptr);
 
+	// job threads may print too
+	std::lock_guard<std::recursive_mutex> lock( com_printLock );
+
 	if ( rd_buffer ) {
 		if ((strlen (msg) + strlen(rd_buffer)) > (size_t)(rd_buffersize - 1)) {
 			rd_flush(rd_buffer);
@@ -280,6 +288,17 @@ void NORETURN QDECL Com_Error( int code, const char *fmt, ... ) {
 	static int	errorCount;
 	int			currentTime;
 
+	// hand errors raised inside a job batch back to the thread that started it
+	if ( Com_JobsActive() ) {
+		char msg[MAXPRINTMSG];
+
+		va_start (argptr,fmt);
+		Q_vsnprintf (msg, sizeof(msg), fmt, argptr);
+		va_end (argptr);
+
+		Com_JobError( code, msg );
+	}
+
 	if ( com_errorEntered ) {
 		Sys_Error( "recursive error after: %s", com_errorMessage );
 	}
@@ -1199,6 +1218,8 @@ void Com_Init( char *commandLine ) {
 		// Init network before filesystem
 		NET_Init();
 
+		Com_StartupJobs();
+
 		FS_InitFilesystem ();
 
 		Com_InitJournaling();
@@ -1208,6 +1229,7 @@ void Com_Init( char *commandLine ) {
 			Cmd_AddCommand ("error", Com_Error_f);
 			Cmd_AddCommand ("crash", Com_Crash_f );
 			Cmd_AddCommand ("freeze", Com_Freeze_f);
+			Cmd_AddCommand ("huffmanBench", MSG_HuffmanBench_f, "Times the netchan huffman coding" );
 		}
 		Cmd_AddCommand ("quit", Com_Quit_f, "Quits the game" );
 #ifndef FINAL_BUILD
@@ -1286,6 +1308,8 @@ void Com_Init( char *commandLine ) {
 
 		Sys_SetProcessorAffinity();
 
+		Com_InitJobs();
+
 		// Pick a random port value
 		Com_RandomBytes( (byte*)&qport, sizeof(int) );
 		Netchan_Init( qport & 0xffff );	// pick a port value that should be nice and random
@@ -1712,6 +1736,8 @@ void Com_Shutdown (void)
 		com_journalFile = 0;
 	}
 
+	Com_ShutdownJobs();
+
 	MSG_shutdownHuffman();
 /*
 	// Only used for testing changes to huffman frequency table when tuning.
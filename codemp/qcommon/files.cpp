@@ -31,6 +31,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
 #include "qcommon/qcommon.h"
+#include "qcommon/jobs.h"
 
 #ifndef DEDICATED
 #ifndef FINAL_BUILD
@@ -192,6 +193,7 @@ or configs will never get loaded from disk!
 #define MAX_ZPATH			256
 #define	MAX_SEARCH_PATHS	4096
 #define MAX_FILEHASH_SIZE	1024
+#define MAX_INDEXHASH_SIZE	65536
 
 typedef struct fileInPack_s {
 	char					*name;		// name of the file
@@ -200,12 +202,19 @@ typedef struct fileInPack_s {
 	struct	fileInPack_s*	next;		// next file in the hash
 } fileInPack_t;
 
+// a pk3 mapped into memory, shared by every minizip handle opened on it
+typedef struct pakMap_s {
+	const byte		*base;
+	int				length;
+} pakMap_t;
+
 typedef struct pack_s {
 	char			pakPathname[MAX_OSPATH];	// c:\jediacademy\gamedata\base
 	char			pakFilename[MAX_OSPATH];	// c:\jediacademy\gamedata\base\assets0.pk3
 	char			pakBasename[MAX_OSPATH];	// assets0
 	char			pakGamename[MAX_OSPATH];	// base
 	unzFile			handle;						// handle to zip file
+	pakMap_t		*map;						// NULL when the pk3 is read through stdio
 	int				checksum;					// regular checksum
 	int				pure_checksum;				// checksum for pure
 	int				numfiles;					// number of files in pk3
@@ -227,8 +236,18 @@ typedef struct searchpath_s {
 
 	pack_t		*pack;		// only one of pack / dir will be non NULL
 	directory_t	*dir;
+
+	int			order;		// position in fs_searchpaths, set by FS_BuildFileIndex
+	struct searchpath_s *nextDir;	// next directory element after this one
 } searchpath_t;
 
+// every pk3 entry of every search path in one hash, see FS_BuildFileIndex
+typedef struct fileIndex_s {
+	fileInPack_t		*pakFile;
+	searchpath_t		*search;
+	struct fileIndex_s	*next;		// next entry in the hash, in search order
+} fileIndex_t;
+
 static char		fs_gamedir[MAX_OSPATH];	// this will be a single file name with no separators
 static cvar_t		*fs_debug;
 static cvar_t		*fs_homepath;
@@ -245,7 +264,12 @@ static cvar_t		*fs_copyfiles;
 static cvar_t		*fs_gamedirvar;
 static cvar_t		*fs_dirbeforepak; //rww - when building search path, keep directories at top and insert pk3's under them
 static cvar_t		*fs_forcegame;
+static cvar_t		*fs_mapPaks;
 static searchpath_t	*fs_searchpaths;
+static int			fs_indexHashSize;
+static fileIndex_t	**fs_indexTable;		// NULL until built, and again whenever the search paths change
+static fileIndex_t	*fs_indexEntries;
+static searchpath_t	*fs_firstDir;
 static int			fs_readCount;			// total bytes read
 static int			fs_loadCount;			// total files read
 static int			fs_packFiles = 0;		// total number of files in packs
@@ -270,11 +294,14 @@ typedef struct fileHandleData_s {
 	int			zipFilePos;
 	int			zipFileLen;
 	qboolean	zipFile;
+	const pakMap_t	*zipMap;		// mapping of the pk3 the file is in, if it has one
 	char		name[MAX_ZPATH];
 } fileHandleData_t;
 
 static fileHandleData_t	fsh[MAX_FILE_HANDLES];
 
+static unzFile FS_OpenPak( const char *zipfile, const pakMap_t *map );
+
 // TTimo - https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=540
 // wether we did a reorder on the current search path when joining the server
 static qboolean fs_reordered = qfalse;
@@ -403,7 +430,7 @@ static fileHandle_t FS_HandleForFile(void) {
 	return 0;
 }
 
-static FILE	*FS_FileForHandle( fileHandle_t f ) {
+FILE	*FS_FileForHandle( fileHandle_t f ) {
 	if ( f < 1 || f >= MAX_FILE_HANDLES ) {
 		Com_Error( ERR_DROP, "FS_FileForHandle: out of range" );
 	}
@@ -1299,6 +1326,161 @@ bool FS_FileCacheable(const char* const filename)
 	return( strchr(filename, '/') != 0 );
 }
 
+/*
+=================
+FS_FreeFileIndex
+=================
+*/
+static void FS_FreeFileIndex( void ) {
+	if ( fs_indexTable ) {
+		Z_Free( fs_indexTable );
+		fs_indexTable = NULL;
+	}
+	if ( fs_indexEntries ) {
+		Z_Free( fs_indexEntries );
+		fs_indexEntries = NULL;
+	}
+	fs_indexHashSize = 0;
+	fs_firstDir = NULL;
+}
+
+/*
+=================
+FS_BuildFileIndex
+
+Merges the hash tables of all the paks on the search path into one, so a
+lookup is a single probe instead of one per pak. Entries with the same name
+stay in search order; the pure check is left to the lookup because the
+server pak list can change without the search path changing. Directories
+are not indexed, files get written into them at any time, they are only
+chained together so a lookup can walk them without touching the paks.
+=================
+*/
+static void FS_BuildFileIndex( void ) {
+	searchpath_t	*search, *from, *p;
+	fileIndex_t		**tails;
+	fileIndex_t		*entry;
+	fileInPack_t	*pakFile;
+	int				numEntries;
+	int				order;
+	int				i;
+	long			hash;
+
+	FS_FreeFileIndex();
+
+	numEntries = 0;
+	order = 0;
+	from = fs_searchpaths;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		search->order = order++;
+		search->nextDir = NULL;
+
+		if ( search->pack ) {
+			for ( i = 0 ; i < search->pack->hashSize ; i++ ) {
+				for ( pakFile = search->pack->hashTable[i] ; pakFile ; pakFile = pakFile->next ) {
+					numEntries++;
+				}
+			}
+		} else if ( search->dir ) {
+			if ( !fs_firstDir ) {
+				fs_firstDir = search;
+			}
+			for ( p = from ; p != search ; p = p->next ) {
+				p->nextDir = search;
+			}
+			from = search;
+		}
+	}
+
+	for ( fs_indexHashSize = 1 ; fs_indexHashSize < MAX_INDEXHASH_SIZE ; fs_indexHashSize <<= 1 ) {
+		if ( fs_indexHashSize > numEntries ) {
+			break;
+		}
+	}
+
+	fs_indexTable = (fileIndex_t **)Z_Malloc( fs_indexHashSize * sizeof( *fs_indexTable ), TAG_FILESYS, qtrue );
+	fs_indexEntries = (fileIndex_t *)Z_Malloc( ( numEntries ? numEntries : 1 ) * sizeof( *fs_indexEntries ), TAG_FILESYS, qtrue );
+	tails = (fileIndex_t **)Z_Malloc( fs_indexHashSize * sizeof( *tails ), TAG_FILESYS, qtrue );
+
+	entry = fs_indexEntries;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( !search->pack ) {
+			continue;
+		}
+		for ( i = 0 ; i < search->pack->hashSize ; i++ ) {
+			for ( pakFile = search->pack->hashTable[i] ; pakFile ; pakFile = pakFile->next ) {
+				hash = FS_HashFileName( pakFile->name, fs_indexHashSize );
+				entry->pakFile = pakFile;
+				entry->search = search;
+				entry->next = NULL;
+				if ( tails[hash] ) {
+					tails[hash]->next = entry;
+				} else {
+					fs_indexTable[hash] = entry;
+				}
+				tails[hash] = entry;
+				entry++;
+			}
+		}
+	}
+
+	Z_Free( tails );
+}
+
+/*
+=================
+FS_IndexLookup
+
+Returns the pak entry that takes precedence for filename, or NULL when no
+pak on the search path has it
+=================
+*/
+static const fileIndex_t *FS_IndexLookup( const char *filename, qboolean pureOnly ) {
+	const fileIndex_t	*entry;
+
+	if ( !fs_indexTable ) {
+		FS_BuildFileIndex();
+	}
+
+	for ( entry = fs_indexTable[FS_HashFileName( filename, fs_indexHashSize )] ; entry ; entry = entry->next ) {
+		// case and separator insensitive comparisons
+		if ( FS_FilenameCompare( entry->pakFile->name, filename ) ) {
+			continue;
+		}
+		// disregard if it doesn't match one of the allowed pure pak files
+		if ( pureOnly && !FS_PakIsPure( entry->search->pack ) ) {
+			continue;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+/*
+=================
+FS_FirstLookupPath / FS_NextLookupPath
+
+Walk the directories that come before the pak found by FS_IndexLookup,
+then that pak itself, skipping every other pak on the search path
+=================
+*/
+static searchpath_t *FS_FirstLookupPath( const fileIndex_t *found ) {
+	if ( fs_firstDir && ( !found || fs_firstDir->order < found->search->order ) ) {
+		return fs_firstDir;
+	}
+	return found ? found->search : NULL;
+}
+
+static searchpath_t *FS_NextLookupPath( const searchpath_t *search, const fileIndex_t *found ) {
+	if ( found && search == found->search ) {
+		return NULL;
+	}
+	if ( search->nextDir && ( !found || search->nextDir->order < found->search->order ) ) {
+		return search->nextDir;
+	}
+	return found ? found->search : NULL;
+}
+
 /*
 ===========
 FS_FOpenFileRead
@@ -1317,14 +1499,12 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 	pack_t			*pak;
 	fileInPack_t	*pakFile;
 	directory_t		*dir;
-	long			hash;
+	const fileIndex_t	*found;
 	//unz_s			*zfi;
 	//void			*temp;
 	int				l;
 	bool			isUserConfig = false;
 
-	hash = 0;
-
 	FS_AssertInitialised();
 
 	if ( file == NULL ) {
@@ -1357,6 +1537,9 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 
 	isUserConfig = !Q_stricmp( filename, "autoexec.cfg" ) || !Q_stricmp( filename, Q3CONFIG_CFG );
 
+	// autoexec.cfg and openjk.cfg can only be loaded outside of pk3 files.
+	found = isUserConfig ? NULL : FS_IndexLookup( filename, qtrue );
+
 	//
 	// search through the path, one element at a time
 	//
@@ -1375,133 +1558,112 @@ long FS_FOpenFileRead( const char *filename, fileHandle_t *file, qboolean unique
 	{
 		bFasterToReOpenUsingNewLocalFile = qfalse;
 
-		for ( search = fs_searchpaths ; search ; search = search->next ) {
-			//
+		for ( search = FS_FirstLookupPath( found ) ; search ; search = FS_NextLookupPath( search, found ) ) {
+			// the only pak left in the walk is the one the index picked
 			if ( search->pack ) {
-				hash = FS_HashFileName(filename, search->pack->hashSize);
-			}
-			// is the element a pak file?
-			if ( search->pack && search->pack->hashTable[hash] ) {
-				// disregard if it doesn't match one of the allowed pure pak files
-				if ( !FS_PakIsPure(search->pack) ) {
-					continue;
-				}
-
-				// autoexec.cfg and openjk.cfg can only be loaded outside of pk3 files.
-				if ( isUserConfig ) {
-					continue;
-				}
-
-				// look through all the pak file elements
 				pak = search->pack;
-				pakFile = pak->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-
-						// mark the pak as having been referenced and mark specifics on cgame and ui
-						// shaders, txt, arena files  by themselves do not count as a reference as
-						// these are loaded from all pk3s
-						// from every pk3 file..
-
-						// The x86.dll suffixes are needed in order for sv_pure to continue to
-						// work on non-x86/windows systems...
-
-						// reference lists
-						if ( !pak->noref ) {
-							// JK2MV automatically references pk3's in three cases:
-							// 1. A .bsp file is loaded from it (and thus it is expected to be a map)
-							// 2. cgame.qvm or ui.qvm is loaded from it (expected to be a clientside)
-							// 3. pk3 is located in fs_game != base (standard jk2 behavior)
-							// All others need to be referenced manually by the use of reflists.
-
-							if (!Q_stricmp(get_filename_ext(filename), "bsp")) {
-								pak->referenced |= FS_GENERAL_REF;
-							}
+				pakFile = found->pakFile;
+
+				// mark the pak as having been referenced and mark specifics on cgame and ui
+				// shaders, txt, arena files  by themselves do not count as a reference as
+				// these are loaded from all pk3s
+				// from every pk3 file..
+
+				// The x86.dll suffixes are needed in order for sv_pure to continue to
+				// work on non-x86/windows systems...
+
+				// reference lists
+				if ( !pak->noref ) {
+					// JK2MV automatically references pk3's in three cases:
+					// 1. A .bsp file is loaded from it (and thus it is expected to be a map)
+					// 2. cgame.qvm or ui.qvm is loaded from it (expected to be a clientside)
+					// 3. pk3 is located in fs_game != base (standard jk2 behavior)
+					// All others need to be referenced manually by the use of reflists.
+
+					if (!Q_stricmp(get_filename_ext(filename), "bsp")) {
+						pak->referenced |= FS_GENERAL_REF;
+					}
 
-							if (!Q_stricmp(filename, "vm/cgame.qvm") || !Q_stricmp( filename, "cgamex86.dll" )) {
-								pak->referenced |= FS_CGAME_REF;
-							}
+					if (!Q_stricmp(filename, "vm/cgame.qvm") || !Q_stricmp( filename, "cgamex86.dll" )) {
+						pak->referenced |= FS_CGAME_REF;
+					}
 
-							if (!Q_stricmp(filename, "vm/ui.qvm") || !Q_stricmp( filename, "uix86.dll" )) {
-								pak->referenced |= FS_UI_REF;
-							}
+					if (!Q_stricmp(filename, "vm/ui.qvm") || !Q_stricmp( filename, "uix86.dll" )) {
+						pak->referenced |= FS_UI_REF;
+					}
 
-							// OLD Ref:
-							/*
-							l = strlen( filename );
-							if ( !(pak->referenced & FS_GENERAL_REF)) {
-								if( !FS_IsExt(filename, ".shader", l) &&
-								    !FS_IsExt(filename, ".txt", l) &&
-								    !FS_IsExt(filename, ".str", l) &&
-								    !FS_IsExt(filename, ".cfg", l) &&
-								    !FS_IsExt(filename, ".config", l) &&
-								    !FS_IsExt(filename, ".bot", l) &&
-								    !FS_IsExt(filename, ".arena", l) &&
-								    !FS_IsExt(filename, ".menu", l) &&
-								    !FS_IsExt(filename, ".fcf", l) &&
-								    Q_stricmp(filename, "jampgamex86.dll") != 0 &&
-								    //Q_stricmp(filename, "vm/qagame.qvm") != 0 &&
-								    !strstr(filename, "levelshots"))
-								{
-									pak->referenced |= FS_GENERAL_REF;
-								}
-							}
-							*/
+					// OLD Ref:
+					/*
+					l = strlen( filename );
+					if ( !(pak->referenced & FS_GENERAL_REF)) {
+						if( !FS_IsExt(filename, ".shader", l) &&
+						    !FS_IsExt(filename, ".txt", l) &&
+						    !FS_IsExt(filename, ".str", l) &&
+						    !FS_IsExt(filename, ".cfg", l) &&
+						    !FS_IsExt(filename, ".config", l) &&
+						    !FS_IsExt(filename, ".bot", l) &&
+						    !FS_IsExt(filename, ".arena", l) &&
+						    !FS_IsExt(filename, ".menu", l) &&
+						    !FS_IsExt(filename, ".fcf", l) &&
+						    Q_stricmp(filename, "jampgamex86.dll") != 0 &&
+						    //Q_stricmp(filename, "vm/qagame.qvm") != 0 &&
+						    !strstr(filename, "levelshots"))
+						{
+							pak->referenced |= FS_GENERAL_REF;
 						}
+					}
+					*/
+				}
 
-						if ( uniqueFILE ) {
-							// open a new file on the pakfile
-							fsh[*file].handleFiles.file.z = unzOpen (pak->pakFilename);
-							if (fsh[*file].handleFiles.file.z == NULL) {
-								Com_Error (ERR_FATAL, "Couldn't open %s", pak->pakFilename);
-							}
-						} else {
-							fsh[*file].handleFiles.file.z = pak->handle;
-						}
-						Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
-						fsh[*file].zipFile = qtrue;
+				if ( uniqueFILE ) {
+					// open a new file on the pakfile
+					fsh[*file].handleFiles.file.z = FS_OpenPak( pak->pakFilename, pak->map );
+					if (fsh[*file].handleFiles.file.z == NULL) {
+						Com_Error (ERR_FATAL, "Couldn't open %s", pak->pakFilename);
+					}
+				} else {
+					fsh[*file].handleFiles.file.z = pak->handle;
+				}
+				Q_strncpyz( fsh[*file].name, filename, sizeof( fsh[*file].name ) );
+				fsh[*file].zipFile = qtrue;
+				fsh[*file].zipMap = pak->map;
 
-						// set the file position in the zip file (also sets the current file info)
-						unzSetOffset(fsh[*file].handleFiles.file.z, pakFile->pos);
+				// set the file position in the zip file (also sets the current file info)
+				unzSetOffset(fsh[*file].handleFiles.file.z, pakFile->pos);
 
-						// open the file in the zip
-						unzOpenCurrentFile(fsh[*file].handleFiles.file.z);
+				// open the file in the zip
+				unzOpenCurrentFile(fsh[*file].handleFiles.file.z);
 
 #if 0
-						zfi = (unz_s *)fsh[*file].handleFiles.file.z;
-						// in case the file was new
-						temp = zfi->filestream;
-						// set the file position in the zip file (also sets the current file info)
-						unzSetOffset(pak->handle, pakFile->pos);
-						// copy the file info into the unzip structure
-						Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
-						// we copy this back into the structure
-						zfi->filestream = temp;
-						// open the file in the zip
-						unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
+				zfi = (unz_s *)fsh[*file].handleFiles.file.z;
+				// in case the file was new
+				temp = zfi->filestream;
+				// set the file position in the zip file (also sets the current file info)
+				unzSetOffset(pak->handle, pakFile->pos);
+				// copy the file info into the unzip structure
+				Com_Memcpy( zfi, pak->handle, sizeof(unz_s) );
+				// we copy this back into the structure
+				zfi->filestream = temp;
+				// open the file in the zip
+				unzOpenCurrentFile( fsh[*file].handleFiles.file.z );
 #endif
-						fsh[*file].zipFilePos = pakFile->pos;
-						fsh[*file].zipFileLen = pakFile->len;
+				fsh[*file].zipFilePos = pakFile->pos;
+				fsh[*file].zipFileLen = pakFile->len;
 
-						if ( fs_debug->integer ) {
-							Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
-								filename, pak->pakFilename );
-						}
+				if ( fs_debug->integer ) {
+					Com_Printf( "FS_FOpenFileRead: %s (found in '%s')\n",
+						filename, pak->pakFilename );
+				}
 	#ifndef DEDICATED
 	#ifndef FINAL_BUILD
-						// Check for unprecached files when in game but not in the menus
-						if((cls.state == CA_ACTIVE) && !(Key_GetCatcher( ) & KEYCATCH_UI))
-						{
-							Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
-						}
+				// Check for unprecached files when in game but not in the menus
+				if((cls.state == CA_ACTIVE) && !(Key_GetCatcher( ) & KEYCATCH_UI))
+				{
+					Com_Printf(S_COLOR_YELLOW "WARNING: File %s not precached\n", filename);
+				}
 	#endif
 	#endif // DEDICATED
-						return pakFile->len;
-					}
-					pakFile = pakFile->next;
-				} while(pakFile != NULL);
+				return pakFile->len;
 			} else if ( search->dir ) {
 				// check a file in the directory tree
 
@@ -1881,10 +2043,7 @@ CONVENIENCE FUNCTIONS FOR ENTIRE FILES
 */
 
 int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
-	searchpath_t	*search;
-	pack_t			*pak;
-	fileInPack_t	*pakFile;
-	long			hash = 0;
+	const fileIndex_t	*found;
 
 	FS_AssertInitialised();
 
@@ -1904,38 +2063,100 @@ int	FS_FileIsInPAK(const char *filename, int *pChecksum ) {
 		return -1;
 	}
 
-	//
-	// search through the path, one element at a time
-	//
+	found = FS_IndexLookup( filename, qtrue );
+	if ( !found ) {
+		return -1;
+	}
 
-	for ( search = fs_searchpaths ; search ; search = search->next ) {
-		//
-		if (search->pack) {
-			hash = FS_HashFileName(filename, search->pack->hashSize);
-		}
-		// is the element a pak file?
-		if ( search->pack && search->pack->hashTable[hash] ) {
-			// disregard if it doesn't match one of the allowed pure pak files
-			if ( !FS_PakIsPure(search->pack) ) {
-				continue;
-			}
+	if (pChecksum) {
+		*pChecksum = found->search->pack->pure_checksum;
+	}
+	return 1;
+}
 
-			// look through all the pak file elements
-			pak = search->pack;
-			pakFile = pak->hashTable[hash];
-			do {
-				// case and separator insensitive comparisons
-				if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-					if (pChecksum) {
-						*pChecksum = pak->pure_checksum;
-					}
-					return 1;
-				}
-				pakFile = pakFile->next;
-			} while(pakFile != NULL);
+/*
+============
+FS_MappedFileData
+
+Finds the data of the current file of a handle opened on a mapped pk3.
+Returns NULL for anything that has to go through minizip instead.
+============
+*/
+static const byte *FS_MappedFileData( fileHandle_t h, unz_file_info *info ) {
+	const pakMap_t	*map;
+	ZPOS64_T		pos;
+
+	map = fsh[h].zipMap;
+	if ( !fsh[h].zipFile || !map ) {
+		return NULL;
+	}
+
+	// only a file that has just been opened, FS_Read may have used some already
+	if ( unztell( fsh[h].handleFiles.file.z ) != 0 ) {
+		return NULL;
+	}
+
+	if ( unzGetCurrentFileInfo( fsh[h].handleFiles.file.z, info, NULL, 0, NULL, 0, NULL, 0 ) != UNZ_OK ) {
+		return NULL;
+	}
+	if ( info->flag & 1 ) {
+		return NULL;	// encrypted
+	}
+
+	pos = unzGetCurrentFileZStreamPos64( fsh[h].handleFiles.file.z );
+	if ( !pos || pos > (ZPOS64_T)map->length || info->compressed_size > (ZPOS64_T)map->length - pos ) {
+		return NULL;
+	}
+
+	return map->base + pos;
+}
+
+/*
+============
+FS_ReadMappedFile
+
+Reads a whole file of a mapped pk3 in one go, copying it if it is stored
+and inflating it straight out of the mapping if it is deflated. Returns
+qfalse if the file has to be read with FS_Read.
+============
+*/
+static qboolean FS_ReadMappedFile( byte *buffer, int len, fileHandle_t h ) {
+	unz_file_info	info;
+	const byte		*data;
+	z_stream		stream;
+	int				err;
+
+	data = FS_MappedFileData( h, &info );
+	if ( !data || info.uncompressed_size != (uLong)len ) {
+		return qfalse;
+	}
+
+	if ( info.compression_method == 0 ) {
+		if ( info.compressed_size != (uLong)len ) {
+			return qfalse;
 		}
+		Com_Memcpy( buffer, data, len );
+	} else if ( info.compression_method == Z_DEFLATED ) {
+		Com_Memset( &stream, 0, sizeof( stream ) );
+		if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK ) {
+			return qfalse;
+		}
+		stream.next_in = (Bytef *)data;
+		stream.avail_in = info.compressed_size;
+		stream.next_out = buffer;
+		stream.avail_out = len;
+		err = inflate( &stream, Z_FINISH );
+		inflateEnd( &stream );
+
+		if ( err != Z_STREAM_END || stream.total_out != (uLong)len ) {
+			return qfalse;	// let minizip have a go, and complain
+		}
+	} else {
+		return qfalse;
 	}
-	return -1;
+
+	fs_readCount += len;
+	return qtrue;
 }
 
 /*
@@ -2038,7 +2259,9 @@ long FS_ReadFile( const char *qpath, void **buffer ) {
 
 //	Z_Label(buf, qpath);
 
-	FS_Read (buf, len, h);
+	if ( !FS_ReadMappedFile( buf, len, h ) ) {
+		FS_Read (buf, len, h);
+	}
 
 	// guarantee that it will have a trailing 0 for string operations
 	buf[len] = 0;
@@ -2068,6 +2291,78 @@ void FS_FreeFile( void *buffer ) {
 	Z_Free( buffer );
 }
 
+/*
+============
+FS_MapFile
+
+Like FS_ReadFile, but the buffer is read only and has no trailing 0. A file
+stored uncompressed in a mapped pk3 at an int aligned offset is not read at
+all, the buffer points into the mapping. Release it with FS_UnmapFile before
+the search paths change.
+============
+*/
+long FS_MapFile( const char *qpath, const void **buffer ) {
+	fileHandle_t	h;
+	unz_file_info	info;
+	const byte		*data;
+	long			len;
+
+	FS_AssertInitialised();
+
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_MapFile with empty name\n" );
+	}
+
+	// journaled configs and the like are read the normal way
+	if ( com_journal && com_journal->integer ) {
+		return FS_ReadFile( qpath, (void **)buffer );
+	}
+
+	len = FS_FOpenFileRead( qpath, &h, qfalse );
+	if ( h == 0 ) {
+		*buffer = NULL;
+		return -1;
+	}
+
+	data = FS_MappedFileData( h, &info );
+	if ( data && info.compression_method == 0 && info.compressed_size == (uLong)len
+		&& !( (intptr_t)data & ( sizeof( int ) - 1 ) ) ) {
+		FS_FCloseFile( h );
+		fs_loadCount++;
+		*buffer = data;
+		return len;
+	}
+	FS_FCloseFile( h );
+
+	return FS_ReadFile( qpath, (void **)buffer );
+}
+
+/*
+============
+FS_UnmapFile
+============
+*/
+void FS_UnmapFile( const void *buffer ) {
+	searchpath_t	*search;
+	const byte		*p;
+
+	FS_AssertInitialised();
+	if ( !buffer ) {
+		Com_Error( ERR_FATAL, "FS_UnmapFile( NULL )" );
+	}
+
+	// nothing to do if it points into a pk3
+	p = (const byte *)buffer;
+	for ( search = fs_searchpaths ; search ; search = search->next ) {
+		if ( search->pack && search->pack->map
+			&& p >= search->pack->map->base && p < search->pack->map->base + search->pack->map->length ) {
+			return;
+		}
+	}
+
+	FS_FreeFile( (void *)buffer );
+}
+
 /*
 ============
 FS_WriteFile
@@ -2103,6 +2398,475 @@ ZIP FILE LOADING
 ==========================================================================
 */
 
+/*
+=================
+FS_MapPak*
+
+minizip file functions that read a pk3 out of its mapping. Every handle
+opened on the pk3 gets its own position.
+=================
+*/
+typedef struct pakMapStream_s {
+	const pakMap_t	*map;
+	uLong			pos;
+} pakMapStream_t;
+
+static voidpf ZCALLBACK FS_MapPakOpen( voidpf opaque, const char *filename, int mode ) {
+	pakMapStream_t *stream;
+
+	if ( ( mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER ) != ZLIB_FILEFUNC_MODE_READ ) {
+		return NULL;
+	}
+
+	stream = (pakMapStream_t *)Z_Malloc( sizeof( *stream ), TAG_FILESYS, qtrue );
+	stream->map = (const pakMap_t *)opaque;
+	stream->pos = 0;
+	return stream;
+}
+
+static uLong ZCALLBACK FS_MapPakRead( voidpf opaque, voidpf stream, void *buf, uLong size ) {
+	pakMapStream_t *s = (pakMapStream_t *)stream;
+
+	if ( s->pos >= (uLong)s->map->length ) {
+		return 0;
+	}
+	if ( size > (uLong)s->map->length - s->pos ) {
+		size = (uLong)s->map->length - s->pos;
+	}
+	Com_Memcpy( buf, s->map->base + s->pos, size );
+	s->pos += size;
+	return size;
+}
+
+static uLong ZCALLBACK FS_MapPakWrite( voidpf opaque, voidpf stream, const void *buf, uLong size ) {
+	return 0;
+}
+
+static long ZCALLBACK FS_MapPakTell( voidpf opaque, voidpf stream ) {
+	return (long)( (pakMapStream_t *)stream )->pos;
+}
+
+static long ZCALLBACK FS_MapPakSeek( voidpf opaque, voidpf stream, uLong offset, int origin ) {
+	pakMapStream_t	*s = (pakMapStream_t *)stream;
+	uLong			base;
+
+	switch ( origin ) {
+	case ZLIB_FILEFUNC_SEEK_SET:
+		base = 0;
+		break;
+	case ZLIB_FILEFUNC_SEEK_CUR:
+		base = s->pos;
+		break;
+	case ZLIB_FILEFUNC_SEEK_END:
+		base = s->map->length;
+		break;
+	default:
+		return -1;
+	}
+
+	if ( offset > (uLong)s->map->length - base ) {
+		return -1;
+	}
+	s->pos = base + offset;
+	return 0;
+}
+
+static int ZCALLBACK FS_MapPakClose( voidpf opaque, voidpf stream ) {
+	Z_Free( stream );
+	return 0;
+}
+
+static int ZCALLBACK FS_MapPakError( voidpf opaque, voidpf stream ) {
+	return 0;
+}
+
+/*
+=================
+FS_OpenPak
+
+Opens a minizip handle on a pk3, reading it from its mapping if it has one
+=================
+*/
+static unzFile FS_OpenPak( const char *zipfile, const pakMap_t *map ) {
+	zlib_filefunc_def	funcs;
+
+	if ( !map ) {
+		return unzOpen( zipfile );
+	}
+
+	funcs.zopen_file = FS_MapPakOpen;
+	funcs.zread_file = FS_MapPakRead;
+	funcs.zwrite_file = FS_MapPakWrite;
+	funcs.ztell_file = FS_MapPakTell;
+	funcs.zseek_file = FS_MapPakSeek;
+	funcs.zclose_file = FS_MapPakClose;
+	funcs.zerror_file = FS_MapPakError;
+	funcs.opaque = (voidpf)map;
+
+	return unzOpen2( zipfile, &funcs );
+}
+
+/*
+=================
+FS_MapPak
+
+Maps a whole pk3 when that is allowed, NULL to read it through stdio
+=================
+*/
+static pakMap_t *FS_MapPak( const char *zipfile ) {
+	pakMap_t	*map;
+	void		*base;
+	int			length;
+
+	if ( !fs_mapPaks || !fs_mapPaks->integer ) {
+		return NULL;
+	}
+
+	base = Sys_MapFile( zipfile, &length );
+	if ( !base ) {
+		return NULL;
+	}
+
+	map = (pakMap_t *)Z_Malloc( sizeof( *map ), TAG_FILESYS, qtrue );
+	map->base = (const byte *)base;
+	map->length = length;
+	return map;
+}
+
+/*
+=================
+FS_UnmapPak
+=================
+*/
+static void FS_UnmapPak( pakMap_t *map ) {
+	if ( map ) {
+		Sys_UnmapFile( (void *)map->base, map->length );
+		Z_Free( map );
+	}
+}
+
+/*
+=================
+FS_AllocPak
+
+Allocates a pack with room for numfiles entries whose names take up namesLength bytes
+=================
+*/
+static pack_t *FS_AllocPak( const char *zipfile, const char *basename, int numfiles, int namesLength )
+{
+	pack_t	*pack;
+	int		i;
+
+	// get the hash table size from the number of files in the zip
+	// because lots of custom pk3 files have less than 32 or 64 files
+	for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
+		if (i > numfiles) {
+			break;
+		}
+	}
+
+	pack = (pack_t *)Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *), TAG_FILESYS, qtrue );
+	pack->hashSize = i;
+	pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
+	for(int j = 0; j < pack->hashSize; j++) {
+		pack->hashTable[j] = NULL;
+	}
+
+	Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
+	Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
+
+	// strip .pk3 if needed
+	if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
+		pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
+	}
+
+	pack->numfiles = numfiles;
+	pack->buildBuffer = (struct fileInPack_s *)Z_Malloc( (numfiles * sizeof( fileInPack_t )) + namesLength, TAG_FILESYS, qtrue );
+	return pack;
+}
+
+/*
+=================
+FS_AddPakFile
+
+Fills in entry index of a pack from FS_AllocPak, namePtr walks the name space behind the entries
+=================
+*/
+static void FS_AddPakFile( pack_t *pack, int index, char **namePtr, char *filename, unsigned long pos, unsigned long len )
+{
+	fileInPack_t	*pakFile;
+	long			hash;
+
+	Q_strlwr( filename );
+	hash = FS_HashFileName(filename, pack->hashSize);
+
+	pakFile = &pack->buildBuffer[index];
+	pakFile->name = *namePtr;
+	strcpy( pakFile->name, filename );
+	*namePtr += strlen(filename) + 1;
+	// store the file position in the zip
+	pakFile->pos = pos;
+	pakFile->len = len;
+	pakFile->next = pack->hashTable[hash];
+	pack->hashTable[hash] = pakFile;
+}
+
+/*
+=================
+FS_PakChecksums
+
+The first header long is the checksum feed, which only goes into the pure checksum
+=================
+*/
+static void FS_PakChecksums( const int *headerLongs, int numHeaderLongs, int *checksum, int *pure_checksum )
+{
+	*checksum = LittleLong( Com_BlockChecksum( &headerLongs[ 1 ], sizeof(*headerLongs) * ( numHeaderLongs - 1 ) ) );
+	*pure_checksum = LittleLong( Com_BlockChecksum( headerLongs, sizeof(*headerLongs) * numHeaderLongs ) );
+}
+
+/*
+=================
+FS_ScanPakJob
+
+Reads the central directory of a pk3 and works out its checksums without
+going through minizip or the zone, so the pk3s of a game directory can be
+scanned on the job threads. FS_LoadScannedPak then builds the packs on the
+main thread, in the usual order. Anything out of the ordinary (zip64,
+data in front of the archive, a damaged directory) fails the scan and is
+left to FS_LoadZipFile.
+=================
+*/
+#define ZIP_EOCD_SIZE			22
+#define ZIP_CENTRAL_HEADER_SIZE	46
+#define ZIP_MAX_COMMENT			0xffff
+
+typedef struct pakScan_s {
+	char			zipfile[MAX_OSPATH];
+	qboolean		valid;
+	void			*mapBase;			// mapping of the pk3, handed over to the pack
+	int				mapLength;
+	byte			*dirCopy;			// the central directory when it was read through stdio
+	const byte		*dir;
+	unsigned long	dirOffset;
+	unsigned long	dirLength;
+	int				numfiles;
+	int				namesLength;
+	int				checksum;
+	int				pure_checksum;
+} pakScan_t;
+
+static int FS_ZipShort( const byte *p ) {
+	return p[0] | ( p[1] << 8 );
+}
+
+static unsigned long FS_ZipLong( const byte *p ) {
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( (unsigned long)p[3] << 24 );
+}
+
+static const byte *FS_ScanRead( const pakScan_t *scan, FILE *f, unsigned long offset, unsigned long length, byte **copy ) {
+	if ( scan->mapBase ) {
+		return (const byte *)scan->mapBase + offset;
+	}
+
+	*copy = (byte *)malloc( length ? length : 1 );
+	if ( !*copy ) {
+		return NULL;
+	}
+	if ( fseek( f, (long)offset, SEEK_SET ) || fread( *copy, 1, length, f ) != length ) {
+		free( *copy );
+		*copy = NULL;
+		return NULL;
+	}
+	return *copy;
+}
+
+static qboolean FS_ScanZipFile( pakScan_t *scan, FILE *f, unsigned long length ) {
+	const byte		*tail, *eocd, *entry;
+	byte			*tailCopy;
+	unsigned long	tailLength, tailOffset, eocdOffset, pos;
+	int				*headerLongs;
+	int				numHeaderLongs;
+	int				numEntries;
+	int				nameLength;
+	int				i;
+
+	// the end of central directory record, minizip takes the last one in the file
+	tailLength = length < ZIP_MAX_COMMENT ? length : ZIP_MAX_COMMENT;
+	tailOffset = length - tailLength;
+	tailCopy = NULL;
+	tail = FS_ScanRead( scan, f, tailOffset, tailLength, &tailCopy );
+	if ( !tail ) {
+		return qfalse;
+	}
+
+	eocd = NULL;
+	for ( i = (int)tailLength - 4 ; i >= 0 ; i-- ) {
+		if ( tail[i] == 'P' && tail[i+1] == 'K' && tail[i+2] == 5 && tail[i+3] == 6 ) {
+			eocd = tail + i;
+			break;
+		}
+	}
+	// no room for the record, or a zip64 locator in front of it
+	if ( !eocd || i + ZIP_EOCD_SIZE > (int)tailLength
+		|| ( i < 20 && tailOffset ) || ( i >= 20 && !memcmp( eocd - 20, "PK\x06\x07", 4 ) ) ) {
+		free( tailCopy );
+		return qfalse;
+	}
+
+	eocdOffset = tailOffset + i;
+	numEntries = FS_ZipShort( eocd + 10 );
+	scan->dirLength = FS_ZipLong( eocd + 12 );
+	scan->dirOffset = FS_ZipLong( eocd + 16 );
+	if ( FS_ZipShort( eocd + 4 ) || FS_ZipShort( eocd + 6 ) || FS_ZipShort( eocd + 8 ) != numEntries
+		|| scan->dirOffset > eocdOffset || scan->dirLength != eocdOffset - scan->dirOffset ) {
+		free( tailCopy );
+		return qfalse;
+	}
+	free( tailCopy );
+
+	scan->dir = FS_ScanRead( scan, f, scan->dirOffset, scan->dirLength, &scan->dirCopy );
+	if ( !scan->dir ) {
+		return qfalse;
+	}
+
+	headerLongs = (int *)malloc( ( numEntries + 1 ) * sizeof( *headerLongs ) );
+	if ( !headerLongs ) {
+		return qfalse;
+	}
+	numHeaderLongs = 0;
+	headerLongs[ numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
+
+	scan->namesLength = 0;
+	for ( i = 0, pos = 0 ; i < numEntries ; i++ ) {
+		entry = scan->dir + pos;
+		if ( scan->dirLength - pos < ZIP_CENTRAL_HEADER_SIZE || memcmp( entry, "PK\x01\x02", 4 ) ) {
+			break;
+		}
+		// sizes and offsets that live in a zip64 extra field
+		if ( FS_ZipLong( entry + 20 ) == 0xffffffffUL || FS_ZipLong( entry + 24 ) == 0xffffffffUL || FS_ZipLong( entry + 42 ) == 0xffffffffUL ) {
+			break;
+		}
+
+		nameLength = FS_ZipShort( entry + 28 );
+		pos += ZIP_CENTRAL_HEADER_SIZE + nameLength + FS_ZipShort( entry + 30 ) + FS_ZipShort( entry + 32 );
+		if ( pos > scan->dirLength ) {
+			break;
+		}
+
+		scan->namesLength += Q_min( nameLength, MAX_ZPATH - 1 ) + 1;
+		if ( FS_ZipLong( entry + 24 ) > 0 ) {
+			headerLongs[ numHeaderLongs++ ] = LittleLong( (int)FS_ZipLong( entry + 16 ) );
+		}
+	}
+
+	if ( i == numEntries ) {
+		scan->numfiles = numEntries;
+		FS_PakChecksums( headerLongs, numHeaderLongs, &scan->checksum, &scan->pure_checksum );
+	}
+	free( headerLongs );
+
+	return (qboolean)( i == numEntries );
+}
+
+static void FS_FreePakScan( pakScan_t *scan ) {
+	free( scan->dirCopy );
+	scan->dirCopy = NULL;
+	scan->dir = NULL;
+
+	if ( scan->mapBase ) {
+		Sys_UnmapFile( scan->mapBase, scan->mapLength );
+		scan->mapBase = NULL;
+	}
+}
+
+static void FS_ScanPakJob( void *data, int index ) {
+	pakScan_t	*scan;
+	FILE		*f;
+	long		length;
+
+	scan = (pakScan_t *)data + index;
+	f = NULL;
+	length = 0;
+
+	if ( fs_mapPaks->integer ) {
+		scan->mapBase = Sys_MapFile( scan->zipfile, &scan->mapLength );
+	}
+
+	if ( scan->mapBase ) {
+		length = scan->mapLength;
+	} else {
+		f = fopen( scan->zipfile, "rb" );
+		if ( f && !fseek( f, 0, SEEK_END ) ) {
+			length = ftell( f );
+		}
+	}
+
+	scan->valid = length > 0 ? FS_ScanZipFile( scan, f, (unsigned long)length ) : qfalse;
+
+	if ( f ) {
+		fclose( f );
+	}
+	if ( !scan->valid ) {
+		FS_FreePakScan( scan );
+	}
+}
+
+/*
+=================
+FS_LoadScannedPak
+
+Builds the pack for a pk3 that FS_ScanPakJob has read
+=================
+*/
+static pack_t *FS_LoadScannedPak( pakScan_t *scan, const char *basename )
+{
+	pack_t			*pack;
+	pakMap_t		*map;
+	unzFile			uf;
+	const byte		*entry;
+	char			filename_inzip[MAX_ZPATH];
+	char			*namePtr;
+	unsigned long	pos;
+	int				nameLength;
+	int				i;
+
+	map = NULL;
+	if ( scan->mapBase ) {
+		// the pack owns the mapping from here on
+		map = (pakMap_t *)Z_Malloc( sizeof( *map ), TAG_FILESYS, qtrue );
+		map->base = (const byte *)scan->mapBase;
+		map->length = scan->mapLength;
+		scan->mapBase = NULL;
+	}
+
+	uf = FS_OpenPak( scan->zipfile, map );
+	if ( !uf ) {
+		FS_UnmapPak( map );
+		return NULL;
+	}
+
+	pack = FS_AllocPak( scan->zipfile, basename, scan->numfiles, scan->namesLength );
+	pack->handle = uf;
+	pack->map = map;
+	pack->checksum = scan->checksum;
+	pack->pure_checksum = scan->pure_checksum;
+
+	namePtr = (char *)( pack->buildBuffer + pack->numfiles );
+	for ( i = 0, pos = 0 ; i < scan->numfiles ; i++ ) {
+		entry = scan->dir + pos;
+		nameLength = Q_min( FS_ZipShort( entry + 28 ), MAX_ZPATH - 1 );
+		Com_Memcpy( filename_inzip, entry + ZIP_CENTRAL_HEADER_SIZE, nameLength );
+		filename_inzip[nameLength] = '\0';
+
+		// the offset of the entry is what unzGetOffset hands out
+		FS_AddPakFile( pack, i, &namePtr, filename_inzip, scan->dirOffset + pos, FS_ZipLong( entry + 24 ) );
+
+		pos += ZIP_CENTRAL_HEADER_SIZE + FS_ZipShort( entry + 28 ) + FS_ZipShort( entry + 30 ) + FS_ZipShort( entry + 32 );
+	}
+
+	return pack;
+}
+
 /*
 =================
 FS_LoadZipFile
@@ -2113,7 +2877,6 @@ of a zip file.
 */
 static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 {
-	fileInPack_t	*buildBuffer;
 	pack_t			*pack;
 	unzFile			uf;
 	int				err;
@@ -2122,18 +2885,21 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 	unz_file_info	file_info;
 	int				len;
 	size_t			i;
-	long			hash;
 	int				fs_numHeaderLongs;
 	int				*fs_headerLongs;
 	char			*namePtr;
+	pakMap_t		*map;
 
 	fs_numHeaderLongs = 0;
 
-	uf = unzOpen(zipfile);
+	map = FS_MapPak( zipfile );
+	uf = FS_OpenPak( zipfile, map );
 	err = unzGetGlobalInfo (uf,&gi);
 
-	if (err != UNZ_OK)
+	if (err != UNZ_OK) {
+		FS_UnmapPak( map );
 		return NULL;
+	}
 
 	len = 0;
 	unzGoToFirstFile(uf);
@@ -2147,36 +2913,14 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 		unzGoToNextFile(uf);
 	}
 
-	buildBuffer = (struct fileInPack_s *)Z_Malloc( (gi.number_entry * sizeof( fileInPack_t )) + len, TAG_FILESYS, qtrue );
-	namePtr = ((char *) buildBuffer) + gi.number_entry * sizeof( fileInPack_t );
+	pack = FS_AllocPak( zipfile, basename, gi.number_entry, len );
+	pack->handle = uf;
+	pack->map = map;
+	namePtr = (char *)( pack->buildBuffer + pack->numfiles );
+
 	fs_headerLongs = (int *)Z_Malloc( ( gi.number_entry + 1 ) * sizeof(int), TAG_FILESYS, qtrue );
 	fs_headerLongs[ fs_numHeaderLongs++ ] = LittleLong( fs_checksumFeed );
 
-	// get the hash table size from the number of files in the zip
-	// because lots of custom pk3 files have less than 32 or 64 files
-	for (i = 1; i <= MAX_FILEHASH_SIZE; i <<= 1) {
-		if (i > gi.number_entry) {
-			break;
-		}
-	}
-
-	pack = (pack_t *)Z_Malloc( sizeof( pack_t ) + i * sizeof(fileInPack_t *), TAG_FILESYS, qtrue );
-	pack->hashSize = i;
-	pack->hashTable = (fileInPack_t **) (((char *) pack) + sizeof( pack_t ));
-	for(int j = 0; j < pack->hashSize; j++) {
-		pack->hashTable[j] = NULL;
-	}
-
-	Q_strncpyz( pack->pakFilename, zipfile, sizeof( pack->pakFilename ) );
-	Q_strncpyz( pack->pakBasename, basename, sizeof( pack->pakBasename ) );
-
-	// strip .pk3 if needed
-	if ( strlen( pack->pakBasename ) > 4 && !Q_stricmp( pack->pakBasename + strlen( pack->pakBasename ) - 4, ".pk3" ) ) {
-		pack->pakBasename[strlen( pack->pakBasename ) - 4] = 0;
-	}
-
-	pack->handle = uf;
-	pack->numfiles = gi.number_entry;
 	unzGoToFirstFile(uf);
 
 	for (i = 0; i < gi.number_entry; i++)
@@ -2188,27 +2932,14 @@ static pack_t *FS_LoadZipFile( const char *zipfile, const char *basename )
 		if (file_info.uncompressed_size > 0) {
 			fs_headerLongs[fs_numHeaderLongs++] = LittleLong(file_info.crc);
 		}
-		Q_strlwr( filename_inzip );
-		hash = FS_HashFileName(filename_inzip, pack->hashSize);
-		buildBuffer[i].name = namePtr;
-		strcpy( buildBuffer[i].name, filename_inzip );
-		namePtr += strlen(filename_inzip) + 1;
-		// store the file position in the zip
-		buildBuffer[i].pos = unzGetOffset(uf);
-		buildBuffer[i].len = file_info.uncompressed_size;
-		buildBuffer[i].next = pack->hashTable[hash];
-		pack->hashTable[hash] = &buildBuffer[i];
+		FS_AddPakFile( pack, i, &namePtr, filename_inzip, unzGetOffset(uf), file_info.uncompressed_size );
 		unzGoToNextFile(uf);
 	}
 
-	pack->checksum = Com_BlockChecksum( &fs_headerLongs[ 1 ], sizeof(*fs_headerLongs) * ( fs_numHeaderLongs - 1 ) );
-	pack->pure_checksum = Com_BlockChecksum( fs_headerLongs, sizeof(*fs_headerLongs) * fs_numHeaderLongs );
-	pack->checksum = LittleLong( pack->checksum );
-	pack->pure_checksum = LittleLong( pack->pure_checksum );
+	FS_PakChecksums( fs_headerLongs, fs_numHeaderLongs, &pack->checksum, &pack->pure_checksum );
 
 	Z_Free(fs_headerLongs);
 
-	pack->buildBuffer = buildBuffer;
 	return pack;
 }
 
@@ -2223,6 +2954,7 @@ Frees a pak structure and releases all associated resources
 void FS_FreePak(pack_t *thepak)
 {
 	unzClose(thepak->handle);
+	FS_UnmapPak(thepak->map);
 	Z_Free(thepak->buildBuffer);
 	Z_Free(thepak);
 }
@@ -2933,6 +3665,7 @@ FS_Which_f
 */
 void FS_Which_f( void ) {
 	searchpath_t	*search;
+	const fileIndex_t	*found;
 	char		*filename;
 
 	filename = Cmd_Argv(1);
@@ -2955,27 +3688,11 @@ void FS_Which_f( void ) {
 	}
 
 	// just wants to see if file is there
-	for ( search=fs_searchpaths; search; search=search->next ) {
+	found = FS_IndexLookup( filename, qfalse );
+	for ( search = FS_FirstLookupPath( found ) ; search ; search = FS_NextLookupPath( search, found ) ) {
 		if ( search->pack ) {
-			long hash = FS_HashFileName( filename, search->pack->hashSize );
-
-			// is the element a pak file?
-			if ( search->pack->hashTable[hash]) {
-				// look through all the pak file elements
-				pack_t* pak = search->pack;
-				fileInPack_t* pakFile = pak->hashTable[hash];
-
-				do {
-					// case and separator insensitive comparisons
-					if ( !FS_FilenameCompare( pakFile->name, filename ) ) {
-						// found it!
-						Com_Printf( "File \"%s\" found in \"%s\"\n", filename, pak->pakFilename );
-						return;
-					}
-
-					pakFile = pakFile->next;
-				} while ( pakFile != NULL );
-			}
+			Com_Printf( "File \"%s\" found in \"%s\"\n", filename, search->pack->pakFilename );
+			return;
 		} else if (search->dir) {
 			directory_t* dir = search->dir;
 
@@ -3057,6 +3774,7 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	int				numfiles;
 	char			**pakfiles;
 	const char		*filename;
+	pakScan_t		*scans;
 
 	// this fixes the case where fs_basepath is the same as fs_cdpath
 	// which happens on full installs
@@ -3068,6 +3786,9 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 	Q_strncpyz( fs_gamedir, dir, sizeof( fs_gamedir ) );
 
+	// the search path is about to change
+	FS_FreeFileIndex();
+
 	// find all pak files in this directory
 	Q_strncpyz(curpath, FS_BuildOSPath(path, dir, ""), sizeof(curpath));
 	curpath[strlen(curpath) - 1] = '\0';	// strip the trailing slash
@@ -3092,11 +3813,28 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 		qsort( pakfiles, numfiles, sizeof(char*), paksort );
 	}
 
+	// read the central directories on the job threads, the packs are still added in order below
+	scans = NULL;
+	if ( numfiles ) {
+		scans = (pakScan_t *)Z_Malloc( numfiles * sizeof( *scans ), TAG_FILESYS, qtrue );
+		for ( i = 0 ; i < numfiles ; i++ ) {
+			Q_strncpyz( scans[i].zipfile, FS_BuildOSPath( path, dir, pakfiles[i] ), sizeof( scans[i].zipfile ) );
+		}
+		Com_RunJobs( FS_ScanPakJob, scans, numfiles );
+	}
+
 	for ( i = 0 ; i < numfiles ; i++ ) {
-		pakfile = FS_BuildOSPath( path, dir, pakfiles[i] );
+		pakfile = scans[i].zipfile;
 		filename = get_filename(pakfile);
 
-		if ( ( pak = FS_LoadZipFile( pakfile, pakfiles[i] ) ) == 0 )
+		if ( scans[i].valid ) {
+			pak = FS_LoadScannedPak( &scans[i], pakfiles[i] );
+		} else {
+			pak = FS_LoadZipFile( pakfile, pakfiles[i] );
+		}
+		FS_FreePakScan( &scans[i] );
+
+		if ( pak == 0 )
 			continue;
 
 		// files beginning with "dl_" are only loaded when referenced by the server
@@ -3114,9 +3852,7 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 
 			if (!found) {
 				// server has no interest in the file
-				unzClose(pak->handle);
-				Z_Free(pak->buildBuffer);
-				Z_Free(pak);
+				FS_FreePak(pak);
 				continue;
 			}
 		}
@@ -3155,6 +3891,9 @@ static void FS_AddGameDirectory( const char *path, const char *dir ) {
 	}
 
 	// done
+	if ( scans ) {
+		Z_Free( scans );
+	}
 	Sys_FreeFileList( pakfiles );
 }
 
@@ -3366,6 +4105,8 @@ void FS_Shutdown( qboolean closemfp, qboolean keepModuleFiles ) {
 	}
 
 	// free everything
+	FS_FreeFileIndex();
+
 	for ( p = fs_searchpaths ; p ; p = next ) {
 		next = p->next;
 
@@ -3452,6 +4193,9 @@ static void FS_ReorderPurePaks()
 
 	fs_reordered = qfalse;
 
+	// the order of the paks is about to change
+	FS_FreeFileIndex();
+
 	p_insert_index = &fs_searchpaths; // we insert in order at the beginning of the list
 	for ( i = 0 ; i < fs_numServerPaks ; i++ ) {
 		p_previous = p_insert_index; // track the pointer-to-current-item
@@ -3584,6 +4328,13 @@ void FS_Startup( const char *gameName ) {
 
 	fs_forcegame = Cvar_Get ("fs_forcegame", "", CVAR_INIT, "Folder to use for overriding of fs_game (can not be set by the server)." );
 
+#ifdef idx64
+	fs_mapPaks = Cvar_Get( "fs_mapPaks", "1", CVAR_INIT, "Map pk3 files into memory instead of reading them through file handles" );
+#else
+	// the address space is too tight for all of the assets
+	fs_mapPaks = Cvar_Get( "fs_mapPaks", "0", CVAR_INIT, "Map pk3 files into memory instead of reading them through file handles" );
+#endif
+
 	// add search path elements in reverse priority order (lowest priority first)
 	if (fs_cdpath->string[0]) {
 		FS_AddGameDirectory( fs_cdpath->string, gameName );
@@ -3661,6 +4412,9 @@ void FS_Startup( const char *gameName ) {
 	// reorder the pure pk3 files according to server order
 	FS_ReorderPurePaks();
 
+	// merge the pak hash tables for lookups
+	FS_BuildFileIndex();
+
 	// print the current search paths
 	FS_Path_f();
 
@@ -29,23 +29,22 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 static int			bloc = 0;
 
+// the offset versions keep their position in *offset rather than in bloc so
+// several messages can be encoded at once from different threads
+
 void	Huff_putBit( int bit, byte *fout, int *offset) {
-	bloc = *offset;
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+	int pos = *offset;
+	if ((pos&7) == 0) {
+		fout[(pos>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
-	*offset = bloc;
+	fout[(pos>>3)] |= bit << (pos&7);
+	*offset = pos + 1;
 }
 
 int		Huff_getBit( byte *fin, int *offset) {
-	int t;
-	bloc = *offset;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
-	*offset = bloc;
-	return t;
+	int pos = *offset;
+	*offset = pos + 1;
+	return (fin[(pos>>3)] >> (pos&7)) & 0x1;
 }
 
 /* Add a bit to the output file (buffered) */
@@ -270,14 +269,14 @@ int Huff_Receive (node_t *node, int *ch, byte *fin) {
 
 /* Get a symbol */
 void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxoffset) {
-	bloc = *offset;
+	int pos = *offset;
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (bloc >= maxoffset) {
+		if (pos >= maxoffset) {
 			*ch = 0;
 			*offset = maxoffset + 1;
 			return;
 		}
-		if (get_bit(fin)) {
+		if (Huff_getBit(fin, &pos)) {
 			node = node->right;
 		} else {
 			node = node->left;
@@ -289,7 +288,7 @@ void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxo
 //		Com_Error(ERR_DROP, "Illegal tree!\n");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = pos;
 }
 
 /* Send the prefix code for this node */
@@ -324,10 +323,22 @@ void Huff_transmit (huff_t *huff, int ch, byte *fout, int maxoffset) {
 	}
 }
 
+/* Send the prefix code for this node, at *offset */
+static void send_offset(node_t *node, node_t *child, byte *fout, int *offset, int maxoffset) {
+	if (node->parent) {
+		send_offset(node->parent, node, fout, offset, maxoffset);
+	}
+	if (child) {
+		if (*offset >= maxoffset) {
+			*offset = maxoffset + 1;
+			return;
+		}
+		Huff_putBit((node->right == child) ? 1 : 0, fout, offset);
+	}
+}
+
 void Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset) {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout, maxoffset);
-	*offset = bloc;
+	send_offset(huff->loc[ch], NULL, fout, offset, maxoffset);
 }
 
 void Huff_Decompress(msg_t *mbuf, int offset) {
@@ -444,3 +455,132 @@ void Huff_Init(huffman_t *huff) {
 	huff->compressor.loc[NYT] = huff->compressor.tree;
 }
 
+/*
+=================
+Huff_BuildCodes
+
+Fills in the lookup tables for a tree that won't be updated any more
+=================
+*/
+void Huff_BuildCodes( huffCodes_t *codes, huff_t *huff ) {
+	node_t			*node;
+	unsigned int	code;
+	int				ch, i, length;
+
+	Com_Memset( codes, 0, sizeof( *codes ) );
+	codes->huff = huff;
+
+	// walk up from each leaf, the bit nearest the root is sent first
+	for ( ch = 0 ; ch <= HMAX ; ch++ ) {
+		code = 0;
+		length = 0;
+		for ( node = huff->loc[ch] ; node && node->parent ; node = node->parent ) {
+			code = (code << 1) | ((node->parent->right == node) ? 1 : 0);
+			length++;
+		}
+		if ( !huff->loc[ch] || length > 32 ) {
+			continue;
+		}
+		codes->code[ch] = code;
+		codes->length[ch] = length;
+	}
+
+	// walk down for every possible run of HUFF_LOOKUP_BITS bits
+	for ( i = 0 ; i < (1 << HUFF_LOOKUP_BITS) ; i++ ) {
+		node = huff->tree;
+		for ( length = 0 ; length < HUFF_LOOKUP_BITS ; length++ ) {
+			if ( !node || node->symbol != INTERNAL_NODE ) {
+				break;
+			}
+			node = ( (i >> length) & 1 ) ? node->right : node->left;
+		}
+		codes->lookup[i].node = node;
+		if ( node && node->symbol != INTERNAL_NODE ) {
+			codes->lookup[i].symbol = node->symbol;
+			codes->lookup[i].length = length;
+		}
+	}
+}
+
+/*
+=================
+Huff_codeReceive
+
+Same as Huff_offsetReceive from the tree the codes were built from
+=================
+*/
+void Huff_codeReceive( const huffCodes_t *codes, int *ch, byte *fin, int *offset, int maxoffset ) {
+	const huffLookup_t	*entry;
+	int					pos = *offset;
+	int					first, last;
+	unsigned int		bits;
+
+	// near the end go a bit at a time so nothing past maxoffset is looked at
+	if ( pos + HUFF_LOOKUP_BITS > maxoffset ) {
+		Huff_offsetReceive( codes->huff->tree, ch, fin, offset, maxoffset );
+		return;
+	}
+
+	first = pos >> 3;
+	last = (pos + HUFF_LOOKUP_BITS - 1) >> 3;
+	bits = fin[first];
+	if ( last > first ) {
+		bits |= fin[first + 1] << 8;
+		if ( last > first + 1 ) {
+			bits |= fin[first + 2] << 16;
+		}
+	}
+	bits = (bits >> (pos & 7)) & ((1 << HUFF_LOOKUP_BITS) - 1);
+
+	entry = &codes->lookup[bits];
+	if ( entry->length ) {
+		*ch = entry->symbol;
+		*offset = pos + entry->length;
+		return;
+	}
+
+	// a longer code, carry on down the tree from where the table stopped
+	if ( !entry->node ) {
+		*ch = 0;
+		return;
+	}
+	*offset = pos + HUFF_LOOKUP_BITS;
+	Huff_offsetReceive( entry->node, ch, fin, offset, maxoffset );
+}
+
+/*
+=================
+Huff_codeTransmit
+
+Same as Huff_offsetTransmit on the tree the codes were built from
+=================
+*/
+void Huff_codeTransmit( const huffCodes_t *codes, int ch, byte *fout, int *offset, int maxoffset ) {
+	unsigned int	code = codes->code[ch];
+	int				length = codes->length[ch];
+	int				pos = *offset;
+	int				shift;
+	byte			*out;
+
+	// running out of room stops part way through a code, leave that to the tree
+	if ( !length || pos + length > maxoffset ) {
+		Huff_offsetTransmit( codes->huff, ch, fout, offset, maxoffset );
+		return;
+	}
+
+	*offset = pos + length;
+
+	// a fresh byte is cleared, the unwritten bits of a partial one are already clear
+	while ( length > 0 ) {
+		out = fout + (pos >> 3);
+		shift = pos & 7;
+		if ( !shift ) {
+			*out = (byte)code;
+		} else {
+			*out |= (byte)(code << shift);
+		}
+		code >>= 8 - shift;
+		pos += 8 - shift;
+		length -= 8 - shift;
+	}
+}
@@ -0,0 +1,276 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// jobs.cpp -- worker thread pool, see jobs.h
+
+#include "qcommon/qcommon.h"
+#include "qcommon/jobs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#define MAX_JOB_THREADS		32
+
+static cvar_t					*com_jobThreads;
+
+static std::vector<std::thread>	jobThreads;
+static std::mutex				jobMutex;
+static std::condition_variable	jobWake;		// a new batch was posted, or the pool is shutting down
+static std::condition_variable	jobDone;		// the last job of the batch finished
+static bool						jobQuit;
+static int						jobGeneration;
+
+// the current batch
+static jobFunc_t				jobFunc;
+static void						*jobData;
+static int						jobCount;
+static std::atomic<int>			jobNext;
+static std::atomic<int>			jobRemaining;
+static std::atomic<bool>		jobActive;
+static std::atomic<bool>		jobFailed;
+static int						jobErrorCode;
+static char						jobErrorMessage[MAXPRINTMSG];
+
+/*
+=================
+Job_Drain
+
+Runs jobs from the current batch until there are none left to hand out
+=================
+*/
+static void Job_Drain( void ) {
+	int index;
+
+	while ( (index = jobNext.fetch_add( 1 )) < jobCount ) {
+		// once a job has failed the rest of the batch is only counted off
+		if ( !jobFailed ) {
+			try {
+				jobFunc( jobData, index );
+			}
+			catch ( int code ) {
+				// Com_JobError normally got here first with the message
+				bool expected = false;
+				if ( jobFailed.compare_exchange_strong( expected, true ) ) {
+					jobErrorCode = code;
+					Q_strncpyz( jobErrorMessage, "error in job", sizeof( jobErrorMessage ) );
+				}
+			}
+		}
+
+		if ( jobRemaining.fetch_sub( 1 ) == 1 ) {
+			std::lock_guard<std::mutex> lock( jobMutex );
+			jobDone.notify_all();
+		}
+	}
+}
+
+/*
+=================
+Job_WorkerLoop
+=================
+*/
+static void Job_WorkerLoop( void ) {
+	int generation = 0;
+
+	for ( ;; ) {
+		{
+			std::unique_lock<std::mutex> lock( jobMutex );
+			jobWake.wait( lock, [&generation] { return jobQuit || jobGeneration != generation; } );
+			if ( jobQuit ) {
+				return;
+			}
+			generation = jobGeneration;
+		}
+
+		Job_Drain();
+	}
+}
+
+/*
+=================
+Com_RunJobs
+=================
+*/
+void Com_RunJobs( jobFunc_t func, void *data, int count ) {
+	bool expected = false;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	// no pool, nothing to split, or already inside a batch
+	if ( jobThreads.empty() || count == 1 || !jobActive.compare_exchange_strong( expected, true ) ) {
+		for ( int i = 0 ; i < count ; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( jobMutex );
+		jobFunc = func;
+		jobData = data;
+		jobCount = count;
+		jobFailed = false;
+		jobRemaining = count;
+		jobNext = 0;
+		jobGeneration++;
+	}
+	jobWake.notify_all();
+
+	// the calling thread works too, then waits for the stragglers
+	Job_Drain();
+	{
+		std::unique_lock<std::mutex> lock( jobMutex );
+		jobDone.wait( lock, [] { return jobRemaining == 0; } );
+	}
+
+	jobActive = false;
+
+	// now that the workers are idle the error can be raised for real
+	if ( jobFailed ) {
+		Com_Error( jobErrorCode, "%s", jobErrorMessage );
+	}
+}
+
+/*
+=================
+Com_JobsActive
+
+True while a batch is running, on the workers as well as on the calling thread
+=================
+*/
+qboolean Com_JobsActive( void ) {
+	return jobActive ? qtrue : qfalse;
+}
+
+/*
+=================
+Com_JobError
+
+Called by Com_Error while a batch is running. Shutting down from a worker, or
+from the caller while the workers still run, is not safe, so only the first
+error is recorded and Com_RunJobs raises it again once the batch has drained.
+=================
+*/
+void NORETURN Com_JobError( int code, const char *message ) {
+	bool expected = false;
+
+	if ( jobFailed.compare_exchange_strong( expected, true ) ) {
+		jobErrorCode = code;
+		Q_strncpyz( jobErrorMessage, message, sizeof( jobErrorMessage ) );
+	}
+	throw code;
+}
+
+/*
+=================
+Com_JobThreads
+
+Number of worker threads, not counting the thread calling Com_RunJobs
+=================
+*/
+int Com_JobThreads( void ) {
+	return (int)jobThreads.size();
+}
+
+/*
+=================
+Com_StartJobThreads
+
+(Re)starts the pool with numThreads workers, leaving it alone if it already has that many
+=================
+*/
+static void Com_StartJobThreads( int numThreads ) {
+	if ( numThreads < 0 ) {
+		numThreads = 0;
+	} else if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+
+	if ( numThreads == (int)jobThreads.size() ) {
+		return;
+	}
+	Com_ShutdownJobs();
+
+	jobQuit = false;
+	jobGeneration = 0;
+	jobActive = false;
+
+	for ( int i = 0 ; i < numThreads ; i++ ) {
+		try {
+			jobThreads.push_back( std::thread( Job_WorkerLoop ) );
+		}
+		catch ( const std::system_error & ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: Com_StartJobThreads: could only start %i of %i worker threads\n", i, numThreads );
+			break;
+		}
+	}
+
+	if ( !jobThreads.empty() ) {
+		Com_Printf( "Started %i job threads\n", (int)jobThreads.size() );
+	}
+}
+
+/*
+=================
+Com_StartupJobs
+
+Starts the pool before the filesystem, so the pk3 scan can use it. Only a
+thread count given on the command line is known this early, Com_InitJobs
+settles the final count once the config files have run.
+=================
+*/
+void Com_StartupJobs( void ) {
+	Com_StartJobThreads( Cvar_VariableIntegerValue( "com_jobThreads" ) );
+}
+
+/*
+=================
+Com_InitJobs
+=================
+*/
+void Com_InitJobs( void ) {
+	com_jobThreads = Cvar_Get( "com_jobThreads", "0", CVAR_ARCHIVE_ND|CVAR_LATCH, "Number of worker threads used to split up server work, 0 to disable" );
+
+	Com_StartJobThreads( com_jobThreads->integer );
+}
+
+/*
+=================
+Com_ShutdownJobs
+=================
+*/
+void Com_ShutdownJobs( void ) {
+	{
+		std::lock_guard<std::mutex> lock( jobMutex );
+		jobQuit = true;
+	}
+	jobWake.notify_all();
+
+	for ( size_t i = 0 ; i < jobThreads.size() ; i++ ) {
+		jobThreads[i].join();
+	}
+	jobThreads.clear();
+}
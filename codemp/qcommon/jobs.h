@@ -0,0 +1,41 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2015, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+#pragma once
+
+// jobs.h -- a small pool of worker threads for splitting independent work
+//
+// Com_RunJobs hands out indices 0..count-1 to the workers and the calling
+// thread, and returns once every job has finished. Jobs must only touch data
+// that no other job in the same batch writes. A Com_Error raised by a job is
+// held back and raised again on the calling thread after the batch has drained.
+//
+// Com_RunJobs called from inside a job, or while the pool is disabled
+// (com_jobThreads 0), just runs the jobs in order on the calling thread.
+
+typedef void (*jobFunc_t)( void *data, int index );
+
+void	Com_StartupJobs( void );
+void	Com_InitJobs( void );
+void	Com_ShutdownJobs( void );
+int		Com_JobThreads( void );
+void	Com_RunJobs( jobFunc_t func, void *data, int count );
+qboolean	Com_JobsActive( void );
+void	NORETURN Com_JobError( int code, const char *message );
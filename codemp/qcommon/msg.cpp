@@ -30,6 +30,8 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 //#define _USINGNEWHUFFTABLE_		// Build a new frequency table to cut and paste.
 
 static huffman_t		msgHuff;
+static huffCodes_t		msgCompressCodes;
+static huffCodes_t		msgDecompressCodes;
 
 static qboolean			msgInit = qfalse;
 #ifdef _NEWHUFFTABLE_
@@ -133,6 +135,66 @@ bit functions
 
 int	overflows;
 
+/*
+=================
+MSG_WriteHuffBits
+
+The raw low bits and the huffman codes of a whole value are at most
+7 + 4 * HUFF_LOOKUP_BITS bits, so they are gathered up and stored at once.
+Returns qfalse without touching msg if that won't do, because the value
+would run into the end of the message or has a code too long for the tables.
+=================
+*/
+static qboolean MSG_WriteHuffBits( msg_t *msg, unsigned int value, int bits ) {
+	uint64_t	acc;
+	int			accBits, nbits, length, shift, last, i;
+	byte		*out;
+
+#ifdef _NEWHUFFTABLE_
+	return qfalse;
+#endif
+
+	nbits = bits & 7;
+	acc = value & ((1 << nbits) - 1);
+	accBits = nbits;
+	value >>= nbits;
+
+	for ( i = nbits ; i < bits ; i += 8 ) {
+		length = msgCompressCodes.length[value & 0xff];
+		if ( !length || length > HUFF_LOOKUP_BITS ) {
+			return qfalse;
+		}
+		acc |= (uint64_t)msgCompressCodes.code[value & 0xff] << accBits;
+		accBits += length;
+		value >>= 8;
+	}
+
+	if ( msg->bit + accBits > msg->maxsize << 3 ) {
+		return qfalse;
+	}
+
+	// merge with the bits already in a partial byte, the bytes after it
+	// haven't been written yet so they may as well be cleared
+	out = msg->data + (msg->bit >> 3);
+	shift = msg->bit & 7;
+	acc = (acc << shift) | (out[0] & ((1 << shift) - 1));
+#ifdef Q3_LITTLE_ENDIAN
+	if ( (msg->bit >> 3) + (int)sizeof( acc ) <= msg->maxsize ) {
+		Com_Memcpy( out, &acc, sizeof( acc ) );
+	} else
+#endif
+	{
+		last = (shift + accBits - 1) >> 3;
+		for ( i = 0 ; i <= last ; i++ ) {
+			out[i] = (byte)(acc >> (i * 8));
+		}
+	}
+
+	msg->bit += accBits;
+	msg->cursize = (msg->bit>>3)+1;
+	return qtrue;
+}
+
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	int	i;
@@ -197,6 +259,9 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 		}
 	} else {
 		value &= (0xffffffff>>(32-bits));
+		if ( MSG_WriteHuffBits( msg, value, bits ) ) {
+			return;
+		}
 		if (bits&7) {
 			int nbits;
 			nbits = bits&7;
@@ -215,7 +280,7 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 #ifdef _NEWHUFFTABLE_
 				fwrite(&value, 1, 1, fp);
 #endif // _NEWHUFFTABLE_
-				Huff_offsetTransmit (&msgHuff.compressor, (value&0xff), msg->data, &msg->bit, msg->maxsize << 3);
+				Huff_codeTransmit (&msgCompressCodes, (value&0xff), msg->data, &msg->bit, msg->maxsize << 3);
 				value = (value>>8);
 
 				if ( msg->bit > msg->maxsize << 3 ) {
@@ -228,6 +293,105 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	}
 }
 
+/*
+=================
+MSG_WriteEncodedBits
+
+Appends numBits of an already encoded bitstream, as written by MSG_WriteBits
+into another message starting at bit 0. The huffman codes don't depend on
+where they start, so the result is the same as repeating the writes.
+=================
+*/
+void MSG_WriteEncodedBits( msg_t *msg, const byte *data, int numBits ) {
+	int		shift, bytes, last, i;
+	byte	*out;
+
+	if ( msg->overflowed || numBits <= 0 ) {
+		return;
+	}
+
+	if ( msg->oob ) {
+		Com_Error( ERR_DROP, "MSG_WriteEncodedBits: out of band message" );
+	}
+
+	if ( msg->bit + numBits > msg->maxsize << 3 ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	out = msg->data + (msg->bit >> 3);
+	shift = msg->bit & 7;
+	bytes = (numBits + 7) >> 3;
+
+	if ( !shift ) {
+		Com_Memcpy( out, data, bytes );
+	} else {
+		// the unwritten bits of a partial byte are always clear
+		last = (shift + numBits - 1) >> 3;
+		for ( i = 0 ; i < bytes ; i++ ) {
+			out[i] |= data[i] << shift;
+			if ( i + 1 <= last ) {
+				out[i + 1] = data[i] >> (8 - shift);
+			}
+		}
+	}
+
+	msg->bit += numBits;
+	msg->cursize = (msg->bit >> 3) + 1;
+}
+
+/*
+=================
+MSG_ReadHuffBits
+
+Reads a whole value through the lookup tables from 64 bits taken at once.
+Returns qfalse without touching msg when there aren't 64 bits left in the
+message or a code is too long for the tables.
+=================
+*/
+static qboolean MSG_ReadHuffBits( msg_t *msg, int bits, int *value ) {
+	const huffLookup_t	*entry;
+	const byte			*in;
+	uint64_t			acc;
+	int					nbits, used, i;
+
+#ifdef _NEWHUFFTABLE_
+	return qfalse;
+#endif
+
+	if ( (msg->bit >> 3) + 8 > msg->cursize ) {
+		return qfalse;
+	}
+
+	in = msg->data + (msg->bit >> 3);
+#ifdef Q3_LITTLE_ENDIAN
+	Com_Memcpy( &acc, in, sizeof( acc ) );
+#else
+	acc = 0;
+	for ( i = 7 ; i >= 0 ; i-- ) {
+		acc = (acc << 8) | in[i];
+	}
+#endif
+	acc >>= msg->bit & 7;
+
+	// at least 57 bits are left, enough for 7 raw bits and four codes
+	nbits = bits & 7;
+	*value = (int)(acc & ((1 << nbits) - 1));
+	used = nbits;
+
+	for ( i = 0 ; i < bits - nbits ; i += 8 ) {
+		entry = &msgDecompressCodes.lookup[(acc >> used) & ((1 << HUFF_LOOKUP_BITS) - 1)];
+		if ( !entry->length ) {
+			return qfalse;
+		}
+		*value |= entry->symbol << (i + nbits);
+		used += entry->length;
+	}
+
+	msg->bit += used;
+	return qtrue;
+}
+
 int MSG_ReadBits( msg_t *msg, int bits ) {
 	int			value;
 	int			get;
@@ -271,6 +435,10 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		} else {
 			Com_Error(ERR_DROP, "can't read %d bits\n", bits);
 		}
+	} else if ( MSG_ReadHuffBits( msg, bits, &value ) ) {
+		// same as below, including leaving the raw bits out of the sign extension
+		bits -= bits & 7;
+		msg->readcount = (msg->bit>>3)+1;
 	} else {
 		nbits = 0;
 		if (bits&7) {
@@ -286,7 +454,7 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		}
 		if (bits) {
 			for(i=0;i<bits;i+=8) {
-				Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize<<3);
+				Huff_codeReceive (&msgDecompressCodes, &get, msg->data, &msg->bit, msg->cursize<<3);
 #ifdef _NEWHUFFTABLE_
 				fwrite(&get, 1, 1, fp);
 #endif // _NEWHUFFTABLE_
@@ -3074,6 +3242,8 @@ void MSG_initHuffman() {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+	Huff_BuildCodes(&msgCompressCodes, &msgHuff.compressor);
+	Huff_BuildCodes(&msgDecompressCodes, &msgHuff.decompressor);
 }
 
 #else
@@ -3108,12 +3278,110 @@ void MSG_initHuffman() {
 		Com_Printf("%d,			// %d\n", array[i], i);
 	}
 	Com_Printf("};\n");
+	Huff_BuildCodes(&msgCompressCodes, &msgHuff.compressor);
+	Huff_BuildCodes(&msgDecompressCodes, &msgHuff.decompressor);
 	FS_FreeFile( data );
 	Cbuf_AddText( "condump dump.txt\n" );
 }
 
 #endif //._USINGNEWHUFFTABLE_
 
+/*
+=================
+MSG_HuffmanBench_f
+
+Times the netchan huffman coding through the lookup tables against walking
+the trees, on bytes distributed like msg_hData, and checks they agree
+=================
+*/
+void MSG_HuffmanBench_f( void ) {
+	const int	numSymbols = 0x10000;
+	const int	maxBits = numSymbols * 32;
+	byte		*symbols, *treeBits, *codeBits;
+	int			cumulative[256];
+	int			i, j, total, r, ch, pass, passes;
+	int			treeOffset, codeOffset, start;
+	int			treeEncode, codeEncode, treeDecode, codeDecode;
+
+	if ( !msgInit ) {
+		MSG_initHuffman();
+	}
+
+	passes = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100;
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+
+	symbols = (byte *)Z_Malloc( numSymbols, TAG_TEMP_WORKSPACE, qfalse );
+	treeBits = (byte *)Z_Malloc( maxBits >> 3, TAG_TEMP_WORKSPACE, qtrue );
+	codeBits = (byte *)Z_Malloc( maxBits >> 3, TAG_TEMP_WORKSPACE, qtrue );
+
+	total = 0;
+	for ( i = 0 ; i < 256 ; i++ ) {
+		total += msg_hData[i];
+		cumulative[i] = total;
+	}
+	for ( i = 0 ; i < numSymbols ; i++ ) {
+		r = ( (rand() << 15) ^ rand() ) % total;
+		for ( j = 0 ; cumulative[j] <= r ; j++ )
+			;
+		symbols[i] = j;
+	}
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		treeOffset = 0;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			Huff_offsetTransmit( &msgHuff.compressor, symbols[i], treeBits, &treeOffset, maxBits );
+		}
+	}
+	treeEncode = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		codeOffset = 0;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			Huff_codeTransmit( &msgCompressCodes, symbols[i], codeBits, &codeOffset, maxBits );
+		}
+	}
+	codeEncode = Sys_Milliseconds() - start;
+
+	if ( treeOffset != codeOffset || memcmp( treeBits, codeBits, (treeOffset + 7) >> 3 ) ) {
+		Com_Printf( S_COLOR_RED "huffman tables encode differently from the tree\n" );
+	}
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		treeOffset = 0;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			Huff_offsetReceive( msgHuff.decompressor.tree, &ch, codeBits, &treeOffset, codeOffset );
+		}
+	}
+	treeDecode = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		treeOffset = 0;
+		for ( i = 0 ; i < numSymbols ; i++ ) {
+			Huff_codeReceive( &msgDecompressCodes, &ch, codeBits, &treeOffset, codeOffset );
+			if ( ch != symbols[i] ) {
+				Com_Printf( S_COLOR_RED "huffman tables decoded symbol %i as %i\n", i, ch );
+				pass = passes;
+				break;
+			}
+		}
+	}
+	codeDecode = Sys_Milliseconds() - start;
+
+	Com_Printf( "%i x %i symbols, %.2f bits each\n", passes, numSymbols, (float)codeOffset / numSymbols );
+	Com_Printf( "encode: tree %i msec, tables %i msec\n", treeEncode, codeEncode );
+	Com_Printf( "decode: tree %i msec, tables %i msec\n", treeDecode, codeDecode );
+
+	Z_Free( codeBits );
+	Z_Free( treeBits );
+	Z_Free( symbols );
+}
+
 void MSG_shutdownHuffman()
 {
 #ifdef _NEWHUFFTABLE_
@@ -60,6 +60,11 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include <sys/time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#define NET_BATCHED_IO		// recvmmsg/sendmmsg and epoll
+#endif
+
 #ifdef MACOS_X
 #include <sys/sockio.h>
 #include <net/if.h>
@@ -96,6 +101,7 @@ static cvar_t	*net_ip;
 static cvar_t	*net_port;
 
 static cvar_t	*net_dropsim;
+static cvar_t	*net_batch;
 
 static struct sockaddr_in	socksRelayAddr;
 
@@ -247,6 +253,43 @@ Receive one packet
 int	recvfromCount;
 #endif
 
+/*
+==================
+NET_ReceivedPacket
+
+Fills in the sender and read position for a datagram of ret bytes that was
+received into net_message
+==================
+*/
+static qboolean NET_ReceivedPacket( struct sockaddr_in *from, socklen_t fromlen, int ret, netadr_t *net_from, msg_t *net_message ) {
+	memset( from->sin_zero, 0, 8 );
+
+	if ( usingSocks && memcmp( from, &socksRelayAddr, fromlen ) == 0 ) {
+		if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
+			return qfalse;
+		}
+		net_from->type = NA_IP;
+		net_from->ip[0] = net_message->data[4];
+		net_from->ip[1] = net_message->data[5];
+		net_from->ip[2] = net_message->data[6];
+		net_from->ip[3] = net_message->data[7];
+		memcpy( &net_from->port, &net_message->data[8], 2 );
+		net_message->readcount = 10;
+	}
+	else {
+		SockadrToNetadr( from, net_from );
+		net_message->readcount = 0;
+	}
+
+	if( ret >= net_message->maxsize ) {
+		Com_Printf( "Oversize packet from %s\n", NET_AdrToString (net_from) );
+		return qfalse;
+	}
+
+	net_message->cursize = ret;
+	return qtrue;
+}
+
 qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, fd_set *fdr ) {
 	int ret, err;
 	socklen_t fromlen;
@@ -272,37 +315,147 @@ qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, fd_set *fdr ) {
 		return qfalse;
 	}
 
-	memset( from.sin_zero, 0, 8 );
+	return NET_ReceivedPacket( &from, fromlen, ret, net_from, net_message );
+}
 
-	if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 ) {
-		if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
-			return qfalse;
+//=============================================================================
+
+static char socksBuf[4096];
+
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( int err, netadrtype_t type ) {
+	// wouldblock is silent
+	if( err == EAGAIN ) {
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if( err == EADDRNOTAVAIL && type == NA_BROADCAST ) {
+		return;
+	}
+
+	Com_Printf( "NET_SendPacket: %s\n", NET_ErrorString() );
+}
+
+#ifdef NET_BATCHED_IO
+
+/*
+=============================================================================
+
+SEND QUEUE
+
+While queueing, Sys_SendPacket only copies the datagram and the whole queue
+goes out with a single sendmmsg. The server queues everything it sends in
+SV_SendClientMessages, and the replies to the packets read in one NET_Event.
+
+=============================================================================
+*/
+
+#define	NET_QUEUE_SIZE			64
+#define	NET_QUEUE_PACKETLEN		1500	// bigger packets are sent right away
+
+static byte					netSendData[NET_QUEUE_SIZE][NET_QUEUE_PACKETLEN];
+static struct sockaddr_in	netSendAddr[NET_QUEUE_SIZE];
+static netadrtype_t			netSendType[NET_QUEUE_SIZE];
+static struct iovec			netSendIov[NET_QUEUE_SIZE];
+static struct mmsghdr		netSendHdr[NET_QUEUE_SIZE];
+static int					netSendCount;
+static qboolean				netSendQueueing;
+
+/*
+==================
+NET_SendQueuedPackets
+==================
+*/
+static void NET_SendQueuedPackets( void ) {
+	int		sent, ret;
+
+	sent = 0;
+	while ( sent < netSendCount ) {
+		ret = sendmmsg( ip_socket, &netSendHdr[sent], netSendCount - sent, 0 );
+		if ( ret == SOCKET_ERROR ) {
+			// the packet at sent failed, skip it and carry on with the rest
+			NET_SendError( socketError, netSendType[sent] );
+			sent++;
+			continue;
 		}
-		net_from->type = NA_IP;
-		net_from->ip[0] = net_message->data[4];
-		net_from->ip[1] = net_message->data[5];
-		net_from->ip[2] = net_message->data[6];
-		net_from->ip[3] = net_message->data[7];
-		memcpy( &net_from->port, &net_message->data[8], 2 );
-		net_message->readcount = 10;
+		sent += ret;
 	}
-	else {
-		SockadrToNetadr( &from, net_from );
-		net_message->readcount = 0;
+
+	netSendCount = 0;
+}
+
+/*
+==================
+NET_QueuePacket
+==================
+*/
+static void NET_QueuePacket( int length, const void *data, const struct sockaddr_in *addr, netadrtype_t type ) {
+	struct mmsghdr	*hdr;
+	int				i;
+
+	if ( netSendCount == NET_QUEUE_SIZE ) {
+		NET_SendQueuedPackets();
 	}
 
-	if( ret >= net_message->maxsize ) {
-		Com_Printf( "Oversize packet from %s\n", NET_AdrToString (net_from) );
-		return qfalse;
+	i = netSendCount++;
+	memcpy( netSendData[i], data, length );
+	netSendAddr[i] = *addr;
+	netSendType[i] = type;
+
+	netSendIov[i].iov_base = netSendData[i];
+	netSendIov[i].iov_len = length;
+
+	hdr = &netSendHdr[i];
+	memset( hdr, 0, sizeof( *hdr ) );
+	hdr->msg_hdr.msg_name = &netSendAddr[i];
+	hdr->msg_hdr.msg_namelen = sizeof( netSendAddr[i] );
+	hdr->msg_hdr.msg_iov = &netSendIov[i];
+	hdr->msg_hdr.msg_iovlen = 1;
+}
+
+/*
+==================
+NET_BeginPacketQueue
+==================
+*/
+void NET_BeginPacketQueue( void ) {
+	if ( !net_batch || !net_batch->integer || ip_socket == INVALID_SOCKET || usingSocks ) {
+		return;
 	}
 
-	net_message->cursize = ret;
-	return qtrue;
+	netSendQueueing = qtrue;
 }
 
-//=============================================================================
+/*
+==================
+NET_FlushPacketQueue
 
-static char socksBuf[4096];
+Also called every frame from NET_Sleep, so packets queued before an error
+interrupted the sender don't sit in the queue
+==================
+*/
+void NET_FlushPacketQueue( void ) {
+	netSendQueueing = qfalse;
+
+	if ( netSendCount ) {
+		NET_SendQueuedPackets();
+	}
+}
+
+#else
+
+void NET_BeginPacketQueue( void ) {
+}
+
+void NET_FlushPacketQueue( void ) {
+}
+
+#endif
 
 /*
 ==================
@@ -324,6 +477,18 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 
 	NetadrToSockadr( to, &addr );
 
+#ifdef NET_BATCHED_IO
+	if ( netSendQueueing && length <= NET_QUEUE_PACKETLEN ) {
+		NET_QueuePacket( length, data, &addr, to->type );
+		return;
+	}
+
+	// don't let this one overtake the queue
+	if ( netSendCount ) {
+		NET_SendQueuedPackets();
+	}
+#endif
+
 	if( usingSocks && to->type == NA_IP ) {
 		socksBuf[0] = 0;	// reserved
 		socksBuf[1] = 0;
@@ -338,19 +503,7 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 		ret = sendto( ip_socket, (const char *)data, length, 0, (sockaddr *)&addr, sizeof(addr) );
 	}
 	if( ret == SOCKET_ERROR ) {
-		int err = socketError;
-
-		// wouldblock is silent
-		if( err == EAGAIN ) {
-			return;
-		}
-
-		// some PPP links do not allow broadcasts and return an error
-		if( err == EADDRNOTAVAIL && to->type == NA_BROADCAST ) {
-			return;
-		}
-
-		Com_Printf( "NET_SendPacket: %s\n", NET_ErrorString() );
+		NET_SendError( socketError, to->type );
 	}
 }
 
@@ -809,6 +962,38 @@ void NET_GetLocalAddress( void )
 }
 #endif
 
+#ifdef NET_BATCHED_IO
+static int	net_epollfd = -1;
+
+/*
+====================
+NET_OpenEpoll
+====================
+*/
+static void NET_OpenEpoll( void ) {
+	struct epoll_event	ev;
+
+	if ( ip_socket == INVALID_SOCKET ) {
+		return;
+	}
+
+	net_epollfd = epoll_create1( EPOLL_CLOEXEC );
+	if ( net_epollfd == -1 ) {
+		Com_Printf( "WARNING: NET_OpenEpoll: epoll_create1: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	memset( &ev, 0, sizeof( ev ) );
+	ev.events = EPOLLIN;
+	ev.data.fd = ip_socket;
+	if ( epoll_ctl( net_epollfd, EPOLL_CTL_ADD, ip_socket, &ev ) == -1 ) {
+		Com_Printf( "WARNING: NET_OpenEpoll: epoll_ctl: %s\n", NET_ErrorString() );
+		close( net_epollfd );
+		net_epollfd = -1;
+	}
+}
+#endif
+
 /*
 ====================
 NET_OpenIP
@@ -843,6 +1028,10 @@ void NET_OpenIP( void )
 		if ( ip_socket == INVALID_SOCKET )
 			Com_Printf( "WARNING: Couldn't bind to a v4 ip address.\n");
 	}
+
+#ifdef NET_BATCHED_IO
+	NET_OpenEpoll();
+#endif
 }
 
 //===================================================================
@@ -893,6 +1082,8 @@ static qboolean NET_GetCvars( void ) {
 
 	net_dropsim = Cvar_Get( "net_dropsim", "", CVAR_TEMP);
 
+	net_batch = Cvar_Get( "net_batch", "1", CVAR_ARCHIVE_ND, "Receive and send packets in batches where the platform supports it" );
+
 	return modified ? qtrue : qfalse;
 }
 
@@ -939,6 +1130,15 @@ void NET_Config( qboolean enableNetworking ) {
 	}
 
 	if ( stop ) {
+		NET_FlushPacketQueue();
+
+#ifdef NET_BATCHED_IO
+		if ( net_epollfd != -1 ) {
+			close( net_epollfd );
+			net_epollfd = -1;
+		}
+#endif
+
 		if ( ip_socket != INVALID_SOCKET ) {
 			closesocket( ip_socket );
 			ip_socket = INVALID_SOCKET;
@@ -999,37 +1199,113 @@ void NET_Shutdown( void ) {
 ====================
 NET_Event
 
-Called from NET_Sleep which uses select() to determine which sockets have seen action.
+Called from NET_Sleep which uses select() or epoll to determine which sockets have seen action.
 ====================
 */
 
+static void NET_DispatchPacket(netadr_t *from, msg_t *netmsg)
+{
+	if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
+	{
+		// com_dropsim->value percent of incoming packets get dropped.
+		if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
+			return;          // drop this packet
+	}
+
+	if(com_sv_running->integer)
+		Com_RunAndTimeServerPacket(from, netmsg);
+	else
+		CL_PacketEvent(from, netmsg);
+}
+
+#ifdef NET_BATCHED_IO
+
+#define	NET_BATCH_SIZE		32
+
+static byte					netRecvData[NET_BATCH_SIZE][MAX_MSGLEN + 1];
+static struct sockaddr_in	netRecvAddr[NET_BATCH_SIZE];
+static struct iovec			netRecvIov[NET_BATCH_SIZE];
+static struct mmsghdr		netRecvHdr[NET_BATCH_SIZE];
+
+/*
+====================
+NET_EventBatched
+
+Same as the loop in NET_Event, but reads up to NET_BATCH_SIZE packets per syscall
+====================
+*/
+static void NET_EventBatched(fd_set *fdr)
+{
+	netadr_t from;
+	msg_t netmsg;
+	int i, count, err;
+
+	if ( ip_socket == INVALID_SOCKET || !FD_ISSET(ip_socket, fdr) ) {
+		return;
+	}
+
+	do
+	{
+		for ( i = 0 ; i < NET_BATCH_SIZE ; i++ ) {
+			netRecvIov[i].iov_base = netRecvData[i];
+			netRecvIov[i].iov_len = sizeof( netRecvData[i] );
+
+			memset( &netRecvHdr[i], 0, sizeof( netRecvHdr[i] ) );
+			netRecvHdr[i].msg_hdr.msg_name = &netRecvAddr[i];
+			netRecvHdr[i].msg_hdr.msg_namelen = sizeof( netRecvAddr[i] );
+			netRecvHdr[i].msg_hdr.msg_iov = &netRecvIov[i];
+			netRecvHdr[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		count = recvmmsg( ip_socket, netRecvHdr, NET_BATCH_SIZE, MSG_DONTWAIT, NULL );
+		if ( count == SOCKET_ERROR ) {
+			err = socketError;
+
+			if( err != EAGAIN && err != ECONNRESET )
+				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+			return;
+		}
+
+		for ( i = 0 ; i < count ; i++ ) {
+			MSG_Init( &netmsg, netRecvData[i], sizeof( netRecvData[i] ) );
+
+			if ( NET_ReceivedPacket( &netRecvAddr[i], netRecvHdr[i].msg_hdr.msg_namelen, netRecvHdr[i].msg_len, &from, &netmsg ) ) {
+				NET_DispatchPacket( &from, &netmsg );
+			}
+		}
+	} while ( count == NET_BATCH_SIZE );	// a short batch means the socket is drained
+}
+
+#endif
+
 void NET_Event(fd_set *fdr)
 {
 	byte bufData[MAX_MSGLEN + 1];
 	netadr_t from;
 	msg_t netmsg;
 
+	// answers to a burst of packets go out together
+	NET_BeginPacketQueue();
+
+#ifdef NET_BATCHED_IO
+	if ( net_batch->integer ) {
+		NET_EventBatched( fdr );
+		NET_FlushPacketQueue();
+		return;
+	}
+#endif
+
 	while(1)
 	{
 		MSG_Init(&netmsg, bufData, sizeof(bufData));
 
 		if(NET_GetPacket(&from, &netmsg, fdr))
-		{
-			if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
-			{
-				// com_dropsim->value percent of incoming packets get dropped.
-				if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
-					continue;          // drop this packet
-			}
-
-			if(com_sv_running->integer)
-				Com_RunAndTimeServerPacket(&from, &netmsg);
-			else
-				CL_PacketEvent(&from, &netmsg);
-		}
+			NET_DispatchPacket(&from, &netmsg);
 		else
 			break;
 	}
+
+	NET_FlushPacketQueue();
 }
 
 /*
@@ -1048,6 +1324,25 @@ void NET_Sleep( int msec ) {
 	if (msec < 0)
 		msec = 0;
 
+	NET_FlushPacketQueue();
+
+#ifdef NET_BATCHED_IO
+	if ( net_epollfd != -1 && net_batch->integer ) {
+		struct epoll_event ev;
+
+		retval = epoll_wait( net_epollfd, &ev, 1, msec );
+
+		if ( retval == SOCKET_ERROR )
+			Com_Printf( "Warning: epoll_wait() syscall failed: %s\n", NET_ErrorString() );
+		else if ( retval > 0 ) {
+			FD_ZERO(&fdset);
+			FD_SET(ip_socket, &fdset);
+			NET_Event(&fdset);
+		}
+		return;
+	}
+#endif
+
 	FD_ZERO(&fdset);
 	if (ip_socket != INVALID_SOCKET) {
 		FD_SET(ip_socket, &fdset); // network socket
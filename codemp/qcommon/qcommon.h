@@ -56,6 +56,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits( msg_t *msg, int value, int bits );
+void MSG_WriteEncodedBits( msg_t *msg, const byte *data, int numBits );
 
 void MSG_WriteChar (msg_t *sb, int c);
 void MSG_WriteByte (msg_t *sb, int c);
@@ -101,6 +102,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct pl
 #ifndef FINAL_BUILD
 void MSG_ReportChangeVectors_f( void );
 #endif
+void MSG_HuffmanBench_f( void );
 
 //============================================================================
 
@@ -148,6 +150,8 @@ const char	*NET_AdrToString (const netadr_t *a);
 qboolean	NET_StringToAdr ( const char *s, netadr_t *a);
 qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void		NET_Sleep(int msec);
+void		NET_BeginPacketQueue( void );
+void		NET_FlushPacketQueue( void );
 
 void		Sys_SendPacket( int length, const void *data, const netadr_t *to );
 //Does NOT parse port numbers, only base addresses.
@@ -644,9 +648,19 @@ long		FS_ReadFile( const char *qpath, void **buffer );
 void	FS_ForceFlush( fileHandle_t f );
 // forces flush on files we're writing to.
 
+FILE	*FS_FileForHandle( fileHandle_t f );
+// the FILE behind a handle opened for writing, errors out on pak files
+
 void	FS_FreeFile( void *buffer );
 // frees the memory returned by FS_ReadFile
 
+long	FS_MapFile( const char *qpath, const void **buffer );
+// like FS_ReadFile, but the buffer is truly read-only and has no trailing 0,
+// aligned files stored uncompressed in a mapped pk3 are returned in place
+
+void	FS_UnmapFile( const void *buffer );
+// releases the buffer returned by FS_MapFile
+
 void	FS_WriteFile( const char *qpath, const void *buffer, int size );
 // writes a complete file, creating any subdirectories needed
 
@@ -1030,6 +1044,23 @@ typedef struct huffman_s {
 	huff_t		decompressor;
 } huffman_t;
 
+// Lookup tables for a tree that no longer changes, so a symbol can be sent or
+// received in one step instead of a bit at a time. The bits are the same.
+#define HUFF_LOOKUP_BITS	11
+
+typedef struct huffLookup_s {
+	node_t			*node;		// where a code longer than HUFF_LOOKUP_BITS continues
+	short			symbol;
+	short			length;		// 0 if the code is longer than HUFF_LOOKUP_BITS
+} huffLookup_t;
+
+typedef struct huffCodes_s {
+	huff_t			*huff;
+	unsigned int	code[HMAX+1];		// first bit sent in the lowest bit
+	int				length[HMAX+1];		// 0 if the symbol has to go through the tree
+	huffLookup_t	lookup[1 << HUFF_LOOKUP_BITS];
+} huffCodes_t;
+
 void	Huff_Compress(msg_t *buf, int offset);
 void	Huff_Decompress(msg_t *buf, int offset);
 void	Huff_Init(huffman_t *huff);
@@ -1040,6 +1071,9 @@ void	Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxo
 void	Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset);
 void	Huff_putBit( int bit, byte *fout, int *offset);
 int		Huff_getBit( byte *fout, int *offset);
+void	Huff_BuildCodes( huffCodes_t *codes, huff_t *huff );
+void	Huff_codeReceive( const huffCodes_t *codes, int *ch, byte *fin, int *offset, int maxoffset );
+void	Huff_codeTransmit( const huffCodes_t *codes, int ch, byte *fout, int *offset, int maxoffset );
 
 extern huffman_t clientHuffTables;
 
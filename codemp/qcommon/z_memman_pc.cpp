@@ -42,19 +42,39 @@ void CIN_CloseAllVideos();
 
 
 // This handles zone memory allocation.
-// It is a wrapper around malloc with a tag id and a magic number at the start
+// It is a wrapper around malloc with a tag id and a magic number at the start,
+//	small allocations are carved out of per-size-class slabs instead (see Slab_Alloc)
+//
+// Both header types end in a magic number directly in front of the returned memory,
+//	which is how Z_Free etc tell them apart.
 
 #define ZONE_MAGIC			0x21436587
+#define SLAB_MAGIC			0x5A4B1AB5
+#define SLAB_FREE_MAGIC		0x5A4BF8EE
 
 typedef struct zoneHeader_s
 {
-		int					iMagic;
-		memtag_t			eTag;
-		int					iSize;
 struct	zoneHeader_s		*pNext;
 struct	zoneHeader_s		*pPrev;
+		memtag_t			eTag;
+		int					iSize;
+		int					iUnused;	// keeps iMagic adjacent to the data on 64-bit builds
+		int					iMagic;
 } zoneHeader_t;
 
+typedef struct slabHeader_s
+{
+	unsigned short			iSize;
+	unsigned char			eTag;
+	unsigned char			iClass;
+	int						iMagic;
+} slabHeader_t;
+
+static inline int Zone_MagicFromAddress(void *pvAddress)
+{
+	return ((int *)pvAddress)[-1];
+}
+
 typedef struct
 {
 	int iMagic;
@@ -96,6 +116,210 @@ cvar_t	*com_validateZone;
 zone_t	TheZone = {};
 
 
+// Slabs are fixed size pages split into equal blocks of one size class. Blocks are
+//	laid out so that the data following each slabHeader_t is 16-byte aligned.
+//
+#define SLAB_PAGE_SIZE		(64*1024)
+#define SLAB_MAX_SIZE		248			// biggest request served from a slab, bigger ones go to malloc
+
+typedef struct slabPage_s
+{
+struct	slabPage_s			*pNext;
+		int					iClass;
+		int					iBlocks;
+} slabPage_t;
+
+typedef struct slabClass_s
+{
+	int						iStride;	// header + data
+	int						iPages;
+	slabPage_t				*pPages;
+	slabHeader_t			*pFree;		// next free block, link stored in the block's data
+} slabClass_t;
+
+static const int slabStrides[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+#define SLAB_NUM_CLASSES	ARRAY_LEN( slabStrides )
+
+static slabClass_t	slabClasses[SLAB_NUM_CLASSES];
+static byte			slabClassForSize[(SLAB_MAX_SIZE >> 3) + 1];
+
+static inline int Slab_FirstBlockOffset(void)
+{
+	return ((sizeof(slabPage_t) + 15) & ~15) + (16 - sizeof(slabHeader_t));
+}
+
+static inline slabHeader_t *Slab_Block(slabPage_t *pPage, int iBlock)
+{
+	return (slabHeader_t *) ((byte *)pPage + Slab_FirstBlockOffset() + iBlock * slabClasses[pPage->iClass].iStride);
+}
+
+static void Slab_Init(void)
+{
+	int iClass = 0;
+
+	memset(slabClasses, 0, sizeof(slabClasses));
+	for (int i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		slabClasses[i].iStride = slabStrides[i];
+	}
+
+	for (int i = 0; i <= (SLAB_MAX_SIZE >> 3); i++)
+	{
+		const int iSize = i << 3;
+		while (slabStrides[iClass] - (int)sizeof(slabHeader_t) < iSize)
+		{
+			iClass++;
+		}
+		slabClassForSize[i] = iClass;
+	}
+}
+
+// grabs another page for this class and threads its blocks onto the freelist
+//
+static qboolean Slab_Grow(slabClass_t *pClass)
+{
+	slabPage_t *pPage = (slabPage_t *) malloc(SLAB_PAGE_SIZE);
+	if (!pPage)
+	{
+		return qfalse;	// let the regular Z_Malloc path try to recover some memory
+	}
+
+	pPage->iClass	= pClass - slabClasses;
+	pPage->iBlocks	= (SLAB_PAGE_SIZE - Slab_FirstBlockOffset()) / pClass->iStride;
+	pPage->pNext	= pClass->pPages;
+	pClass->pPages	= pPage;
+	pClass->iPages++;
+
+	for (int i = pPage->iBlocks - 1; i >= 0; i--)
+	{
+		slabHeader_t *pBlock = Slab_Block(pPage, i);
+		pBlock->iMagic = SLAB_FREE_MAGIC;
+		pBlock->iClass = pPage->iClass;
+		*(slabHeader_t **)&pBlock[1] = pClass->pFree;
+		pClass->pFree = pBlock;
+	}
+
+	return qtrue;
+}
+
+static void *Slab_Alloc(int iSize, memtag_t eTag, qboolean bZeroit)
+{
+	slabClass_t *pClass = &slabClasses[slabClassForSize[(iSize + 7) >> 3]];
+
+	if (!pClass->pFree && !Slab_Grow(pClass))
+	{
+		return NULL;
+	}
+
+	slabHeader_t *pBlock = pClass->pFree;
+	pClass->pFree = *(slabHeader_t **)&pBlock[1];
+
+	assert(pBlock->iMagic == SLAB_FREE_MAGIC);
+	pBlock->iMagic	= SLAB_MAGIC;
+	pBlock->eTag	= eTag;
+	pBlock->iSize	= iSize;
+
+	if (bZeroit)
+	{
+		memset(&pBlock[1], 0, iSize);
+	}
+
+	// Update stats...
+	//
+	TheZone.Stats.iCurrent += iSize;
+	TheZone.Stats.iCount++;
+	TheZone.Stats.iSizesPerTag	[eTag] += iSize;
+	TheZone.Stats.iCountsPerTag	[eTag]++;
+
+	if (TheZone.Stats.iCurrent > TheZone.Stats.iPeak)
+	{
+		TheZone.Stats.iPeak	= TheZone.Stats.iCurrent;
+	}
+
+	return &pBlock[1];
+}
+
+static void Slab_FreeBlock(slabHeader_t *pBlock)
+{
+	slabClass_t *pClass = &slabClasses[pBlock->iClass];
+
+	// Update stats...
+	//
+	TheZone.Stats.iCount--;
+	TheZone.Stats.iCurrent -= pBlock->iSize;
+	TheZone.Stats.iSizesPerTag	[pBlock->eTag] -= pBlock->iSize;
+	TheZone.Stats.iCountsPerTag	[pBlock->eTag]--;
+
+	pBlock->iMagic = SLAB_FREE_MAGIC;
+	*(slabHeader_t **)&pBlock[1] = pClass->pFree;
+	pClass->pFree = pBlock;
+}
+
+// frees every slab block with the given tag, pages themselves are kept for reuse
+//
+static void Slab_TagFree(memtag_t eTag)
+{
+	for (int i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		for (slabPage_t *pPage = slabClasses[i].pPages; pPage; pPage = pPage->pNext)
+		{
+			for (int j = 0; j < pPage->iBlocks; j++)
+			{
+				slabHeader_t *pBlock = Slab_Block(pPage, j);
+				if (pBlock->iMagic == SLAB_MAGIC && (eTag == TAG_ALL || pBlock->eTag == eTag))
+				{
+					Slab_FreeBlock(pBlock);
+				}
+			}
+		}
+	}
+}
+
+static void Slab_Validate(void)
+{
+	for (int i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		for (slabPage_t *pPage = slabClasses[i].pPages; pPage; pPage = pPage->pNext)
+		{
+			for (int j = 0; j < pPage->iBlocks; j++)
+			{
+				slabHeader_t *pBlock = Slab_Block(pPage, j);
+				if ((pBlock->iMagic != SLAB_MAGIC && pBlock->iMagic != SLAB_FREE_MAGIC) || pBlock->iClass != i)
+				{
+					Com_Error(ERR_FATAL, "Z_Validate(): Corrupt slab block!");
+					return;
+				}
+			}
+		}
+	}
+}
+
+static int Slab_PagesSize(void)
+{
+	int iPages = 0;
+	for (int i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		iPages += slabClasses[i].iPages;
+	}
+	return iPages * SLAB_PAGE_SIZE;
+}
+
+static void Slab_Shutdown(void)
+{
+	for (int i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		slabPage_t *pPage = slabClasses[i].pPages;
+		while (pPage)
+		{
+			slabPage_t *pNext = pPage->pNext;
+			free(pPage);
+			pPage = pNext;
+		}
+	}
+	Slab_Init();
+}
+
+
 // Scans through the linked list of mallocs and makes sure no data has been overwritten
 
 void Z_Validate(void)
@@ -132,6 +356,8 @@ void Z_Validate(void)
 
 		pMemory = pMemory->pNext;
 	}
+
+	Slab_Validate();
 }
 
 
@@ -154,20 +380,20 @@ typedef struct StaticMem_s {
 #pragma pack(pop)
 
 StaticZeroMem_t gZeroMalloc  =
-	{ {ZONE_MAGIC, TAG_STATIC,0,NULL,NULL},{ZONE_MAGIC}};
+	{ {NULL,NULL,TAG_STATIC,0,0,ZONE_MAGIC},{ZONE_MAGIC}};
 StaticMem_t gEmptyString =
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'\0','\0'},{ZONE_MAGIC}};
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'\0','\0'},{ZONE_MAGIC}};
 StaticMem_t gNumberString[] = {
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'0','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'1','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'2','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'3','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'4','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'5','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'6','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'7','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'8','\0'},{ZONE_MAGIC}},
-	{ {ZONE_MAGIC, TAG_STATIC,2,NULL,NULL},{'9','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'0','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'1','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'2','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'3','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'4','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'5','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'6','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'7','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'8','\0'},{ZONE_MAGIC}},
+	{ {NULL,NULL,TAG_STATIC,2,0,ZONE_MAGIC},{'9','\0'},{ZONE_MAGIC}},
 };
 
 qboolean gbMemFreeupOccured = qfalse;
@@ -181,6 +407,17 @@ void *Z_Malloc(int iSize, memtag_t eTag, qboolean bZeroit /* = qfalse */, int iU
 		return &pMemory[1];
 	}
 
+#ifndef DETAILED_ZONE_DEBUG_CODE
+	if (iSize <= SLAB_MAX_SIZE)
+	{
+		void *pvReturnMem = Slab_Alloc(iSize, eTag, bZeroit);
+		if (pvReturnMem)
+		{
+			return pvReturnMem;
+		}
+	}
+#endif
+
 	// Add in tracking info
 	//
 	int iRealSize = (iSize + sizeof(zoneHeader_t) + sizeof(zoneTail_t));
@@ -341,6 +578,18 @@ void openjk_minizip_free(void *to_free)
 //
 void Z_MorphMallocTag( void *pvAddress, memtag_t eDesiredTag )
 {
+	if (Zone_MagicFromAddress(pvAddress) == SLAB_MAGIC)
+	{
+		slabHeader_t *pBlock = ((slabHeader_t *)pvAddress) - 1;
+
+		TheZone.Stats.iSizesPerTag	[pBlock->eTag] -= pBlock->iSize;
+		TheZone.Stats.iCountsPerTag	[pBlock->eTag]--;
+		pBlock->eTag = eDesiredTag;
+		TheZone.Stats.iSizesPerTag	[pBlock->eTag] += pBlock->iSize;
+		TheZone.Stats.iCountsPerTag	[pBlock->eTag]++;
+		return;
+	}
+
 	zoneHeader_t *pMemory = ((zoneHeader_t *)pvAddress) - 1;
 
 	if (pMemory->iMagic != ZONE_MAGIC)
@@ -411,6 +660,11 @@ static void Zone_FreeBlock(zoneHeader_t *pMemory)
 //
 int Z_Size(void *pvAddress)
 {
+	if (Zone_MagicFromAddress(pvAddress) == SLAB_MAGIC)
+	{
+		return (((slabHeader_t *)pvAddress) - 1)->iSize;
+	}
+
 	zoneHeader_t *pMemory = ((zoneHeader_t *)pvAddress) - 1;
 
 	if (pMemory->eTag == TAG_STATIC)
@@ -438,6 +692,18 @@ void Z_Free(void *pvAddress)
 		return;
 	}
 
+	const int iMagic = Zone_MagicFromAddress(pvAddress);
+	if (iMagic == SLAB_MAGIC)
+	{
+		Slab_FreeBlock(((slabHeader_t *)pvAddress) - 1);
+		return;
+	}
+	if (iMagic == SLAB_FREE_MAGIC)
+	{
+		Com_Error(ERR_FATAL, "Z_Free(): Block already-freed!");
+		return;
+	}
+
 	zoneHeader_t *pMemory = ((zoneHeader_t *)pvAddress) - 1;
 
 	if (pMemory->eTag == TAG_STATIC)
@@ -496,6 +762,8 @@ void Z_TagFree(memtag_t eTag)
 		pMemory = pNext;
 	}
 
+	Slab_TagFree(eTag);
+
 // these stupid pragmas don't work here???!?!?!
 //
 //#ifdef _DEBUG
@@ -548,6 +816,11 @@ static void Z_Stats_f(void)
 									TheZone.Stats.iPeak,
 									         (float)TheZone.Stats.iPeak / 1024.0f / 1024.0f
 				);
+
+	Com_Printf("Small blocks are served from %d bytes (%.2fMB) of slab pages\n",
+									Slab_PagesSize(),
+									         (float)Slab_PagesSize() / 1024.0f / 1024.0f
+				);
 }
 
 // Gives a detailed breakdown of the memory blocks in the zone
@@ -599,6 +872,7 @@ void Com_ShutdownZoneMemory(void)
 		assert(!TheZone.Stats.iCount);
 		assert(!TheZone.Stats.iCurrent);
 	}
+	Slab_Shutdown();
 }
 
 // Initialises the zone memory system
@@ -607,6 +881,7 @@ void Com_InitZoneMemory( void )
 {
 	memset(&TheZone, 0, sizeof(TheZone));
 	TheZone.Header.iMagic = ZONE_MAGIC;
+	Slab_Init();
 }
 
 void Com_InitZoneMemoryVars( void ) {
@@ -653,8 +928,48 @@ char *CopyString( const char *in ) {
 
 
 
-static memtag_t hunk_tag;
+/*
+==============================================================================
+
+Goals:
+	reproducable without history effects -- no out of memory errors on weird map to map changes
+	allow restarting of the client without fragmentation
+	minimize total pages in use at run time
+	minimize total pages needed during load time
+
+  Single block of memory with stack allocators coming from both ends towards the middle.
+
+  One side is designated the low side and the other the high side.  The collision
+  model and server data live on the high side, the renderer on the low side.
+
+  Hunk_SetMark records the current top of both stacks, so Hunk_ClearToMark and
+  Hunk_Clear are just pointer resets -- nothing is walked or freed.
+
+  Temp memory is still handed out by the zone, see Hunk_AllocateTempMemory.
+
+==============================================================================
+*/
+
+#define MIN_DEDICATED_COMHUNKMEGS	8
+#define MIN_COMHUNKMEGS				64
+#define DEF_COMHUNKMEGS				256
+#define DEF_COMHUNKMEGS_S			XSTRING(DEF_COMHUNKMEGS)
+
+typedef struct hunkUsed_s {
+	int		mark;
+	int		permanent;
+	int		peak;
+} hunkUsed_t;
+
+static	hunkUsed_t	hunk_low, hunk_high;
+
+static	byte	*s_hunkAlloc;	// unaligned block as returned by calloc
+static	byte	*s_hunkData = NULL;
+static	int		s_hunkTotal;
 
+static	qboolean	s_hunkMarkSet;
+
+cvar_t	*com_hunkMegs;
 
 /*
 ===============
@@ -673,6 +988,19 @@ void Com_TouchMemory( void ) {
 
 	sum = 0;
 
+	if ( s_hunkData ) {
+		j = hunk_low.permanent >> 2;
+		for ( i = 0 ; i < j ; i += 64 ) {			// only need to touch each page
+			sum += ((unsigned int *)s_hunkData)[i];
+		}
+
+		i = ( s_hunkTotal - hunk_high.permanent ) >> 2;
+		j = s_hunkTotal >> 2;
+		for (  ; i < j ; i += 64 ) {			// only need to touch each page
+			sum += ((unsigned int *)s_hunkData)[i];
+		}
+	}
+
 	zoneHeader_t *pMemory = TheZone.Header.pNext;
 	while (pMemory)
 	{
@@ -685,6 +1013,16 @@ void Com_TouchMemory( void ) {
 		pMemory = pMemory->pNext;
 	}
 
+	for (i = 0; i < (int)SLAB_NUM_CLASSES; i++)
+	{
+		for (slabPage_t *pPage = slabClasses[i].pPages; pPage; pPage = pPage->pNext)
+		{
+			for (j = 0; j < (SLAB_PAGE_SIZE >> 2); j += 64) {
+				sum += ((unsigned int*)pPage)[j];
+			}
+		}
+	}
+
 //	end = Sys_Milliseconds();
 //	Com_Printf( "Com_TouchMemory: %i msec\n", end - start );
 }
@@ -693,11 +1031,26 @@ void Com_TouchMemory( void ) {
 
 qboolean Com_TheHunkMarkHasBeenMade(void)
 {
-	if (hunk_tag == TAG_HUNK_MARK2)
-	{
-		return qtrue;
-	}
-	return qfalse;
+	return s_hunkMarkSet;
+}
+
+/*
+=================
+Hunk_Stats_f
+=================
+*/
+static void Hunk_Stats_f( void ) {
+	Com_Printf( "%9i bytes (%6.2f MB) total hunk\n", s_hunkTotal, (float)s_hunkTotal / 1024.0f / 1024.0f );
+	Com_Printf( "\n" );
+	Com_Printf( "%9i low mark\n", hunk_low.mark );
+	Com_Printf( "%9i low permanent\n", hunk_low.permanent );
+	Com_Printf( "%9i low peak\n", hunk_low.peak );
+	Com_Printf( "\n" );
+	Com_Printf( "%9i high mark\n", hunk_high.mark );
+	Com_Printf( "%9i high permanent\n", hunk_high.permanent );
+	Com_Printf( "%9i high peak\n", hunk_high.peak );
+	Com_Printf( "\n" );
+	Com_Printf( "%9i bytes (%6.2f MB) remaining\n", Hunk_MemoryRemaining(), (float)Hunk_MemoryRemaining() / 1024.0f / 1024.0f );
 }
 
 /*
@@ -706,15 +1059,60 @@ Com_InitHunkMemory
 =================
 */
 void Com_InitHunkMemory( void ) {
-	hunk_tag = TAG_HUNK_MARK1;
+	int		nMinAlloc;
+	const char *pMsg = NULL;
+
+	// allocate the stack based hunk allocator
+	com_hunkMegs = Cvar_Get( "com_hunkMegs", DEF_COMHUNKMEGS_S, CVAR_LATCH | CVAR_ARCHIVE, "Size of the hunk memory in megabytes" );
+
+	// if we are not dedicated min allocation is MIN_COMHUNKMEGS, otherwise MIN_DEDICATED_COMHUNKMEGS
+	if ( com_dedicated && com_dedicated->integer ) {
+		nMinAlloc = MIN_DEDICATED_COMHUNKMEGS;
+		pMsg = "Minimum com_hunkMegs for a dedicated server is %i, allocating %i megs.\n";
+	}
+	else {
+		nMinAlloc = MIN_COMHUNKMEGS;
+		pMsg = "Minimum com_hunkMegs is %i, allocating %i megs.\n";
+	}
+
+	if ( com_hunkMegs->integer < nMinAlloc ) {
+		s_hunkTotal = 1024 * 1024 * nMinAlloc;
+		Com_Printf( pMsg, nMinAlloc, s_hunkTotal / (1024 * 1024) );
+	} else if ( com_hunkMegs->integer > 1024 ) {
+		// keep the offsets comfortably inside an int
+		s_hunkTotal = 1024 * 1024 * 1024;
+		Com_Printf( "Maximum com_hunkMegs is 1024, allocating 1024 megs.\n" );
+	} else {
+		s_hunkTotal = com_hunkMegs->integer * 1024 * 1024;
+	}
+
+	// calloc'd pages are only committed once touched, so an oversized hunk is cheap
+	s_hunkAlloc = (byte *)calloc( s_hunkTotal + 63, 1 );
+	if ( !s_hunkAlloc ) {
+		Com_Error( ERR_FATAL, "Hunk data failed to allocate %i megs", s_hunkTotal / (1024*1024) );
+	}
+	// cacheline align
+	s_hunkData = (byte *) ( ( (intptr_t)s_hunkAlloc + 63 ) & ~63 );
+
+	s_hunkMarkSet = qfalse;
 	Hunk_Clear();
+
+	Cmd_AddCommand( "hunk_stats", Hunk_Stats_f, "Prints out hunk memory stats" );
 }
 
 void Com_ShutdownHunkMemory(void)
 {
-	//Er, ok. Clear it then I guess.
-	Z_TagFree(TAG_HUNK_MARK1);
-	Z_TagFree(TAG_HUNK_MARK2);
+	Cmd_RemoveCommand( "hunk_stats" );
+
+	if ( s_hunkAlloc ) {
+		free( s_hunkAlloc );
+	}
+	s_hunkAlloc = NULL;
+	s_hunkData = NULL;
+	s_hunkTotal = 0;
+	s_hunkMarkSet = qfalse;
+	Com_Memset( &hunk_low, 0, sizeof( hunk_low ) );
+	Com_Memset( &hunk_high, 0, sizeof( hunk_high ) );
 }
 
 /*
@@ -723,7 +1121,7 @@ Hunk_MemoryRemaining
 ====================
 */
 int	Hunk_MemoryRemaining( void ) {
-	return (64*1024*1024) - (Z_MemSize(TAG_HUNK_MARK1)+Z_MemSize(TAG_HUNK_MARK2));	//Yeah. Whatever. We've got no size now.
+	return s_hunkTotal - ( hunk_low.permanent + hunk_high.permanent );
 }
 
 /*
@@ -734,7 +1132,9 @@ The server calls this after the level and game VM have been loaded
 ===================
 */
 void Hunk_SetMark( void ) {
-	hunk_tag = TAG_HUNK_MARK2;
+	hunk_low.mark = hunk_low.permanent;
+	hunk_high.mark = hunk_high.permanent;
+	s_hunkMarkSet = qtrue;
 }
 
 /*
@@ -745,8 +1145,9 @@ The client calls this before starting a vid_restart or snd_restart
 =================
 */
 void Hunk_ClearToMark( void ) {
-	assert(hunk_tag == TAG_HUNK_MARK2); //if this is not true then no mark has been made
-	Z_TagFree(TAG_HUNK_MARK2);
+	assert(s_hunkMarkSet); //if this is not true then no mark has been made
+	hunk_low.permanent = hunk_low.mark;
+	hunk_high.permanent = hunk_high.mark;
 }
 
 /*
@@ -755,12 +1156,7 @@ Hunk_CheckMark
 =================
 */
 qboolean Hunk_CheckMark( void ) {
-	//if( hunk_low.mark || hunk_high.mark ) {
-	if (hunk_tag != TAG_HUNK_MARK1)
-	{
-		return qtrue;
-	}
-	return qfalse;
+	return s_hunkMarkSet;
 }
 
 void CL_ShutdownCGame( void );
@@ -791,9 +1187,13 @@ void Hunk_Clear( void ) {
 	CIN_CloseAllVideos();
 #endif
 
-	hunk_tag = TAG_HUNK_MARK1;
-	Z_TagFree(TAG_HUNK_MARK1);
-	Z_TagFree(TAG_HUNK_MARK2);
+	hunk_low.mark = 0;
+	hunk_low.permanent = 0;
+
+	hunk_high.mark = 0;
+	hunk_high.permanent = 0;
+
+	s_hunkMarkSet = qfalse;
 
 	if ( re && re->HunkClearCrap ) {
 		re->HunkClearCrap();
@@ -821,7 +1221,43 @@ Allocate permanent (until the hunk is cleared) memory
 =================
 */
 void *Hunk_Alloc( int size, ha_pref preference ) {
-	return Z_Malloc(size, hunk_tag, qtrue);
+	void	*buf;
+
+	if ( s_hunkData == NULL)
+	{
+		Com_Error( ERR_FATAL, "Hunk_Alloc: Hunk memory system not initialized" );
+	}
+
+	if ( size < 0 ) {
+		Com_Error( ERR_DROP, "Hunk_Alloc: negative size %i", size );
+	}
+
+	// round to cacheline
+	size = (size+31)&~31;
+
+	if ( hunk_low.permanent + hunk_high.permanent + size > s_hunkTotal ) {
+		Com_Printf( S_COLOR_RED "Hunk_Alloc(): Failed to alloc %d bytes, %d of %d in use\n", size, hunk_low.permanent + hunk_high.permanent, s_hunkTotal );
+		Com_Error( ERR_DROP, "Hunk_Alloc failed on %i, try raising com_hunkMegs", size );
+	}
+
+	if ( preference == h_high ) {
+		hunk_high.permanent += size;
+		buf = (void *)(s_hunkData + s_hunkTotal - hunk_high.permanent);
+		if ( hunk_high.permanent > hunk_high.peak ) {
+			hunk_high.peak = hunk_high.permanent;
+		}
+	} else {
+		buf = (void *)(s_hunkData + hunk_low.permanent);
+		hunk_low.permanent += size;
+		if ( hunk_low.permanent > hunk_low.peak ) {
+			hunk_low.peak = hunk_low.permanent;
+		}
+	}
+
+	// the memory may have been used by a previous level
+	Com_Memset( buf, 0, size );
+
+	return buf;
 }
 
 /*
@@ -28,9 +28,10 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "../rd-common/tr_types.h"
 #include "../qcommon/MiniHeap.h"
 #include "../qcommon/qcommon.h"
+#include "../qcommon/jobs.h"
 #include "../ghoul2/ghoul2_shared.h"
 
-#define	REF_API_VERSION 9
+#define	REF_API_VERSION 10
 
 //
 // these are the functions exported by the refresh module
@@ -245,6 +246,8 @@ typedef struct refexport_s {
 		float				(*Font_StrLenPixels)					( const char *text, const int iFontIndex, const float scale );
 	} ext;
 
+	void				(*G2API_ConstructGhoulSkeletons)		( CGhoul2Info_v **ghoul2, vec3_t *scales, const int count, const int frameNum );	// optional, NULL if the renderer doesn't have it
+
 } refexport_t;
 
 //
@@ -352,6 +355,9 @@ typedef struct refimport_s {
 	void			*(*VK_GetInstanceProcAddress)		( void );
 	qboolean		(*VK_createSurfaceImpl)				( void *instance, void **surface );
 	void			(*VK_destroyWindow)					( void);
+
+	// worker threads, see qcommon/jobs.h
+	void			(*Com_RunJobs)						( jobFunc_t func, void *data, int count );
 } refimport_t;
 
 // this is the only function actually exported at the linker level
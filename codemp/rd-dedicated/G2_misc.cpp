@@ -27,6 +27,11 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "ghoul2/g2_local.h"
 
 #include "tr_local.h"
+#if defined(G2_SIMD_SSE)
+#include <xmmintrin.h>
+#elif defined(G2_SIMD_NEON)
+#include <arm_neon.h>
+#endif
 #ifdef _G2_GORE
 #include "ghoul2/G2_gore.h"
 
@@ -262,6 +267,65 @@ public:
 
 };
 
+// work out the axes G2_RadiusTracePolys sorts verts on. A vert is inside the trace when its offset
+// from the ray start dots to between 0 and 1 with rayDir, and with saxis and taxis once 0.5 is added
+static void G2_RadiusTraceAxes(const vec3_t rayStart, const vec3_t rayEnd, float fRadius, vec3_t saxis, vec3_t taxis, vec3_t rayDir)
+{
+	vec3_t basis1;
+	vec3_t basis2;
+
+	basis2[0]=0.0f;
+	basis2[1]=0.0f;
+	basis2[2]=1.0f;
+
+	VectorSubtract(rayEnd, rayStart, rayDir);
+
+	CrossProduct(rayDir,basis2,basis1);
+
+	if (DotProduct(basis1,basis1)<.1f)
+	{
+		basis2[0]=0.0f;
+		basis2[1]=1.0f;
+		basis2[2]=0.0f;
+		CrossProduct(rayDir,basis2,basis1);
+	}
+
+	CrossProduct(rayDir,basis1,basis2);
+	// Give me a shot direction not a bunch of zeros :) -Gil
+//	assert(DotProduct(basis1,basis1)>.0001f);
+//	assert(DotProduct(basis2,basis2)>.0001f);
+
+	VectorNormalize(basis1);
+	VectorNormalize(basis2);
+
+	const float c=cos(0.0f);//theta
+	const float s=sin(0.0f);//theta
+
+	VectorScale(basis1, 0.5f * c / fRadius,taxis);
+	VectorMA(taxis,     0.5f * s / fRadius,basis2,taxis);
+
+	VectorScale(basis1,-0.5f * s / fRadius,saxis);
+	VectorMA(    saxis, 0.5f * c / fRadius,basis2,saxis);
+
+	//rayDir/=lengthSquared(raydir);
+	const float f = VectorLengthSquared(rayDir);
+	rayDir[0]/=f;
+	rayDir[1]/=f;
+	rayDir[2]/=f;
+}
+
+CTraceBounds::CTraceBounds(const vec3_t initrayStart, const vec3_t initrayEnd, float fRadius)
+{
+	VectorCopy(initrayStart, rayStart);
+	VectorCopy(initrayEnd, rayEnd);
+	// same test G2_TraceSurfaces uses to pick the poly test
+	radiusTrace = !(fabs(fRadius) < 0.1);
+	if (radiusTrace)
+	{
+		G2_RadiusTraceAxes(rayStart, rayEnd, fRadius, axes[0], axes[1], axes[2]);
+	}
+}
+
 // assorted Ghoul 2 functions.
 // list all surfaces associated with a model
 void G2_List_Model_Surfaces(const char *fileName)
@@ -385,6 +449,151 @@ int G2_DecideTraceLod(CGhoul2Info &ghoul2, int useLod)
 	return returnLod;
 }
 
+#ifdef G2_SIMD
+extern cvar_t	*r_Ghoul2NoSimd;
+static qboolean	g2_benchNoSimd;		// set by R_G2SkinBench_f for its scalar runs
+
+/*
+================
+R_SkinBlock
+
+Does the vert transform of R_TransformEachSurface for the four verts of a
+skin block, with the same operations in the same order so the results are
+identical
+================
+*/
+#if defined(G2_SIMD_SSE)
+static inline void R_SkinBlock( const mdxmSkinBlock_t *block, const float * const *bones, const vec3_t scale, float out[3][4] )
+{
+	__m128	x = _mm_loadu_ps( block->xyz[0] );
+	__m128	y = _mm_loadu_ps( block->xyz[1] );
+	__m128	z = _mm_loadu_ps( block->xyz[2] );
+	__m128	vert[3], w, m0, m1, m2, m3;
+	int		i, k;
+
+	vert[0] = vert[1] = vert[2] = _mm_setzero_ps();
+
+	for ( k = 0 ; k < block->numWeights ; k++ )
+	{
+		const float *b0 = bones[block->boneRefs[k][0]];
+		const float *b1 = bones[block->boneRefs[k][1]];
+		const float *b2 = bones[block->boneRefs[k][2]];
+		const float *b3 = bones[block->boneRefs[k][3]];
+
+		w = _mm_loadu_ps( block->weights[k] );
+		for ( i = 0 ; i < 3 ; i++ )
+		{
+			// row i of each vert's bone, turned into one column per matrix element
+			m0 = _mm_loadu_ps( b0 + i * 4 );
+			m1 = _mm_loadu_ps( b1 + i * 4 );
+			m2 = _mm_loadu_ps( b2 + i * 4 );
+			m3 = _mm_loadu_ps( b3 + i * 4 );
+			_MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+
+			// tempVert[i] += fBoneWeight * ( DotProduct( bone.matrix[i], v->vertCoords ) + bone.matrix[i][3] )
+			vert[i] = _mm_add_ps( vert[i], _mm_mul_ps( w,
+				_mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( m0, x ), _mm_mul_ps( m1, y ) ), _mm_mul_ps( m2, z ) ), m3 ) ) );
+		}
+	}
+
+	for ( i = 0 ; i < 3 ; i++ )
+	{
+		_mm_storeu_ps( out[i], _mm_mul_ps( vert[i], _mm_set1_ps( scale[i] ) ) );
+	}
+}
+#elif defined(G2_SIMD_NEON)
+static inline void R_SkinBlock( const mdxmSkinBlock_t *block, const float * const *bones, const vec3_t scale, float out[3][4] )
+{
+	float32x4_t		x = vld1q_f32( block->xyz[0] );
+	float32x4_t		y = vld1q_f32( block->xyz[1] );
+	float32x4_t		z = vld1q_f32( block->xyz[2] );
+	float32x4_t		vert[3], w, m0, m1, m2, m3;
+	float32x4x2_t	t01, t23;
+	int				i, k;
+
+	vert[0] = vert[1] = vert[2] = vdupq_n_f32( 0.0f );
+
+	for ( k = 0 ; k < block->numWeights ; k++ )
+	{
+		const float *b0 = bones[block->boneRefs[k][0]];
+		const float *b1 = bones[block->boneRefs[k][1]];
+		const float *b2 = bones[block->boneRefs[k][2]];
+		const float *b3 = bones[block->boneRefs[k][3]];
+
+		w = vld1q_f32( block->weights[k] );
+		for ( i = 0 ; i < 3 ; i++ )
+		{
+			// row i of each vert's bone, turned into one column per matrix element
+			t01 = vtrnq_f32( vld1q_f32( b0 + i * 4 ), vld1q_f32( b1 + i * 4 ) );
+			t23 = vtrnq_f32( vld1q_f32( b2 + i * 4 ), vld1q_f32( b3 + i * 4 ) );
+			m0 = vcombine_f32( vget_low_f32( t01.val[0] ), vget_low_f32( t23.val[0] ) );
+			m1 = vcombine_f32( vget_low_f32( t01.val[1] ), vget_low_f32( t23.val[1] ) );
+			m2 = vcombine_f32( vget_high_f32( t01.val[0] ), vget_high_f32( t23.val[0] ) );
+			m3 = vcombine_f32( vget_high_f32( t01.val[1] ), vget_high_f32( t23.val[1] ) );
+
+			// tempVert[i] += fBoneWeight * ( DotProduct( bone.matrix[i], v->vertCoords ) + bone.matrix[i][3] )
+			vert[i] = vaddq_f32( vert[i], vmulq_f32( w,
+				vaddq_f32( vaddq_f32( vaddq_f32( vmulq_f32( m0, x ), vmulq_f32( m1, y ) ), vmulq_f32( m2, z ) ), m3 ) ) );
+		}
+	}
+
+	for ( i = 0 ; i < 3 ; i++ )
+	{
+		vst1q_f32( out[i], vmulq_n_f32( vert[i], scale[i] ) );
+	}
+}
+#endif
+
+/*
+================
+R_TransformSkinBlocks
+
+R_TransformEachSurface for surfaces with skin blocks, see R_LoadMDXMSkinBlocks
+================
+*/
+static void R_TransformSkinBlocks( const mdxmSurface_t *surface, const mdxmSkinBlock_t *blocks, vec3_t scale, IHeapAllocator *G2VertSpace, size_t *TransformedVertsArray, CBoneCache *boneCache )
+{
+	const int					*piBoneReferences = (int*) ((byte*)surface + surface->ofsBoneReferences);
+	const mdxmVertexTexCoord_t	*pTexCoords = (mdxmVertexTexCoord_t *) &((mdxmVertex_t *) ((byte *)surface + surface->ofsVerts))[surface->numVerts];
+	const float					*bones[iMAX_G2_BONEREFS_PER_SURFACE];
+	float						out[3][4];
+	float						*TransformedVerts;
+	int							j, k, count;
+
+	// alloc some space for the transformed verts to get put in
+	TransformedVerts = (float *)G2VertSpace->MiniHeapAlloc(surface->numVerts * 5 * 4);
+	TransformedVertsArray[surface->thisSurfaceIndex] = (size_t)TransformedVerts;
+	if (!TransformedVerts)
+	{
+		Com_Error(ERR_DROP, "Ran out of transform space for Ghoul2 Models. Adjust MiniHeapSize in SV_SpawnServer.\n");
+	}
+
+	// look the bones up once for the whole surface rather than for every weight
+	for ( k = 0 ; k < surface->numBoneReferences ; k++ )
+	{
+		bones[k] = &EvalBoneCache(piBoneReferences[k],boneCache).matrix[0][0];
+	}
+
+	for ( j = 0 ; j < surface->numVerts ; j += 4, blocks++ )
+	{
+		R_SkinBlock( blocks, bones, scale, out );
+
+		count = Q_min( surface->numVerts - j, 4 );
+		for ( k = 0 ; k < count ; k++ )
+		{
+			float *pos = TransformedVerts + ( j + k ) * 5;
+
+			pos[0] = out[0][k];
+			pos[1] = out[1][k];
+			pos[2] = out[2][k];
+			// we will need the S & T coors too for hitlocation and hitmaterial stuff
+			pos[3] = pTexCoords[j + k].texCoords[0];
+			pos[4] = pTexCoords[j + k].texCoords[1];
+		}
+	}
+}
+#endif // G2_SIMD
+
 void R_TransformEachSurface( const mdxmSurface_t *surface, vec3_t scale, IHeapAllocator *G2VertSpace, size_t *TransformedVertsArray,CBoneCache *boneCache)
 {
 	int				 j, k;
@@ -496,8 +705,113 @@ void R_TransformEachSurface( const mdxmSurface_t *surface, vec3_t scale, IHeapAl
 	}
 }
 
+// see if any triangle of a surface could be hit by a trace, by moving the surface's
+// bone bounds (see R_LoadMDXMBoneBounds) along with the bones and checking the ray against them
+static bool G2_TraceMayHitSurface(const CTraceBounds &TB, const mdxmSurface_t *surface, const mdxmBoneBounds_t *bounds, vec3_t scale, CBoneCache *boneCache)
+{
+	const int	*piBoneReferences = (int*) ((byte*)surface + surface->ofsBoneReferences);
+	vec3_t		mins, maxs, center, extents;
+	int			i, k;
+
+	ClearBounds(mins, maxs);
+	for (k = 0; k < surface->numBoneReferences; k++)
+	{
+		if (bounds[k].extents[0] < 0.0f)
+		{
+			continue;
+		}
+
+		const mdxaBone_t &bone=EvalBoneCache(piBoneReferences[k],boneCache);
+
+		for (i = 0; i < 3; i++)
+		{
+			const float c = DotProduct(bone.matrix[i], bounds[k].center) + bone.matrix[i][3];
+			const float e = fabs(bone.matrix[i][0]) * bounds[k].extents[0] + fabs(bone.matrix[i][1]) * bounds[k].extents[1] + fabs(bone.matrix[i][2]) * bounds[k].extents[2];
+
+			if (c - e < mins[i])
+			{
+				mins[i] = c - e;
+			}
+			if (c + e > maxs[i])
+			{
+				maxs[i] = c + e;
+			}
+		}
+	}
+
+	if (mins[0] > maxs[0])
+	{ // no verts at all
+		return false;
+	}
+
+	// the transformed verts get scaled after skinning
+	for (i = 0; i < 3; i++)
+	{
+		center[i] = 0.5f * (mins[i] + maxs[i]) * scale[i];
+		extents[i] = 0.5f * (maxs[i] - mins[i]) * fabs(scale[i]);
+	}
+
+	if (TB.radiusTrace)
+	{ // G2_RadiusTracePolys misses the whole surface when every vert is out past the same side of one of its axes
+		vec3_t	delta;
+
+		VectorSubtract(center, TB.rayStart, delta);
+		for (i = 0; i < 3; i++)
+		{
+			const float d = DotProduct(delta, TB.axes[i]) + (i < 2 ? 0.5f : 0.0f);
+			const float e = fabs(TB.axes[i][0]) * extents[0] + fabs(TB.axes[i][1]) * extents[1] + fabs(TB.axes[i][2]) * extents[2];
+
+			if (d + e <= 0.0f || d - e >= 1.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// a point trace only hits triangles the segment passes through, so clip the segment to the box
+	float tmin = 0.0f, tmax = 1.0f;
+	for (i = 0; i < 3; i++)
+	{
+		const float d = TB.rayEnd[i] - TB.rayStart[i];
+		const float lo = center[i] - extents[i] - TB.rayStart[i];
+		const float hi = center[i] + extents[i] - TB.rayStart[i];
+
+		if (fabs(d) < 0.0001f)
+		{
+			if (lo > 0.0f || hi < 0.0f)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float t1 = lo / d;
+		float t2 = hi / d;
+		if (t1 > t2)
+		{
+			const float t = t1;
+			t1 = t2;
+			t2 = t;
+		}
+		if (t1 > tmin)
+		{
+			tmin = t1;
+		}
+		if (t2 < tmax)
+		{
+			tmax = t2;
+		}
+		if (tmin > tmax)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void G2_TransformSurfaces(int surfaceNum, surfaceInfo_v &rootSList,
-					CBoneCache *boneCache, const model_t *currentModel, int lod, vec3_t scale, IHeapAllocator *G2VertSpace, size_t *TransformedVertArray, bool secondTimeAround)
+					CBoneCache *boneCache, const model_t *currentModel, int lod, vec3_t scale, IHeapAllocator *G2VertSpace, size_t *TransformedVertArray, bool secondTimeAround, const CTraceBounds *traceBounds = NULL)
 {
 	int	i;
 	assert(currentModel);
@@ -520,8 +834,34 @@ void G2_TransformSurfaces(int surfaceNum, surfaceInfo_v &rootSList,
 	// if this surface is not off, add it to the shader render list
 	if (!offFlags)
 	{
+		const mdxmBoneBounds_t *bounds = NULL;
+
+		if (traceBounds && currentModel->mdxmBoneBounds)
+		{
+			bounds = currentModel->mdxmBoneBounds[lod * currentModel->mdxm->numSurfaces + surface->thisSurfaceIndex];
+		}
+
+		// leave out surfaces the trace can't reach, G2_TraceSurfaces skips them
+		if (!bounds || G2_TraceMayHitSurface(*traceBounds, surface, bounds, scale, boneCache))
+		{
+#ifdef G2_SIMD
+			const mdxmSkinBlock_t *skinBlocks = NULL;
+
+			if (currentModel->mdxmSkinBlocks && (!r_Ghoul2NoSimd || !r_Ghoul2NoSimd->integer) && !g2_benchNoSimd)
+			{
+				skinBlocks = currentModel->mdxmSkinBlocks[lod * currentModel->mdxm->numSurfaces + surface->thisSurfaceIndex];
+			}
 
-		R_TransformEachSurface(surface, scale, G2VertSpace, TransformedVertArray, boneCache);
+			if (skinBlocks)
+			{
+				R_TransformSkinBlocks(surface, skinBlocks, scale, G2VertSpace, TransformedVertArray, boneCache);
+			}
+			else
+#endif
+			{
+				R_TransformEachSurface(surface, scale, G2VertSpace, TransformedVertArray, boneCache);
+			}
+		}
 	}
 
 	// if we are turning off all descendants, then stop this recursion now
@@ -533,15 +873,16 @@ void G2_TransformSurfaces(int surfaceNum, surfaceInfo_v &rootSList,
 	// now recursively call for the children
 	for (i=0; i< surfInfo->numChildren; i++)
 	{
-		G2_TransformSurfaces(surfInfo->childIndexes[i], rootSList, boneCache, currentModel, lod, scale, G2VertSpace, TransformedVertArray, secondTimeAround);
+		G2_TransformSurfaces(surfInfo->childIndexes[i], rootSList, boneCache, currentModel, lod, scale, G2VertSpace, TransformedVertArray, secondTimeAround, traceBounds);
 	}
 }
 
 // main calling point for the model transform for collision detection. At this point all of the skeleton has been transformed.
+// given traceBounds, surfaces the model space ray can't reach are left untransformed, with no verts in mTransformedVertsArray
 #ifdef _G2_GORE
-void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore)
+void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore, const CTraceBounds *traceBounds)
 #else
-void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod)
+void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, const CTraceBounds *traceBounds)
 #endif
 {
 	int				i, lod;
@@ -630,8 +971,9 @@ void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale,
 
 		G2_FindOverrideSurface(-1,g.mSlist); //reset the quick surface override lookup;
 		// recursively call the model surface transform
-
-		G2_TransformSurfaces(g.mSurfaceRoot, g.mSlist, g.mBoneCache,  g.currentModel, lod, correctScale, G2VertSpace, g.mTransformedVertsArray, false);
+		// zone space verts get reused by G2API_CollisionDetectCache for other rays, so those need every surface
+		G2_TransformSurfaces(g.mSurfaceRoot, g.mSlist, g.mBoneCache,  g.currentModel, lod, correctScale, G2VertSpace, g.mTransformedVertsArray, false,
+			(g.mFlags & GHOUL2_ZONETRANSALLOC) ? NULL : traceBounds);
 
 #ifdef _G2_GORE
 		if (ApplyGore && firstModelOnly)
@@ -644,6 +986,124 @@ void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale,
 }
 
 
+/*
+=================
+R_G2SkinBench_f
+
+Skins a model at a spread of animation frames one vert at a time and four
+at a time, checks that both give the same verts and reports the times
+=================
+*/
+void R_G2SkinBench_f( void )
+{
+#ifdef G2_SIMD
+	const int		numPoses = 16;
+	const char		*name;
+	int				rounds, pose, pass, i, j, size, numVerts, mismatches, start, msec[2];
+	CGhoul2Info_v	*ghoul2 = NULL;
+	size_t			*transformed[2];
+	vec3_t			scale;
+
+	name = ri.Cmd_Argc() > 1 ? ri.Cmd_Argv( 1 ) : "models/players/_humanoid/_humanoid.glm";
+	rounds = ri.Cmd_Argc() > 2 ? Com_Clampi( 1, 100000, atoi( ri.Cmd_Argv( 2 ) ) ) : 200;
+
+	G2API_InitGhoul2Model( &ghoul2, name, 0 );
+	if ( !ghoul2 || !(*ghoul2)[0].mValid || !(*ghoul2)[0].aHeader )
+	{
+		Com_Printf( "Couldn't load %s\n", name );
+		if ( ghoul2 )
+		{
+			G2API_CleanGhoul2Models( &ghoul2 );
+		}
+		return;
+	}
+
+	CGhoul2Info		&g = (*ghoul2)[0];
+	const model_t	*mod = g.currentModel;
+
+	G2API_SetBoneAnim( *ghoul2, 0, "model_root", 0, g.aHeader->numFrames, BONE_ANIM_OVERRIDE_LOOP, 1.0f, 0 );
+
+	// room for every surface of the top LOD
+	size = mod->mdxm->numSurfaces * sizeof( size_t ) + 1024;
+	numVerts = 0;
+	for ( i = 0 ; i < mod->mdxm->numSurfaces ; i++ )
+	{
+		const mdxmSurface_t *surface = (mdxmSurface_t *)G2_FindSurface( (void *)mod, i, 0 );
+
+		numVerts += surface->numVerts;
+		size += surface->numVerts * 5 * 4 + 64;
+	}
+
+	CMiniHeap		heap0( size ), heap1( size );
+	CMiniHeap		*heaps[2] = { &heap0, &heap1 };
+
+	mismatches = msec[0] = msec[1] = 0;
+	for ( pose = 0 ; pose < numPoses ; pose++ )
+	{
+		const int time = pose * 250;
+
+		if ( pose & 1 )
+		{
+			VectorSet( scale, 1.25f, 1.25f, 1.1f );
+		}
+		else
+		{
+			VectorSet( scale, 1.0f, 1.0f, 1.0f );
+		}
+		G2_ConstructGhoulSkeleton( *ghoul2, time, true, scale );
+
+		// one vert at a time first, then four
+		for ( pass = 0 ; pass < 2 ; pass++ )
+		{
+			g2_benchNoSimd = pass ? qfalse : qtrue;
+			start = ri.Milliseconds();
+			for ( j = 0 ; j < rounds ; j++ )
+			{
+				heaps[pass]->ResetHeap();
+#ifdef _G2_GORE
+				G2_TransformModel( *ghoul2, time, scale, heaps[pass], 0, false );
+#else
+				G2_TransformModel( *ghoul2, time, scale, heaps[pass], 0 );
+#endif
+			}
+			msec[pass] += ri.Milliseconds() - start;
+			transformed[pass] = g.mTransformedVertsArray;
+		}
+		g2_benchNoSimd = qfalse;
+
+		for ( i = 0 ; i < mod->mdxm->numSurfaces ; i++ )
+		{
+			const mdxmSurface_t *surface = (mdxmSurface_t *)G2_FindSurface( (void *)mod, i, 0 );
+			const float *verts[2] = { (float *)transformed[0][i], (float *)transformed[1][i] };
+
+			if ( !verts[0] || !verts[1] )
+			{
+				mismatches += ( !verts[0] != !verts[1] ) ? surface->numVerts : 0;
+				continue;
+			}
+			for ( j = 0 ; j < surface->numVerts * 5 ; j++ )
+			{
+				if ( verts[0][j] != verts[1][j] )
+				{
+					mismatches++;
+				}
+			}
+		}
+	}
+
+	if ( mismatches )
+	{
+		Com_Printf( S_COLOR_YELLOW "%i vert values differ between one and four verts at a time\n", mismatches );
+	}
+	Com_Printf( "%s: %i verts x %i poses x %i rounds, %i msec one vert at a time, %i msec four at a time\n",
+		name, numVerts, numPoses, rounds, msec[0], msec[1] );
+
+	G2API_CleanGhoul2Models( &ghoul2 );
+#else
+	Com_Printf( "Ghoul2 verts are only skinned one at a time on this platform.\n" );
+#endif
+}
+
 // work out how much space a triangle takes
 static float	G2_AreaOfTri(const vec3_t A, const vec3_t B, const vec3_t C)
 {
@@ -1201,54 +1661,16 @@ static bool G2_RadiusTracePolys(
 								)
 {
 	int		j;
-	vec3_t basis1;
-	vec3_t basis2;
 	vec3_t taxis;
 	vec3_t saxis;
-
-	basis2[0]=0.0f;
-	basis2[1]=0.0f;
-	basis2[2]=1.0f;
-
 	vec3_t v3RayDir;
-	VectorSubtract(TS.rayEnd, TS.rayStart, v3RayDir);
 
-	CrossProduct(v3RayDir,basis2,basis1);
-
-	if (DotProduct(basis1,basis1)<.1f)
-	{
-		basis2[0]=0.0f;
-		basis2[1]=1.0f;
-		basis2[2]=0.0f;
-		CrossProduct(v3RayDir,basis2,basis1);
-	}
-
-	CrossProduct(v3RayDir,basis1,basis2);
-	// Give me a shot direction not a bunch of zeros :) -Gil
-//	assert(DotProduct(basis1,basis1)>.0001f);
-//	assert(DotProduct(basis2,basis2)>.0001f);
-
-	VectorNormalize(basis1);
-	VectorNormalize(basis2);
-
-	const float c=cos(0.0f);//theta
-	const float s=sin(0.0f);//theta
-
-	VectorScale(basis1, 0.5f * c / TS.m_fRadius,taxis);
-	VectorMA(taxis,     0.5f * s / TS.m_fRadius,basis2,taxis);
-
-	VectorScale(basis1,-0.5f * s /TS.m_fRadius,saxis);
-	VectorMA(    saxis, 0.5f * c /TS.m_fRadius,basis2,saxis);
+	G2_RadiusTraceAxes(TS.rayStart, TS.rayEnd, TS.m_fRadius, saxis, taxis, v3RayDir);
 
 	const float * const verts = (float *)TS.TransformedVertsArray[surface->thisSurfaceIndex];
 	const int numVerts = surface->numVerts;
 
 	int flags=63;
-	//rayDir/=lengthSquared(raydir);
-	const float f = VectorLengthSquared(v3RayDir);
-	v3RayDir[0]/=f;
-	v3RayDir[1]/=f;
-	v3RayDir[2]/=f;
 
 	for ( j = 0; j < numVerts; j++ )
 	{
@@ -1436,7 +1858,11 @@ static void G2_TraceSurfaces(CTraceSurface &TS)
 		if (TS.collRecMap)
 		{
 #endif
-			if (!(fabs(TS.m_fRadius) < 0.1))	// if not a point-trace
+			if (!TS.TransformedVertsArray[surface->thisSurfaceIndex])
+			{
+				// G2_TransformModel found the ray can't reach this surface
+			}
+			else if (!(fabs(TS.m_fRadius) < 0.1))	// if not a point-trace
 			{
 				// .. then use radius check
 				//
@@ -185,6 +185,8 @@ cvar_t	*r_noPrecacheGLA;
 cvar_t	*r_noServerGhoul2;
 cvar_t	*r_Ghoul2AnimSmooth=0;
 cvar_t	*r_Ghoul2UnSqashAfterSmooth=0;
+cvar_t	*r_Ghoul2NoSimd=0;
+cvar_t	*r_Ghoul2FrameCache=0;
 //cvar_t	*r_Ghoul2UnSqash;
 //cvar_t	*r_Ghoul2TimeBase=0; from single player
 //cvar_t	*r_Ghoul2NoLerp;
@@ -288,6 +290,8 @@ static consoleCommand_t	commands[] = {
 	{ "modellist",			R_Modellist_f },
 	{ "modelist",			R_ModeList_f },
 	{ "modelcacheinfo",		RE_RegisterModels_Info_f },
+	{ "g2skinbench",		R_G2SkinBench_f },
+	{ "g2copybench",		R_G2CopyBench_f },
 };
 
 static const size_t numCommands = ARRAY_LEN( commands );
@@ -440,6 +444,8 @@ Ghoul2 Insert Start
 	r_noServerGhoul2					= ri.Cvar_Get( "r_noserverghoul2",					"0",						CVAR_CHEAT, "" );
 	r_Ghoul2AnimSmooth					= ri.Cvar_Get( "r_ghoul2animsmooth",				"0.3",						CVAR_NONE, "" );
 	r_Ghoul2UnSqashAfterSmooth			= ri.Cvar_Get( "r_ghoul2unsqashaftersmooth",		"1",						CVAR_NONE, "" );
+	r_Ghoul2NoSimd						= ri.Cvar_Get( "r_ghoul2nosimd",					"0",						CVAR_CHEAT, "Skin Ghoul2 collision verts one at a time instead of four at once" );
+	r_Ghoul2FrameCache					= ri.Cvar_Get( "r_ghoul2framecache",				"1024",						CVAR_ARCHIVE_ND, "KB of decompressed Ghoul2 animation frames each thread keeps, 0 to decode every bone as it is needed" );
 	broadsword							= ri.Cvar_Get( "broadsword",						"0",						CVAR_NONE, "" );
 	broadsword_kickbones				= ri.Cvar_Get( "broadsword_kickbones",				"1",						CVAR_NONE, "" );
 	broadsword_kickorigin				= ri.Cvar_Get( "broadsword_kickorigin",			"1",						CVAR_NONE, "" );
@@ -537,12 +543,35 @@ void RE_Shutdown( qboolean destroyWindow, qboolean restarting ) {
 	for ( size_t i = 0; i < numCommands; i++ )
 		ri.Cmd_RemoveCommand( commands[i].cmd );
 
+	G2_FlushFrameCaches();
+
 	tr.registered = qfalse;
 }
 
 static void G2API_BoltMatrixReconstruction( qboolean reconstruct ) { gG2_GBMNoReconstruct = (qboolean)!reconstruct; }
 static void G2API_BoltMatrixSPMethod( qboolean spMethod ) { gG2_GBMUseSPMethod = spMethod; }
 
+/*
+===============
+R_SVRegister
+
+The dedicated server never runs R_Init, this registers the few cvars and
+commands its Ghoul2 code has
+===============
+*/
+void R_SVRegister( void )
+{
+	if ( r_Ghoul2NoSimd )
+	{
+		return;
+	}
+
+	r_Ghoul2NoSimd = ri.Cvar_Get( "r_ghoul2nosimd", "0", CVAR_CHEAT, "Skin Ghoul2 collision verts one at a time instead of four at once" );
+	r_Ghoul2FrameCache = ri.Cvar_Get( "r_ghoul2framecache", "1024", CVAR_ARCHIVE_ND, "KB of decompressed Ghoul2 animation frames each thread keeps, 0 to decode every bone as it is needed" );
+	ri.Cmd_AddCommand( "g2skinbench", R_G2SkinBench_f, "Times skinning a Ghoul2 model one vert and four verts at a time" );
+	ri.Cmd_AddCommand( "g2copybench", R_G2CopyBench_f, "Times duplicating and freeing Ghoul2 instances with and without recycling" );
+}
+
 extern void R_SVModelInit( void ); //tr_model.cpp
 extern qboolean gG2_GBMNoReconstruct;
 extern qboolean gG2_GBMUseSPMethod;
@@ -600,6 +629,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp ) {
 	re.G2API_ClearAttachedInstance			= G2API_ClearAttachedInstance;
 	re.G2API_CollisionDetect				= G2API_CollisionDetect;
 	re.G2API_CollisionDetectCache			= G2API_CollisionDetectCache;
+	re.G2API_ConstructGhoulSkeletons		= G2API_ConstructGhoulSkeletons;
 	re.G2API_CopyGhoul2Instance				= G2API_CopyGhoul2Instance;
 	re.G2API_CopySpecificG2Model			= G2API_CopySpecificG2Model;
 	re.G2API_DetachG2Model					= G2API_DetachG2Model;
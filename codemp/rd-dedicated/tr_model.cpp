@@ -369,6 +369,7 @@ qboolean RE_RegisterModels_LevelLoadEnd(qboolean bDeleteEverythingNotUsedThisLev
 
 				if (CachedModel.pModelDiskImage) {
 					Z_Free(CachedModel.pModelDiskImage);
+					G2_FlushFrameCaches();
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
 					bAtLeastoneModelFreed = qtrue;
 				}
@@ -423,6 +424,7 @@ static void RE_RegisterModels_DumpNonPure(void)
 
 				if (CachedModel.pModelDiskImage) {
 					Z_Free(CachedModel.pModelDiskImage);
+					G2_FlushFrameCaches();
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
 				}
 
@@ -481,6 +483,7 @@ static void RE_RegisterModels_DeleteAll(void)
 
 		if (CachedModel.pModelDiskImage) {
 			Z_Free(CachedModel.pModelDiskImage);
+			G2_FlushFrameCaches();
 		}
 
 		CachedModels->erase(itModel++);
@@ -1054,6 +1057,12 @@ Ghoul2 Insert End
 				break;
 			case MDXM_IDENT:
 				loaded = ServerLoadMDXM( mod, buf, filename, bAlreadyCached );
+				if ( loaded ) {
+					R_LoadMDXMBoneBounds( mod );
+#ifdef G2_SIMD
+					R_LoadMDXMSkinBlocks( mod );
+#endif
+				}
 				break;
 			default:
 				goto fail;
@@ -1268,6 +1277,12 @@ Ghoul2 Insert End
 
 			case MDXM_IDENT:
 				loaded = R_LoadMDXM( mod, buf, filename, bAlreadyCached );
+				if ( loaded ) {
+					R_LoadMDXMBoneBounds( mod );
+#ifdef G2_SIMD
+					R_LoadMDXMSkinBlocks( mod );
+#endif
+				}
 				break;
 
 			case MD3_IDENT:
@@ -1549,6 +1564,7 @@ static qboolean R_LoadMD3 (model_t *mod, int lod, void *buffer, const char *mod_
 
 void R_SVModelInit()
 {
+	R_SVRegister();
 	R_ModelInit();
 }
 
@@ -28,7 +28,6 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "tr_local.h"
 
 #include <set>
-#include <list>
 
 #ifdef _FULL_G2_LEAK_CHECKING
 int g_Ghoul2Allocations = 0;
@@ -391,19 +390,39 @@ static size_t DeserializeGhoul2Info ( const char *buffer, CGhoul2Info& g2Info )
 	return static_cast<size_t>(buffer - base);
 }
 
+// how many deleted CGhoul2Infos are kept around, with the storage of their
+// surface, bolt and bone lists, for copies to reuse
+#define G2_MAX_RECYCLED_INFOS (256)
+
+static bool g2_benchNoRecycle;	// set by R_G2CopyBench_f for its runs without recycling
+
 class Ghoul2InfoArray : public IGhoul2InfoArray
 {
 	std::vector<CGhoul2Info>	mInfos[MAX_G2_MODELS];
 	int					mIds[MAX_G2_MODELS];
-	std::list<int>			mFreeIndecies;
+	int					mFreeIndecies[MAX_G2_MODELS];	// ring of free slots, New() takes from the front
+	int					mFreeHead;
+	int					mNumFree;
+	std::vector<CGhoul2Info>	mRecycled;
 	void DeleteLow(int idx)
 	{
-		for (size_t model=0; model< mInfos[idx].size(); model++)
+		// last model first, so a copy takes them back in order and gets lists of about the right size
+		for (int model=(int)mInfos[idx].size()-1; model>=0; model--)
 		{
-			if (mInfos[idx][model].mBoneCache)
+			CGhoul2Info &info = mInfos[idx][model];
+
+			if (info.mBoneCache)
 			{
-				RemoveBoneCache(mInfos[idx][model].mBoneCache);
-				mInfos[idx][model].mBoneCache=0;
+				RemoveBoneCache(info.mBoneCache);
+				info.mBoneCache=0;
+			}
+			if (mRecycled.size() < G2_MAX_RECYCLED_INFOS && !g2_benchNoRecycle)
+			{
+				// clear() keeps the capacity, so a copy into this info won't have to allocate
+				info.mSlist.clear();
+				info.mBltlist.clear();
+				info.mBlist.clear();
+				mRecycled.push_back(std::move(info));
 			}
 		}
 
@@ -412,13 +431,15 @@ class Ghoul2InfoArray : public IGhoul2InfoArray
 		if ((mIds[idx]>>G2_MODEL_BITS)>(1<<(31-G2_MODEL_BITS)))
 		{
 			mIds[idx]=MAX_G2_MODELS+idx; //rollover reset id to minimum value
-			mFreeIndecies.push_back(idx);
+			mFreeIndecies[(mFreeHead+mNumFree)&G2_INDEX_MASK]=idx;
 		}
 		else
 		{
 			mIds[idx]+=MAX_G2_MODELS;
-			mFreeIndecies.push_front(idx);
+			mFreeHead=(mFreeHead-1)&G2_INDEX_MASK;
+			mFreeIndecies[mFreeHead]=idx;
 		}
+		mNumFree++;
 	}
 public:
 	Ghoul2InfoArray()
@@ -427,16 +448,19 @@ public:
 		for (i=0;i<MAX_G2_MODELS;i++)
 		{
 			mIds[i]=MAX_G2_MODELS+i;
-			mFreeIndecies.push_back(i);
+			mFreeIndecies[i]=i;
 		}
+		mFreeHead=0;
+		mNumFree=MAX_G2_MODELS;
+		mRecycled.reserve(G2_MAX_RECYCLED_INFOS);
 	}
 
 	size_t GetSerializedSize() const
 	{
 		size_t size = 0;
 
-		size += sizeof (int); // size of mFreeIndecies linked list
-		size += mFreeIndecies.size() * sizeof (int);
+		size += sizeof (int); // number of free indices
+		size += mNumFree * sizeof (int);
 
 		size += sizeof (mIds);
 
@@ -458,11 +482,14 @@ public:
 		char *base = buffer;
 
 		// Free indices
-		*(int *)buffer = mFreeIndecies.size();
+		*(int *)buffer = mNumFree;
 		buffer += sizeof (int);
 
-		std::copy (mFreeIndecies.begin(), mFreeIndecies.end(), (int *)buffer);
-		buffer += sizeof (int) * mFreeIndecies.size();
+		for ( int i = 0; i < mNumFree; i++ )
+		{
+			*(int *)buffer = mFreeIndecies[(mFreeHead + i) & G2_INDEX_MASK];
+			buffer += sizeof (int);
+		}
 
 		// IDs
 		memcpy (buffer, mIds, sizeof (mIds));
@@ -492,7 +519,9 @@ public:
 		count = *(int *)buffer;
 		buffer += sizeof (int);
 
-		mFreeIndecies.assign ((int *)buffer, (int *)buffer + count);
+		memcpy (mFreeIndecies, buffer, sizeof (int) * count);
+		mFreeHead = 0;
+		mNumFree = count;
 		buffer += sizeof (int) * count;
 
 		// IDs
@@ -522,20 +551,20 @@ public:
 	~Ghoul2InfoArray()
 	{
 		char mess[1000];
-		if (mFreeIndecies.size()<MAX_G2_MODELS)
+		if (mNumFree<MAX_G2_MODELS)
 		{
-			sprintf(mess,"************************\nLeaked %d ghoul2info slots\n", MAX_G2_MODELS - mFreeIndecies.size());
+			sprintf(mess,"************************\nLeaked %d ghoul2info slots\n", MAX_G2_MODELS - mNumFree);
 			OutputDebugString(mess);
 			int i;
 			for (i=0;i<MAX_G2_MODELS;i++)
 			{
-				list<int>::iterator j;
-				for (j=mFreeIndecies.begin();j!=mFreeIndecies.end();++j)
+				int j;
+				for (j=0;j<mNumFree;j++)
 				{
-					if (*j==i)
+					if (mFreeIndecies[(mFreeHead+j)&G2_INDEX_MASK]==i)
 						break;
 				}
-				if (j==mFreeIndecies.end())
+				if (j==mNumFree)
 				{
 					sprintf(mess,"Leaked Info idx=%d id=%d sz=%d\n", i, mIds[i], mInfos[i].size());
 					OutputDebugString(mess);
@@ -555,15 +584,16 @@ public:
 #endif
 	int New()
 	{
-		if (mFreeIndecies.empty())
+		if (!mNumFree)
 		{
 			assert(0);
 			Com_Error(ERR_FATAL, "Out of ghoul2 info slots");
 
 		}
 		// gonna pull from the front, doing a
-		int idx=*mFreeIndecies.begin();
-		mFreeIndecies.erase(mFreeIndecies.begin());
+		int idx=mFreeIndecies[mFreeHead];
+		mFreeHead=(mFreeHead+1)&G2_INDEX_MASK;
+		mNumFree--;
 		return mIds[idx];
 	}
 	bool IsValid(int handle) const
@@ -607,6 +637,26 @@ public:
 		assert(mIds[handle&G2_INDEX_MASK]==handle); // not a valid handle, could be old or garbage
 		return mInfos[handle&G2_INDEX_MASK];
 	}
+	void Copy(int handle, int fromHandle)
+	{
+		std::vector<CGhoul2Info> &infos=Get(handle);
+		const std::vector<CGhoul2Info> &from=Get(fromHandle);
+
+		assert(infos.empty());
+		for (size_t model=0; model<from.size(); model++)
+		{
+			if (mRecycled.empty() || g2_benchNoRecycle)
+			{
+				infos.push_back(from[model]);
+				continue;
+			}
+			// assigning into a recycled info reuses its list storage
+			CGhoul2Info &info=mRecycled.back();
+			info=from[model];
+			infos.push_back(std::move(info));
+			mRecycled.pop_back();
+		}
+	}
 
 #if G2API_DEBUG
 	vector<CGhoul2Info> &GetDebug(int handle)
@@ -2105,6 +2155,17 @@ qboolean G2API_GetBoltMatrix(CGhoul2Info_v &ghoul2, const int modelIndex, const
 	return qfalse;
 }
 
+// builds ahead of time the skeletons G2API_GetBoltMatrix and G2API_CollisionDetect would otherwise build
+// one at a time, see G2_ConstructGhoulSkeletons
+void G2API_ConstructGhoulSkeletons(CGhoul2Info_v **ghoul2, vec3_t *scales, const int count, const int frameNum)
+{
+	G2ERROR(count<=0||(ghoul2&&scales),"NULL ghoul2 or scale list");
+	if (count > 0 && ghoul2 && scales)
+	{
+		G2_ConstructGhoulSkeletons(ghoul2, scales, count, G2API_GetTime(frameNum));
+	}
+}
+
 void G2API_ListSurfaces(CGhoul2Info *ghlInfo)
 {
 	if (G2_SetupModelPointers(ghlInfo))
@@ -2277,7 +2338,7 @@ void G2API_CollisionDetectCache(CollisionRecord_t *collRecMap, CGhoul2Info_v &gh
 
 				i++;
 			}
-			G2_ConstructGhoulSkeleton(ghoul2, frameNumber, true, scale);
+			G2_ConstructGhoulSkeleton(ghoul2, frameNumber, true, scale, true);
 			G2VertSpace->ResetHeap();
 
 			// now having done that, time to build the model
@@ -2344,25 +2405,28 @@ void G2API_CollisionDetect(CollisionRecord_t *collRecMap, CGhoul2Info_v &ghoul2,
 	{
 		vec3_t	transRayStart, transRayEnd;
 
-		// make sure we have transformed the whole skeletons for each model
-		G2_ConstructGhoulSkeleton(ghoul2, frameNumber, true, scale);
+		// make sure we have transformed the whole skeletons for each model, models
+		// already built for this time (see G2API_ConstructGhoulSkeletons) are kept
+		G2_ConstructGhoulSkeleton(ghoul2, frameNumber, true, scale, true);
 
 		// pre generate the world matrix - used to transform the incoming ray
 		G2_GenerateWorldMatrix(angles, position);
 
+		// translate the ray to model space first, so only the surfaces it can reach get built
+		TransformAndTranslatePoint(rayStart, transRayStart, &worldMatrixInv);
+		TransformAndTranslatePoint(rayEnd, transRayEnd, &worldMatrixInv);
+
 		G2VertSpace->ResetHeap();
 
 		// now having done that, time to build the model
+		CTraceBounds	TB(transRayStart, transRayEnd, fRadius);
 #ifdef _G2_GORE
-		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod, false);
+		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod, false, &TB);
 #else
-		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod);
+		G2_TransformModel(ghoul2, frameNumber, scale, G2VertSpace, useLod, &TB);
 #endif
 
 		// model is built. Lets check to see if any triangles are actually hit.
-		// first up, translate the ray to model space
-		TransformAndTranslatePoint(rayStart, transRayStart, &worldMatrixInv);
-		TransformAndTranslatePoint(rayEnd, transRayEnd, &worldMatrixInv);
 
 		// now walk each model and check the ray against each poly - sigh, this is SO expensive. I wish there was a better way to do this.
 #ifdef _G2_GORE
@@ -2560,6 +2624,129 @@ void G2API_DuplicateGhoul2Instance(CGhoul2Info_v &g2From, CGhoul2Info_v **g2To)
 	return;
 }
 
+/*
+=================
+R_G2CopyBench_f
+
+Duplicates a model and frees the copies over and over, the way respawns and
+corpses do, without and with recycling freed instances, checks that the
+copies match and reports the times
+=================
+*/
+void R_G2CopyBench_f( void )
+{
+	const int		numCopies = 64;
+	const char		*name;
+	int				rounds, pass, round, i, model, mismatches, start, msec[2];
+	CGhoul2Info_v	*ghoul2 = NULL;
+	CGhoul2Info_v	*copies[numCopies];
+	vec3_t			angles;
+
+	name = ri.Cmd_Argc() > 1 ? ri.Cmd_Argv( 1 ) : "models/players/_humanoid/_humanoid.glm";
+	rounds = ri.Cmd_Argc() > 2 ? Com_Clampi( 1, 100000, atoi( ri.Cmd_Argv( 2 ) ) ) : 200;
+
+	G2API_InitGhoul2Model( &ghoul2, name, 0 );
+	if ( !ghoul2 || !(*ghoul2)[0].mValid || !(*ghoul2)[0].aHeader )
+	{
+		Com_Printf( "Couldn't load %s\n", name );
+		if ( ghoul2 )
+		{
+			G2API_CleanGhoul2Models( &ghoul2 );
+		}
+		return;
+	}
+
+	// fill the lists the way a player's are, with a second model for the weapon
+	G2API_InitGhoul2Model( &ghoul2, name, 1 );
+
+	const mdxaHeader_t			*aHeader = (*ghoul2)[0].aHeader;
+	const mdxaSkelOffsets_t		*skelOffsets = (mdxaSkelOffsets_t *)((byte *)aHeader + sizeof( mdxaHeader_t ));
+	const mdxmHeader_t			*mdxm = (*ghoul2)[0].currentModel->mdxm;
+	const mdxmHierarchyOffsets_t	*surfIndexes = (mdxmHierarchyOffsets_t *)((byte *)mdxm + sizeof( mdxmHeader_t ));
+
+	G2API_SetBoneAnim( *ghoul2, 0, "model_root", 0, aHeader->numFrames, BONE_ANIM_OVERRIDE_LOOP, 1.0f, 0 );
+	VectorSet( angles, 10.0f, 20.0f, 0.0f );
+	for ( i = 0 ; i < aHeader->numBones ; i++ )
+	{
+		const mdxaSkel_t *skel = (mdxaSkel_t *)((byte *)skelOffsets + skelOffsets->offsets[i]);
+
+		if ( i % 3 == 1 )
+		{
+			G2API_SetBoneAngles( *ghoul2, 0, skel->name, angles, BONE_ANGLES_POSTMULT, POSITIVE_X, NEGATIVE_Y, NEGATIVE_Z, NULL, 0, 0 );
+		}
+		else if ( i % 3 == 2 )
+		{
+			G2API_AddBolt( *ghoul2, 0, skel->name );
+		}
+	}
+	for ( i = 0 ; i < mdxm->numSurfaces ; i += 4 )
+	{
+		const mdxmSurfHierarchy_t *surf = (mdxmSurfHierarchy_t *)((byte *)surfIndexes + surfIndexes->offsets[i]);
+
+		G2API_SetSurfaceOnOff( *ghoul2, surf->name, G2SURFACEFLAG_OFF );
+	}
+
+	memset( copies, 0, sizeof( copies ) );
+	mismatches = msec[0] = msec[1] = 0;
+
+	// without recycling first, then with
+	for ( pass = 0 ; pass < 2 ; pass++ )
+	{
+		g2_benchNoRecycle = pass ? false : true;
+		start = ri.Milliseconds();
+		for ( round = 0 ; round < rounds ; round++ )
+		{
+			for ( i = 0 ; i < numCopies ; i++ )
+			{
+				G2API_DuplicateGhoul2Instance( *ghoul2, &copies[i] );
+			}
+
+			if ( round == rounds - 1 )
+			{
+				for ( i = 0 ; i < numCopies ; i++ )
+				{
+					const CGhoul2Info_v &from = *ghoul2, &to = *copies[i];
+
+					if ( to.size() != from.size() )
+					{
+						mismatches++;
+						continue;
+					}
+					for ( model = 0 ; model < from.size() ; model++ )
+					{
+						const CGhoul2Info &a = from[model], &b = to[model];
+
+						if ( a.mModelindex != b.mModelindex || Q_stricmp( a.mFileName, b.mFileName )
+							|| a.mSlist.size() != b.mSlist.size() || a.mBltlist.size() != b.mBltlist.size() || a.mBlist.size() != b.mBlist.size()
+							|| ( a.mSlist.size() && memcmp( &a.mSlist[0], &b.mSlist[0], a.mSlist.size() * sizeof( surfaceInfo_t ) ) )
+							|| ( a.mBltlist.size() && memcmp( &a.mBltlist[0], &b.mBltlist[0], a.mBltlist.size() * sizeof( boltInfo_t ) ) )
+							|| ( a.mBlist.size() && memcmp( &a.mBlist[0], &b.mBlist[0], a.mBlist.size() * sizeof( boneInfo_t ) ) ) )
+						{
+							mismatches++;
+						}
+					}
+				}
+			}
+
+			for ( i = 0 ; i < numCopies ; i++ )
+			{
+				G2API_CleanGhoul2Models( &copies[i] );
+			}
+		}
+		msec[pass] = ri.Milliseconds() - start;
+	}
+	g2_benchNoRecycle = false;
+
+	if ( mismatches )
+	{
+		Com_Printf( S_COLOR_YELLOW "%i copied models differ from the original\n", mismatches );
+	}
+	Com_Printf( "%s: %i copies x %i rounds, %i msec without recycling, %i msec with\n",
+		name, numCopies, rounds, msec[0], msec[1] );
+
+	G2API_CleanGhoul2Models( &ghoul2 );
+}
+
 char *G2API_GetSurfaceName(CGhoul2Info_v& ghoul2, int modelIndex, int surfNumber)
 {
 	static char noSurface[1] = "";
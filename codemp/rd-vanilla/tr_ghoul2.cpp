@@ -32,6 +32,10 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "qcommon/disablewarnings.h"
 
+#include <atomic>
+#include <mutex>
+#include <set>
+
 #define	LL(x) x=LittleLong(x)
 #define	LS(x) x=LittleShort(x)
 #define	LF(x) x=LittleFloat(x)
@@ -107,6 +111,7 @@ qboolean G2_SetupModelPointers(CGhoul2Info *ghlInfo);
 qboolean G2_SetupModelPointers(CGhoul2Info_v &ghoul2);
 
 extern cvar_t	*r_Ghoul2AnimSmooth;
+extern cvar_t	*r_Ghoul2FrameCache;
 extern cvar_t	*r_Ghoul2UnSqashAfterSmooth;
 
 #if 0
@@ -1076,8 +1081,221 @@ static int G2_GetBonePoolIndex(const mdxaHeader_t *pMDXAHeader, int iFrame, int
 }
 
 
+/*
+=============================================================================
+
+DECOMPRESSED FRAME CACHE
+
+Every skeleton built decodes two to four frames of every bone, and a crowd
+playing the same _humanoid.gla animations decodes the same frames over and over.
+With r_ghoul2FrameCache set, each thread keeps the whole frames it decoded last
+in an LRU of up to that many KB, so the skeleton jobs never wait on each other.
+The caches are thrown away whenever model data may have been freed.
+
+=============================================================================
+*/
+
+#define G2_FRAMECACHE_HASH	256
+
+typedef struct g2CachedFrame_s {
+	const mdxaHeader_t		*header;
+	int						frame;
+	int						size;
+	struct g2CachedFrame_s	*prev, *next;		// LRU order, most recently used first
+	struct g2CachedFrame_s	*hashNext;
+	mdxaBone_t				*bones;				// numBones matrices, 16 byte aligned
+} g2CachedFrame_t;
+
+typedef struct g2FrameCache_s {
+	int						bytes;
+	g2CachedFrame_t			*first, *last;
+	g2CachedFrame_t			*hash[G2_FRAMECACHE_HASH];
+	struct g2FrameCache_s	*nextCache;
+} g2FrameCache_t;
+
+static std::mutex				g2FrameCacheLock;		// guards the list of caches
+static g2FrameCache_t			*g2FrameCaches;
+static std::atomic<int>			g2FrameCacheGeneration( 1 );
+
+static thread_local g2FrameCache_t	*g2ThreadFrameCache;
+static thread_local int				g2ThreadFrameCacheGeneration;
+
+static int G2_FrameCacheHash( const mdxaHeader_t *pMDXAHeader, int iFrame )
+{
+	return ( (int)( (intptr_t)pMDXAHeader >> 4 ) ^ ( iFrame * 31 ) ) & ( G2_FRAMECACHE_HASH - 1 );
+}
+
+static inline bool G2_FrameCacheMatch( const g2CachedFrame_t *entry, const mdxaHeader_t *pMDXAHeader, int iFrame )
+{
+	return entry->header == pMDXAHeader && entry->frame == iFrame;
+}
+
+static void G2_FrameCacheUnlink( g2FrameCache_t *cache, g2CachedFrame_t *entry )
+{
+	if ( entry->prev )
+		entry->prev->next = entry->next;
+	else
+		cache->first = entry->next;
+
+	if ( entry->next )
+		entry->next->prev = entry->prev;
+	else
+		cache->last = entry->prev;
+}
+
+static void G2_FrameCacheEvict( g2FrameCache_t *cache )
+{
+	g2CachedFrame_t		*entry = cache->last;
+	g2CachedFrame_t		**link = &cache->hash[G2_FrameCacheHash( entry->header, entry->frame )];
+
+	while ( *link != entry )
+	{
+		link = &(*link)->hashNext;
+	}
+	*link = entry->hashNext;
+
+	G2_FrameCacheUnlink( cache, entry );
+	cache->bytes -= entry->size;
+	free( entry );
+}
+
+/*
+==================
+G2_FlushFrameCaches
+
+Drops every thread's cached frames. Only called from the main thread while no
+skeleton jobs are running, a thread notices its cache went away through the
+generation count.
+==================
+*/
+void G2_FlushFrameCaches( void )
+{
+	std::lock_guard<std::mutex> lock( g2FrameCacheLock );
+
+	while ( g2FrameCaches )
+	{
+		g2FrameCache_t	*cache = g2FrameCaches;
+
+		while ( cache->first )
+		{
+			g2CachedFrame_t	*entry = cache->first;
+			cache->first = entry->next;
+			free( entry );
+		}
+
+		g2FrameCaches = cache->nextCache;
+		free( cache );
+	}
+
+	g2FrameCacheGeneration++;
+}
+
+static const mdxaBone_t *G2_GetCachedFrame( const mdxaHeader_t *pMDXAHeader, int iFrame, int maxBytes )
+{
+	g2FrameCache_t	*cache = g2ThreadFrameCache;
+	g2CachedFrame_t	*entry;
+	const int		generation = g2FrameCacheGeneration;
+
+	if ( !cache || g2ThreadFrameCacheGeneration != generation )
+	{
+		// the zone isn't safe to use from the skeleton jobs, so plain malloc throughout
+		cache = (g2FrameCache_t *)calloc( 1, sizeof( g2FrameCache_t ) );
+		if ( !cache )
+		{
+			return NULL;
+		}
+
+		std::lock_guard<std::mutex> lock( g2FrameCacheLock );
+		cache->nextCache = g2FrameCaches;
+		g2FrameCaches = cache;
+		g2ThreadFrameCache = cache;
+		g2ThreadFrameCacheGeneration = g2FrameCacheGeneration;
+	}
+
+	// a skeleton asks for the same few frames bone after bone, so look at the front first
+	entry = cache->first;
+	if ( entry && !G2_FrameCacheMatch( entry, pMDXAHeader, iFrame ) )
+	{
+		entry = entry->next;
+		if ( entry && !G2_FrameCacheMatch( entry, pMDXAHeader, iFrame ) )
+		{
+			entry = cache->hash[G2_FrameCacheHash( pMDXAHeader, iFrame )];
+			while ( entry && !G2_FrameCacheMatch( entry, pMDXAHeader, iFrame ) )
+			{
+				entry = entry->hashNext;
+			}
+		}
+	}
+
+	if ( !entry )
+	{
+		const int	size = sizeof( g2CachedFrame_t ) + 15 + pMDXAHeader->numBones * sizeof( mdxaBone_t );
+
+		if ( size > maxBytes )
+		{
+			return NULL;
+		}
+
+		while ( cache->last && cache->bytes + size > maxBytes )
+		{
+			G2_FrameCacheEvict( cache );
+		}
+
+		entry = (g2CachedFrame_t *)malloc( size );
+		if ( !entry )
+		{
+			return NULL;
+		}
+
+		const mdxaCompQuatBone_t *pCompBonePool = (mdxaCompQuatBone_t *)((byte *)pMDXAHeader + pMDXAHeader->ofsCompBonePool);
+
+		entry->header = pMDXAHeader;
+		entry->frame = iFrame;
+		entry->size = size;
+		entry->bones = (mdxaBone_t *)( ( (intptr_t)( entry + 1 ) + 15 ) & ~(intptr_t)15 );
+		for ( int i = 0 ; i < pMDXAHeader->numBones ; i++ )
+		{
+			MC_UnCompressQuat( entry->bones[i].matrix, pCompBonePool[ G2_GetBonePoolIndex( pMDXAHeader, iFrame, i ) ].Comp );
+		}
+
+		const int hash = G2_FrameCacheHash( pMDXAHeader, iFrame );
+		entry->hashNext = cache->hash[hash];
+		cache->hash[hash] = entry;
+		cache->bytes += size;
+	}
+	else if ( entry == cache->first )
+	{
+		return entry->bones;
+	}
+	else
+	{
+		G2_FrameCacheUnlink( cache, entry );
+	}
+
+	entry->prev = NULL;
+	entry->next = cache->first;
+	if ( cache->first )
+		cache->first->prev = entry;
+	else
+		cache->last = entry;
+	cache->first = entry;
+
+	return entry->bones;
+}
+
 /*static inline*/ void UnCompressBone(float mat[3][4], int iBoneIndex, const mdxaHeader_t *pMDXAHeader, int iFrame)
 {
+	if ( r_Ghoul2FrameCache && r_Ghoul2FrameCache->integer > 0 )
+	{
+		const mdxaBone_t *frame = G2_GetCachedFrame( pMDXAHeader, iFrame, r_Ghoul2FrameCache->integer * 1024 );
+
+		if ( frame )
+		{
+			memcpy( mat, frame[iBoneIndex].matrix, sizeof( mdxaBone_t ) );
+			return;
+		}
+	}
+
 	mdxaCompQuatBone_t *pCompBonePool = (mdxaCompQuatBone_t *) ((byte *)pMDXAHeader + pMDXAHeader->ofsCompBonePool);
 	MC_UnCompressQuat(mat, pCompBonePool[ G2_GetBonePoolIndex( pMDXAHeader, iFrame, iBoneIndex ) ].Comp);
 }
@@ -1462,15 +1680,15 @@ void G2_RagGetAnimMatrix(CGhoul2Info &ghoul2, const int boneNum, mdxaBone_t &mat
 void G2_TransformBone (int child,CBoneCache &BC)
 {
 	SBoneCalc &TB=BC.mBones[child];
-	static mdxaBone_t		tbone[6];
+	mdxaBone_t		tbone[6];
 // 	mdxaFrame_t		*aFrame=0;
 //	mdxaFrame_t		*bFrame=0;
 //	mdxaFrame_t		*aoldFrame=0;
 //	mdxaFrame_t		*boldFrame=0;
-	static mdxaSkel_t		*skel;
-	static mdxaSkelOffsets_t *offsets;
+	mdxaSkel_t		*skel;
+	mdxaSkelOffsets_t *offsets;
 	boneInfo_v		&boneList = *BC.rootBoneList;
-	static int				j, boneListIndex;
+	int				j, boneListIndex;
 	int				angleOverride = 0;
 
 #if DEBUG_G2_TIMING
@@ -1718,7 +1936,7 @@ void G2_TransformBone (int child,CBoneCache &BC)
 			// this is crazy, we are gonna drive the animation to ID while we are doing post mults to compensate.
 			Multiply_3x4Matrix(&temp,&firstPass, &skel->BasePoseMat);
 			float	matrixScale = VectorLength((float*)&temp);
-			static mdxaBone_t		toMatrix =
+			mdxaBone_t		toMatrix =
 			{
 				{
 					{ 1.0f, 0.0f, 0.0f, 0.0f },
@@ -3387,12 +3605,36 @@ bool G2_NeedsRecalc(CGhoul2Info *ghlInfo,int frameNum)
 	return false;
 }
 
+/*
+==============
+G2_BonesAreCurrent - true when a model's bone cache still holds the skeleton it would be built with now.
+Only asked of models that aren't bolted to another one, their bones depend on nothing but their own
+bone list, and every change to that resets mSkelFrameNum.
+==============
+*/
+static bool G2_BonesAreCurrent(CGhoul2Info &ghlInfo,const int frameNum,const mdxaBone_t &rootMatrix)
+{
+	CBoneCache *cache = ghlInfo.mBoneCache;
+
+	return ghlInfo.mSkelFrameNum == frameNum &&
+		!(ghlInfo.mFlags & GHOUL2_RAG_STARTED) &&
+		cache &&
+		cache->mod == ghlInfo.currentModel &&
+		cache->header == ghlInfo.aHeader &&
+		cache->rootBoneList == &ghlInfo.mBlist &&
+		cache->incomingTime == frameNum &&
+		!cache->mCurrentTouchRender &&
+		!memcmp(&cache->rootMatrix, &rootMatrix, sizeof(rootMatrix));
+}
+
 /*
 ==============
 G2_ConstructGhoulSkeleton - builds a complete skeleton for all ghoul models in a CGhoul2Info_v class	- using LOD 0
+
+With keepCurrent, models whose bones are still current for this time keep the bones already evaluated
 ==============
 */
-void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool checkForNewOrigin,const vec3_t scale)
+void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool checkForNewOrigin,const vec3_t scale,bool keepCurrent)
 {
 #ifdef G2_PERFORMANCE_ANALYSIS
 	G2PerformanceTimer_G2_ConstructGhoulSkeleton.Start();
@@ -3433,6 +3675,10 @@ void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool ch
 				G2_GetBoltMatrixLow(ghoul2[boltMod],boltNum,scale,bolt);
 				G2_TransformGhoulBones(ghoul2[i].mBlist,bolt,ghoul2[i],frameNum,checkForNewOrigin);
 			}
+			else if (keepCurrent && G2_BonesAreCurrent(ghoul2[i],frameNum,rootMatrix))
+			{
+				// nothing changed since it was built at this time
+			}
 #ifdef _G2_LISTEN_SERVER_OPT
 			else if (ghoul2[i].entityNum == ENTITYNUM_NONE || ghoul2[i].mSkelFrameNum != frameNum)
 #else
@@ -3448,6 +3694,116 @@ void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool ch
 #endif
 }
 
+void G2_ConstructGhoulSkeleton( CGhoul2Info_v &ghoul2,const int frameNum,bool checkForNewOrigin,const vec3_t scale)
+{
+	G2_ConstructGhoulSkeleton(ghoul2,frameNum,checkForNewOrigin,scale,false);
+}
+
+typedef struct g2SkeletonJob_s {
+	CGhoul2Info_v		**ghoul2;
+	vec3_t				*scales;
+	const int			*instances;
+	int					frameNum;
+} g2SkeletonJob_t;
+
+static void G2_ConstructSkeletonJob( void *data, int index )
+{
+	g2SkeletonJob_t	*job = (g2SkeletonJob_t *)data;
+	const int		instance = job->instances[index];
+	CGhoul2Info_v	&ghoul2 = *job->ghoul2[instance];
+
+	G2_ConstructGhoulSkeleton(ghoul2, job->frameNum, true, job->scales[instance]);
+
+	// evaluate every bone now, rather than on the first bolt or collision query that needs it
+	for (int i = 0; i < ghoul2.size(); i++)
+	{
+		CBoneCache *cache = ghoul2[i].mBoneCache;
+
+		if (ghoul2[i].mValid && cache)
+		{
+			for (int j = 0; j < (int)cache->mBones.size(); j++)
+			{
+				cache->Eval(j);
+			}
+		}
+	}
+}
+
+/*
+==============
+G2_ConstructGhoulSkeletons - builds the skeletons of many instances at once, split between the job threads
+
+Each instance gets the skeleton G2API_GetBoltMatrix would build for it at this time, with every bone
+evaluated, and the models not bolted to another one are marked as built. Instances whose skeleton is
+already built for this time, and ragdolls, are left to be built on demand as before. Model pointers are
+set up and the instances picked here, since registering a model isn't thread safe. An instance that shows
+up more than once in the list is only picked once, so each job only touches its own instance.
+==============
+*/
+void G2_ConstructGhoulSkeletons( CGhoul2Info_v **ghoul2, vec3_t *scales, const int count, const int frameNum )
+{
+	std::vector<int>	instances;
+	std::set<int>		picked;		// by handle, two CGhoul2Info_v can share one
+	g2SkeletonJob_t		job;
+	int					i, k;
+
+	instances.reserve(count);
+
+	for (k = 0; k < count; k++)
+	{
+		if (!ghoul2[k] || !ghoul2[k]->IsValid() || !G2_SetupModelPointers(*ghoul2[k]))
+		{
+			continue;
+		}
+
+		CGhoul2Info_v	&g2 = *ghoul2[k];
+		bool			needed = false;
+		bool			ragdoll = false;
+
+		for (i = 0; i < g2.size(); i++)
+		{
+			if (!g2[i].mValid)
+			{
+				continue;
+			}
+			if (g2[i].mFlags & GHOUL2_RAG_STARTED)
+			{
+				ragdoll = true;
+			}
+			if (g2[i].mModelBoltLink == -1 &&
+				(g2[i].mSkelFrameNum != frameNum || !g2[i].mBoneCache || g2[i].mBoneCache->mod != g2[i].currentModel))
+			{
+				needed = true;
+			}
+		}
+
+		if (!needed || ragdoll || !picked.insert(g2.mItem).second)
+		{
+			continue;
+		}
+
+		for (i = 0; i < g2.size(); i++)
+		{
+			if (g2[i].mValid && g2[i].mModelBoltLink == -1)
+			{
+				g2[i].mSkelFrameNum = frameNum;
+			}
+		}
+		instances.push_back(k);
+	}
+
+	if (instances.empty())
+	{
+		return;
+	}
+
+	job.ghoul2 = ghoul2;
+	job.scales = scales;
+	job.instances = &instances[0];
+	job.frameNum = frameNum;
+	ri.Com_RunJobs(G2_ConstructSkeletonJob, &job, (int)instances.size());
+}
+
 static inline float G2_GetVertBoneWeightNotSlow( const mdxmVertex_t *pVert, const int iWeightNum)
 {
 	float fBoneWeight;
@@ -4428,6 +4784,202 @@ qboolean R_LoadMDXM( model_t *mod, void *buffer, const char *mod_name, qboolean
 	return qtrue;
 }
 
+/*
+=================
+R_LoadMDXMBoneBounds
+
+For each surface of each LOD, bounds the base pose verts weighted to each of
+the surface's bone references. A skinned vert is a weighted average of its
+bones' transforms applied to it, so it always lies inside the hull of its
+bones' transformed boxes, and collision can skip transforming any surface
+whose boxes a trace can't reach. Surfaces with a negative implied weight
+break that, and get no bounds.
+=================
+*/
+#define BONEBOUNDS_EPSILON	1.0f
+
+void R_LoadMDXMBoneBounds( model_t *mod )
+{
+	mdxmHeader_t		*mdxm = mod->mdxm;
+	mdxmLOD_t			*lod;
+	mdxmSurface_t		*surf;
+	mdxmBoneBounds_t	*bounds;
+	int					numBounds;
+	int					l, i, j, k;
+
+	numBounds = 0;
+	lod = (mdxmLOD_t *) ( (byte *)mdxm + mdxm->ofsLODs );
+	for ( l = 0 ; l < mdxm->numLODs ; l++ )
+	{
+		surf = (mdxmSurface_t *) ( (byte *)lod + sizeof (mdxmLOD_t) + (mdxm->numSurfaces * sizeof(mdxmLODSurfOffset_t)) );
+		for ( i = 0 ; i < mdxm->numSurfaces ; i++ )
+		{
+			numBounds += surf->numBoneReferences;
+			surf = (mdxmSurface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+		lod = (mdxmLOD_t *)( (byte *)lod + lod->ofsEnd );
+	}
+
+	mod->mdxmBoneBounds = (mdxmBoneBounds_t **)Hunk_Alloc( mdxm->numLODs * mdxm->numSurfaces * sizeof( mdxmBoneBounds_t * ) + numBounds * sizeof( mdxmBoneBounds_t ), h_low );
+	bounds = (mdxmBoneBounds_t *)( mod->mdxmBoneBounds + mdxm->numLODs * mdxm->numSurfaces );
+
+	lod = (mdxmLOD_t *) ( (byte *)mdxm + mdxm->ofsLODs );
+	for ( l = 0 ; l < mdxm->numLODs ; l++ )
+	{
+		surf = (mdxmSurface_t *) ( (byte *)lod + sizeof (mdxmLOD_t) + (mdxm->numSurfaces * sizeof(mdxmLODSurfOffset_t)) );
+		for ( i = 0 ; i < mdxm->numSurfaces ; i++ )
+		{
+			vec3_t			mins[iMAX_G2_BONEREFS_PER_SURFACE], maxs[iMAX_G2_BONEREFS_PER_SURFACE];
+			const mdxmVertex_t	*v = (mdxmVertex_t *) ( (byte *)surf + surf->ofsVerts );
+			qboolean		bounded = (qboolean)( surf->numBoneReferences <= iMAX_G2_BONEREFS_PER_SURFACE );
+
+			for ( k = 0 ; k < surf->numBoneReferences && bounded ; k++ )
+			{
+				ClearBounds( mins[k], maxs[k] );
+			}
+
+			for ( j = 0 ; j < surf->numVerts && bounded ; j++, v++ )
+			{
+				const int	iNumWeights = G2_GetVertWeights( v );
+				float		fTotalWeight = 0.0f;
+
+				for ( k = 0 ; k < iNumWeights ; k++ )
+				{
+					int		iBoneIndex	= G2_GetVertBoneIndex( v, k );
+					float	fBoneWeight	= G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+
+					if ( iBoneIndex >= surf->numBoneReferences || fBoneWeight < -0.001f )
+					{
+						bounded = qfalse;
+						break;
+					}
+					AddPointToBounds( v->vertCoords, mins[iBoneIndex], maxs[iBoneIndex] );
+				}
+			}
+
+			if ( surf->thisSurfaceIndex < 0 || surf->thisSurfaceIndex >= mdxm->numSurfaces )
+			{
+				bounded = qfalse;
+			}
+
+			if ( bounded )
+			{
+				for ( k = 0 ; k < surf->numBoneReferences ; k++ )
+				{
+					if ( mins[k][0] > maxs[k][0] )
+					{
+						VectorClear( bounds[k].center );
+						VectorSet( bounds[k].extents, -1.0f, -1.0f, -1.0f );
+						continue;
+					}
+					for ( j = 0 ; j < 3 ; j++ )
+					{
+						bounds[k].center[j] = 0.5f * ( mins[k][j] + maxs[k][j] );
+						bounds[k].extents[j] = 0.5f * ( maxs[k][j] - mins[k][j] ) + BONEBOUNDS_EPSILON;
+					}
+				}
+				mod->mdxmBoneBounds[l * mdxm->numSurfaces + surf->thisSurfaceIndex] = bounds;
+			}
+			bounds += surf->numBoneReferences;
+
+			surf = (mdxmSurface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+		lod = (mdxmLOD_t *)( (byte *)lod + lod->ofsEnd );
+	}
+}
+
+#ifdef G2_SIMD
+/*
+=================
+R_LoadMDXMSkinBlocks
+
+Copies the verts of each surface of each LOD into groups of four laid out
+component by component, with their bone weights worked out the same way
+G2_GetVertBoneWeight does, so R_TransformEachSurface can skin four at once
+without unpacking anything. Lanes past a vert's own weights, and past the
+end of the surface, get a weight of 0 on a bone reference the vert already
+uses.
+=================
+*/
+void R_LoadMDXMSkinBlocks( model_t *mod )
+{
+	mdxmHeader_t		*mdxm = mod->mdxm;
+	mdxmLOD_t			*lod;
+	mdxmSurface_t		*surf;
+	mdxmSkinBlock_t		*blocks;
+	int					numBlocks;
+	int					l, i, j, k;
+
+	numBlocks = 0;
+	lod = (mdxmLOD_t *) ( (byte *)mdxm + mdxm->ofsLODs );
+	for ( l = 0 ; l < mdxm->numLODs ; l++ )
+	{
+		surf = (mdxmSurface_t *) ( (byte *)lod + sizeof (mdxmLOD_t) + (mdxm->numSurfaces * sizeof(mdxmLODSurfOffset_t)) );
+		for ( i = 0 ; i < mdxm->numSurfaces ; i++ )
+		{
+			numBlocks += ( surf->numVerts + 3 ) >> 2;
+			surf = (mdxmSurface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+		lod = (mdxmLOD_t *)( (byte *)lod + lod->ofsEnd );
+	}
+
+	mod->mdxmSkinBlocks = (mdxmSkinBlock_t **)Hunk_Alloc( mdxm->numLODs * mdxm->numSurfaces * sizeof( mdxmSkinBlock_t * ) + numBlocks * sizeof( mdxmSkinBlock_t ), h_low );
+	blocks = (mdxmSkinBlock_t *)( mod->mdxmSkinBlocks + mdxm->numLODs * mdxm->numSurfaces );
+
+	lod = (mdxmLOD_t *) ( (byte *)mdxm + mdxm->ofsLODs );
+	for ( l = 0 ; l < mdxm->numLODs ; l++ )
+	{
+		surf = (mdxmSurface_t *) ( (byte *)lod + sizeof (mdxmLOD_t) + (mdxm->numSurfaces * sizeof(mdxmLODSurfOffset_t)) );
+		for ( i = 0 ; i < mdxm->numSurfaces ; i++ )
+		{
+			const mdxmVertex_t	*v = (mdxmVertex_t *) ( (byte *)surf + surf->ofsVerts );
+			qboolean			valid = (qboolean)( surf->thisSurfaceIndex >= 0 && surf->thisSurfaceIndex < mdxm->numSurfaces
+										&& surf->numBoneReferences <= iMAX_G2_BONEREFS_PER_SURFACE );
+
+			for ( j = 0 ; j < surf->numVerts && valid ; j++, v++ )
+			{
+				mdxmSkinBlock_t	*block = &blocks[j >> 2];
+				const int		lane = j & 3;
+				const int		iNumWeights = G2_GetVertWeights( v );
+				float			fTotalWeight = 0.0f;
+
+				for ( k = 0 ; k < 3 ; k++ )
+				{
+					block->xyz[k][lane] = v->vertCoords[k];
+				}
+
+				for ( k = 0 ; k < iNumWeights ; k++ )
+				{
+					block->boneRefs[k][lane] = G2_GetVertBoneIndex( v, k );
+					block->weights[k][lane] = G2_GetVertBoneWeight( v, k, fTotalWeight, iNumWeights );
+
+					if ( block->boneRefs[k][lane] >= surf->numBoneReferences )
+					{
+						valid = qfalse;
+						break;
+					}
+				}
+				for ( ; k < 4 ; k++ )
+				{
+					block->boneRefs[k][lane] = block->boneRefs[0][lane];
+				}
+
+				block->numWeights = Q_max( block->numWeights, iNumWeights );
+			}
+
+			if ( valid )
+			{
+				mod->mdxmSkinBlocks[l * mdxm->numSurfaces + surf->thisSurfaceIndex] = blocks;
+			}
+			blocks += ( surf->numVerts + 3 ) >> 2;
+
+			surf = (mdxmSurface_t *)( (byte *)surf + surf->ofsEnd );
+		}
+		lod = (mdxmLOD_t *)( (byte *)lod + lod->ofsEnd );
+	}
+}
+#endif
+
 //#define CREATE_LIMB_HIERARCHY
 
 #ifdef CREATE_LIMB_HIERARCHY
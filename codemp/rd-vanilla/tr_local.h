@@ -64,6 +64,31 @@ Ghoul2 Insert End
 */
 } modtype_t;
 
+// Ghoul2 verts are skinned four at a time for collision where SSE or AArch64 NEON is available
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define G2_SIMD_SSE
+#elif ( defined(__aarch64__) && defined(__ARM_NEON) ) || defined(_M_ARM64)
+	#define G2_SIMD_NEON
+#endif
+
+#if defined(G2_SIMD_SSE) || defined(G2_SIMD_NEON)
+	#define G2_SIMD
+
+// four verts of a GLM surface with their weights unpacked, see R_LoadMDXMSkinBlocks
+typedef struct mdxmSkinBlock_s {
+	float		xyz[3][4];			// one component of the four verts per row
+	float		weights[4][4];		// [weight][vert], 0 past the vert's own weights
+	int			boneRefs[4][4];		// [weight][vert], index into the surface's bone references
+	int			numWeights;			// most weights any of the four verts has
+} mdxmSkinBlock_t;
+#endif
+
+// base pose bounds of the verts weighted to one of a GLM surface's bone references
+typedef struct mdxmBoneBounds_s {
+	vec3_t		center;
+	vec3_t		extents;			// negative if no vert uses the bone reference
+} mdxmBoneBounds_t;
+
 typedef struct model_s {
 	char		name[MAX_QPATH];
 	modtype_t	type;
@@ -77,6 +102,10 @@ Ghoul2 Insert Start
 */
 	mdxmHeader_t *mdxm;				// only if type == MOD_GL2M which is a GHOUL II Mesh file NOT a GHOUL II animation file
 	mdxaHeader_t *mdxa;				// only if type == MOD_GL2A which is a GHOUL II Animation file
+	mdxmBoneBounds_t **mdxmBoneBounds;	// only if type == MOD_MDXM, per LOD and surface, NULL where collision has to transform the whole surface
+#ifdef G2_SIMD
+	mdxmSkinBlock_t **mdxmSkinBlocks;	// only if type == MOD_MDXM, per LOD and surface, ( numVerts + 3 ) / 4 each
+#endif
 /*
 Ghoul2 Insert End
 */
@@ -1891,6 +1920,13 @@ Ghoul2 Insert Start
 // tr_ghoul2.cpp
 void		Multiply_3x4Matrix(mdxaBone_t *out, mdxaBone_t *in2, mdxaBone_t *in);
 extern qboolean R_LoadMDXM (model_t *mod, void *buffer, const char *name, qboolean &bAlreadyCached );
+void		R_LoadMDXMBoneBounds( model_t *mod );
+#ifdef G2_SIMD
+void		R_LoadMDXMSkinBlocks( model_t *mod );
+#endif
+void		R_G2SkinBench_f( void );
+void		R_G2CopyBench_f( void );
+void		G2_FlushFrameCaches( void );
 extern qboolean R_LoadMDXA (model_t *mod, void *buffer, const char *name, qboolean &bAlreadyCached );
 void		RE_InsertModelIntoHash(const char *name, model_t *mod);
 /*
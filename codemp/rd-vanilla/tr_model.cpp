@@ -391,6 +391,7 @@ qboolean RE_RegisterModels_LevelLoadEnd(qboolean bDeleteEverythingNotUsedThisLev
 
 				if (CachedModel.pModelDiskImage) {
 					Z_Free(CachedModel.pModelDiskImage);
+					G2_FlushFrameCaches();
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
 					bAtLeastoneModelFreed = qtrue;
 				}
@@ -445,6 +446,7 @@ static void RE_RegisterModels_DumpNonPure(void)
 
 				if (CachedModel.pModelDiskImage) {
 					Z_Free(CachedModel.pModelDiskImage);
+					G2_FlushFrameCaches();
 					//CachedModel.pModelDiskImage = NULL;	// REM for reference, erase() call below negates the need for it.
 				}
 				CachedModels->erase(itModel++);
@@ -502,6 +504,7 @@ static void RE_RegisterModels_DeleteAll(void)
 
 		if (CachedModel.pModelDiskImage) {
 			Z_Free(CachedModel.pModelDiskImage);
+			G2_FlushFrameCaches();
 		}
 
 		CachedModels->erase(itModel++);
@@ -1119,6 +1122,12 @@ Ghoul2 Insert End
 				break;
 			case MDXM_IDENT:
 				loaded = ServerLoadMDXM( mod, buf, filename, bAlreadyCached );
+				if ( loaded ) {
+					R_LoadMDXMBoneBounds( mod );
+#ifdef G2_SIMD
+					R_LoadMDXMSkinBlocks( mod );
+#endif
+				}
 				break;
 			default:
 				goto fail;
@@ -1337,6 +1346,12 @@ Ghoul2 Insert End
 
 			case MDXM_IDENT:
 				loaded = R_LoadMDXM( mod, buf, filename, bAlreadyCached );
+				if ( loaded ) {
+					R_LoadMDXMBoneBounds( mod );
+#ifdef G2_SIMD
+					R_LoadMDXMSkinBlocks( mod );
+#endif
+				}
 				break;
 
 			case MD3_IDENT:
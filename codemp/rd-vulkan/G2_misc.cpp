@@ -545,10 +545,11 @@ void G2_TransformSurfaces(int surfaceNum, surfaceInfo_v &rootSList,
 }
 
 // main calling point for the model transform for collision detection. At this point all of the skeleton has been transformed.
+// traceBounds is ignored here, every surface is transformed
 #ifdef _G2_GORE
-void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore)
+void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, bool ApplyGore, const CTraceBounds *traceBounds)
 #else
-void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod)
+void G2_TransformModel(CGhoul2Info_v &ghoul2, const int frameNum, vec3_t scale, IHeapAllocator *G2VertSpace, int useLod, const CTraceBounds *traceBounds)
 #endif
 {
 	int				i, lod;
@@ -25,6 +25,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "qcommon/q_shared.h"
 #include "qcommon/qcommon.h"
+#include "qcommon/cm_public.h"
 #include "game/g_public.h"
 #include "game/bg_public.h"
 #include "rd-common/tr_public.h"
@@ -36,16 +37,24 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #define	MAX_ENT_CLUSTERS	16
 
+typedef struct svClusterLink_s {
+	struct svClusterLink_s	**prev;		// pointer that points at this link
+	struct svClusterLink_s	*next;
+	int						entityNum;
+} svClusterLink_t;
+
 typedef struct svEntity_s {
 	struct worldSector_s *worldSector;
 	struct svEntity_s *nextEntityInWorldSector;
 
+	svClusterLink_t	clusterLinks[MAX_ENT_CLUSTERS];	// into sv.clusterEntities, used to cull snapshots
+	int			numClusterLinks;
+
 	entityState_t	baseline;		// for delta compression of initial sighting
 	int			numClusters;		// if -1, use headnode instead
 	int			clusternums[MAX_ENT_CLUSTERS];
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
-	int			snapshotCounter;	// used to prevent double adding from portal views
 } svEntity_t;
 
 typedef enum {
@@ -60,12 +69,16 @@ typedef struct server_s {
 	int				serverId;			// changes each server start
 	int				restartedServerId;	// serverId before a map_restart
 	int				checksumFeed;		//
-	int				snapshotCounter;	// incremented for each snapshot built
 	int				timeResidual;		// <= 1000 / sv_frame->value
 	int				nextFrameTime;		// when time > nextFrameTime, process world
 	char			*configstrings[MAX_CONFIGSTRINGS];
 	svEntity_t		svEntities[MAX_GENTITIES];
 
+	// entities linked into each PVS cluster, so snapshots only visit what the client can see
+	svClusterLink_t	**clusterEntities;
+	int				numClusters;
+	int				overflowEntities[MAX_GENTITIES/32];	// touch more clusters than clusterLinks can hold
+
 	char			*entityParsePoint;	// used during game VM init
 
 	// the game virtual machine will update these on init and changes
@@ -120,6 +133,8 @@ typedef enum {
 } clientState_t;
 
 
+typedef struct demoBuffer_s demoBuffer_t;
+
 // struct to hold demo data for a single demo
 typedef struct {
 	char		demoName[MAX_OSPATH];
@@ -127,6 +142,7 @@ typedef struct {
 	qboolean	demowaiting;	// don't record until a non-delta message is sent
 	int			minDeltaFrame;	// the first non-delta frame stored in the demo.  cannot delta against frames older than this
 	fileHandle_t	demofile;
+	demoBuffer_t	*buffer;	// NULL when writing straight to demofile, see sv_demo.cpp
 	qboolean	isBot;
 	int			botReliableAcknowledge; // for bots, need to maintain a separate reliableAcknowledge to record server messages into the demo file
 } demoInfo_t;
@@ -216,7 +232,7 @@ typedef struct serverStatic_s {
 	qboolean	gameStarted;				// gvm is loaded
 } serverStatic_t;
 
-#define SERVER_MAXBANS	1024
+#define SERVER_MAXBANS	16384
 // Structure for managing bans
 typedef struct serverBan_s {
 	netadr_t ip;
@@ -276,6 +292,10 @@ extern	cvar_t	*sv_banFile;
 extern	cvar_t	*sv_maxOOBRate;
 extern	cvar_t	*sv_maxOOBRateIP;
 extern	cvar_t	*sv_autoWhitelist;
+extern	cvar_t	*sv_parallelSnapshots;
+extern	cvar_t	*sv_parallelTraces;
+extern	cvar_t	*sv_parallelSkeletons;
+extern	cvar_t	*sv_demoWriteBuffer;
 
 extern	serverBan_t serverBans[SERVER_MAXBANS];
 extern	int serverBansCount;
@@ -339,6 +359,7 @@ qboolean SV_VerifyChallenge(int receivedChallenge, const netadr_t *from);
 //
 void SV_GetChallenge( const netadr_t *from );
 
+void SV_BuildBanTrie( void );
 void SV_DirectConnect( const netadr_t *from );
 
 void SV_SendClientMapChange( client_t *client );
@@ -363,6 +384,15 @@ void SV_AutoRecordDemo( client_t *cl );
 void SV_StopAutoRecordDemos();
 void SV_BeginAutoRecordDemos();
 
+//
+// sv_demo.cpp
+//
+void SV_DemoOpen( client_t *cl );
+void SV_DemoWrite( client_t *cl, const void *data, int len );
+void SV_DemoClose( client_t *cl );
+void SV_DemoWriterFlush( void );
+void SV_DemoWriterShutdown( void );
+
 //
 // sv_snapshot.c
 //
@@ -423,9 +453,13 @@ void SV_LinkEntity( sharedEntity_t *ent );
 
 
 clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
+clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent, cmTraceContext_t *context );
+// the box models of entities live in the trace context, so the handle
+// is only good for traces made with the same context
 
 
 void SV_SectorList_f( void );
+void SV_AreaBench_f( void );
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -453,6 +487,11 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 // passEntityNum is explicitly excluded from clipping checks (normally ENTITYNUM_NONE)
 
 
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int count );
+// same as calling SV_Trace for each request, results[i] gets the result of requests[i]
+// runs on the job threads when sv_parallelTraces is set, except for Ghoul2 traces
+
+
 void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int entityNum, int contentmask, int capsule );
 // clip to a specific entity
 
@@ -592,6 +592,7 @@ static void SV_RehashBans_f( void )
 	}
 
 	serverBansCount = 0;
+	SV_BuildBanTrie();
 
 	if ( !sv_banFile->string || !*sv_banFile->string )
 		return;
@@ -649,6 +650,7 @@ static void SV_RehashBans_f( void )
 		}
 
 		serverBansCount = index;
+		SV_BuildBanTrie();
 
 		Z_Free( textbuf );
 	}
@@ -888,6 +890,7 @@ static void SV_AddBanToList( qboolean isexception )
 	serverBans[serverBansCount].isexception = isexception;
 
 	serverBansCount++;
+	SV_BuildBanTrie();
 
 	SV_WriteBans();
 
@@ -983,6 +986,7 @@ static void SV_DelBanFromList( qboolean isexception )
 		}
 	}
 
+	SV_BuildBanTrie();
 	SV_WriteBans();
 }
 
@@ -1049,6 +1053,7 @@ static void SV_FlushBans_f( void )
 	}
 
 	serverBansCount = 0;
+	SV_BuildBanTrie();
 
 	// empty the ban file.
 	SV_WriteBans();
@@ -1530,13 +1535,13 @@ void SV_WriteDemoMessage ( client_t *cl, msg_t *msg, int headerBytes ) {
 	// write the packet sequence
 	len = cl->netchan.outgoingSequence;
 	swlen = LittleLong( len );
-	FS_Write( &swlen, 4, cl->demo.demofile );
+	SV_DemoWrite( cl, &swlen, 4 );
 
 	// skip the packet sequencing information
 	len = msg->cursize - headerBytes;
 	swlen = LittleLong( len );
-	FS_Write( &swlen, 4, cl->demo.demofile );
-	FS_Write( msg->data + headerBytes, len, cl->demo.demofile );
+	SV_DemoWrite( cl, &swlen, 4 );
+	SV_DemoWrite( cl, msg->data + headerBytes, len );
 }
 
 void SV_StopRecordDemo( client_t *cl ) {
@@ -1549,10 +1554,9 @@ void SV_StopRecordDemo( client_t *cl ) {
 
 	// finish up
 	len = -1;
-	FS_Write (&len, 4, cl->demo.demofile);
-	FS_Write (&len, 4, cl->demo.demofile);
-	FS_FCloseFile (cl->demo.demofile);
-	cl->demo.demofile = 0;
+	SV_DemoWrite( cl, &len, 4 );
+	SV_DemoWrite( cl, &len, 4 );
+	SV_DemoClose( cl );
 	cl->demo.demorecording = qfalse;
 	Com_Printf ("Stopped demo for client %d.\n", cl - svs.clients);
 }
@@ -1644,6 +1648,7 @@ void SV_RecordDemo( client_t *cl, char *demoName ) {
 		Com_Printf ("ERROR: couldn't open.\n");
 		return;
 	}
+	SV_DemoOpen( cl );
 	cl->demo.demorecording = qtrue;
 
 	// don't start saving messages until a non-delta compressed message is received
@@ -1665,11 +1670,11 @@ void SV_RecordDemo( client_t *cl, char *demoName ) {
 
 	// write it to the demo file
 	len = LittleLong( cl->netchan.outgoingSequence - 1 );
-	FS_Write( &len, 4, cl->demo.demofile );
+	SV_DemoWrite( cl, &len, 4 );
 
 	len = LittleLong( msg.cursize );
-	FS_Write( &len, 4, cl->demo.demofile );
-	FS_Write( msg.data, msg.cursize, cl->demo.demofile );
+	SV_DemoWrite( cl, &len, 4 );
+	SV_DemoWrite( cl, msg.data, msg.cursize );
 
 	// the rest of the demo file will be copied from net messages
 }
@@ -1966,6 +1971,8 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f, "Prints the userinfo for a given userid" );
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f, "Restart the current map" );
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand ("areabench", SV_AreaBench_f, "Times entity area queries around every linked entity" );
+	Cmd_AddCommand ("tracebench", CM_TraceBench_f, "Times random world traces with brush sides tested one and four at a time" );
 	Cmd_AddCommand ("map", SV_Map_f, "Load a new map with cheats disabled" );
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 	Cmd_AddCommand ("devmap", SV_Map_f, "Load a new map with cheats enabled" );
@@ -2010,6 +2017,8 @@ void SV_RemoveOperatorCommands( void ) {
 	Cmd_RemoveCommand ("dumpuser");
 	Cmd_RemoveCommand ("map_restart");
 	Cmd_RemoveCommand ("sectorlist");
+	Cmd_RemoveCommand ("areabench");
+	Cmd_RemoveCommand ("tracebench");
 	Cmd_RemoveCommand ("svsay");
 #endif
 }
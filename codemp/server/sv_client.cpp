@@ -35,6 +35,8 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "server/sv_gameapi.h"
 
+#include <vector>
+
 static void SV_CloseDownload( client_t *cl );
 
 /*
@@ -83,6 +85,81 @@ void SV_GetChallenge( const netadr_t *from ) {
 	NET_OutOfBandPrint( NS_SERVER, from, "challengeResponse %i %i", challenge, clientChallenge );
 }
 
+/*
+==================
+Ban trie
+
+The IPv4 bans and exceptions as a binary trie over the address bits, a
+prefix of subnet bits ending in a node flagged with what it is. Looking an
+address up walks at most 32 nodes however many bans there are.
+==================
+*/
+
+#define BANNODE_BAN			1
+#define BANNODE_EXCEPTION	2
+
+typedef struct banNode_s {
+	int		child[2];		// 0 for none, the root is never anyone's child
+	int		flags;			// BANNODE_*
+} banNode_t;
+
+static std::vector<banNode_t>	banTrie;
+static qboolean					banTrieOther;		// some entry isn't an IPv4 address, see SV_IsBanned
+
+static int SV_AdrBit( const netadr_t *adr, int bit ) {
+	return ( adr->ip[bit >> 3] >> ( 7 - ( bit & 7 ) ) ) & 1;
+}
+
+/*
+==================
+SV_BuildBanTrie
+
+Must be called whenever serverBans changes
+==================
+*/
+void SV_BuildBanTrie( void )
+{
+	int index, bit, node, next;
+	unsigned int subnet;
+	const serverBan_t *curban;
+	banNode_t empty = { { 0, 0 }, 0 };
+
+	banTrie.clear();
+	banTrie.push_back( empty );
+	banTrieOther = qfalse;
+
+	for ( index = 0; index < serverBansCount; index++ )
+	{
+		curban = &serverBans[index];
+
+		if ( curban->ip.type != NA_IP )
+		{
+			banTrieOther = qtrue;
+			continue;
+		}
+
+		// same clamping as NET_CompareBaseAdrMask
+		subnet = (unsigned int)curban->subnet;
+		if ( subnet > 32 )
+			subnet = 32;
+
+		node = 0;
+		for ( bit = 0; bit < (int)subnet; bit++ )
+		{
+			next = banTrie[node].child[SV_AdrBit( &curban->ip, bit )];
+			if ( !next )
+			{
+				next = (int)banTrie.size();
+				banTrie.push_back( empty );
+				banTrie[node].child[SV_AdrBit( &curban->ip, bit )] = next;
+			}
+			node = next;
+		}
+
+		banTrie[node].flags |= curban->isexception ? BANNODE_EXCEPTION : BANNODE_BAN;
+	}
+}
+
 /*
 ==================
 SV_IsBanned
@@ -93,13 +170,38 @@ Check whether a certain address is banned
 
 static qboolean SV_IsBanned( const netadr_t *from, qboolean isexception )
 {
-	int index;
+	int index, bit, node, flags;
 	serverBan_t *curban;
 
 	if ( !serverBansCount ) {
 		return qfalse;
 	}
 
+	if ( from->type == NA_IP && !banTrie.empty() )
+	{
+		// every prefix of the address that is in the trie matches
+		node = 0;
+		flags = banTrie[0].flags;
+		for ( bit = 0; bit < 32; bit++ )
+		{
+			node = banTrie[node].child[SV_AdrBit( from, bit )];
+			if ( !node )
+				break;
+			flags |= banTrie[node].flags;
+		}
+
+		if ( isexception )
+			return (qboolean)( (flags & BANNODE_EXCEPTION) != 0 );
+
+		// an exception overrides any ban
+		return (qboolean)( (flags & (BANNODE_EXCEPTION|BANNODE_BAN)) == BANNODE_BAN );
+	}
+
+	// loopback and the like, only ever matched by entries that aren't in the trie
+	if ( !banTrieOther ) {
+		return qfalse;
+	}
+
 	if ( !isexception )
 	{
 		// If this is a query for a ban, first check whether the client is excepted
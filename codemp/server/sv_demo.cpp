@@ -0,0 +1,272 @@
+/*
+===========================================================================
+Copyright (C) 2013 - 2016, OpenJK contributors
+
+This file is part of the OpenJK source code.
+
+OpenJK is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 2 as
+published by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, see <http://www.gnu.org/licenses/>.
+===========================================================================
+*/
+
+// sv_demo.cpp -- background writer for server-side demos
+//
+// Everything written to a client's demo goes into a ring buffer, and a single
+// writer thread moves it from the rings to disk, so recording every slot does
+// not put file I/O on the server frame. The server only waits on the writer
+// when a ring is full, and when a demo is closed. With sv_demoWriteBuffer 0
+// demos are written straight to the file like before.
+//
+// The writer never calls into the filesystem: it writes to the FILE the demo
+// was opened with, taken on the main thread, so an FS_Restart can't pull the
+// file out from under it.
+
+#include "server.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+struct demoBuffer_s {
+	fileHandle_t	handle;
+	FILE			*file;		// the handle's FILE, only the writer uses it
+	byte			*data;
+	unsigned int	size;		// power of 2
+	unsigned int	head;		// bytes the server has written, wraps around
+	unsigned int	tail;		// bytes the writer has passed on to the file
+	bool			failed;		// a write came up short, the rest is dropped
+};
+
+static std::thread				demoThread;
+static std::mutex				demoMutex;
+static std::condition_variable	demoWork;		// a ring has data, or the writer should quit
+static std::condition_variable	demoSpace;		// the writer has emptied part of a ring
+static bool						demoQuit;
+static demoBuffer_t				*demoBuffers[MAX_CLIENTS];
+
+/*
+==================
+SV_DemoWriterLoop
+==================
+*/
+static void SV_DemoWriterLoop( void ) {
+	std::unique_lock<std::mutex> lock( demoMutex );
+
+	for ( ;; ) {
+		demoBuffer_t	*buffer = NULL;
+
+		for ( int i = 0 ; i < MAX_CLIENTS ; i++ ) {
+			if ( demoBuffers[i] && demoBuffers[i]->head != demoBuffers[i]->tail ) {
+				buffer = demoBuffers[i];
+				break;
+			}
+		}
+
+		if ( !buffer ) {
+			if ( demoQuit ) {
+				return;
+			}
+			demoWork.wait( lock );
+			continue;
+		}
+
+		// the part up to the head or the end of the ring, whichever comes first.
+		// the server only ever writes past the head, so it can be read unlocked
+		unsigned int start = buffer->tail & ( buffer->size - 1 );
+		unsigned int len = Q_min( buffer->head - buffer->tail, buffer->size - start );
+
+		lock.unlock();
+		if ( !buffer->failed && fwrite( buffer->data + start, 1, len, buffer->file ) != len ) {
+			buffer->failed = true;
+		}
+		lock.lock();
+
+		buffer->tail += len;
+		demoSpace.notify_all();
+	}
+}
+
+/*
+==================
+SV_DemoOpen
+
+Sets up the buffer for a demo that has just been opened
+==================
+*/
+void SV_DemoOpen( client_t *cl ) {
+	demoBuffer_t	*buffer;
+	unsigned int	size;
+
+	cl->demo.buffer = NULL;
+
+	if ( sv_demoWriteBuffer->integer <= 0 ) {
+		return;
+	}
+
+	if ( !demoThread.joinable() ) {
+		demoQuit = false;
+		try {
+			demoThread = std::thread( SV_DemoWriterLoop );
+		}
+		catch ( const std::system_error & ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: SV_DemoOpen: couldn't start the demo writer, writing directly\n" );
+			return;
+		}
+	}
+
+	size = 4096;
+	while ( size < (unsigned int)Q_min( sv_demoWriteBuffer->integer, 65536 ) * 1024 ) {
+		size <<= 1;
+	}
+
+	buffer = (demoBuffer_t *)Z_Malloc( sizeof( *buffer ), TAG_CLIENTS, qtrue );
+	buffer->handle = cl->demo.demofile;
+	buffer->file = FS_FileForHandle( cl->demo.demofile );
+	buffer->data = (byte *)Z_Malloc( size, TAG_CLIENTS, qfalse );
+	buffer->size = size;
+
+	{
+		std::lock_guard<std::mutex> lock( demoMutex );
+		demoBuffers[cl - svs.clients] = buffer;
+	}
+	cl->demo.buffer = buffer;
+}
+
+/*
+==================
+SV_DemoWrite
+==================
+*/
+void SV_DemoWrite( client_t *cl, const void *data, int len ) {
+	demoBuffer_t	*buffer = cl->demo.buffer;
+	const byte		*in = (const byte *)data;
+
+	if ( !buffer ) {
+		FS_Write( data, len, cl->demo.demofile );
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( demoMutex );
+
+	while ( len > 0 ) {
+		unsigned int space = buffer->size - ( buffer->head - buffer->tail );
+
+		if ( !space ) {
+			// the disk can't keep up, this is the only place the server waits for it
+			demoWork.notify_one();
+			demoSpace.wait( lock );
+			continue;
+		}
+
+		unsigned int start = buffer->head & ( buffer->size - 1 );
+		unsigned int n = Q_min( Q_min( (unsigned int)len, space ), buffer->size - start );
+
+		Com_Memcpy( buffer->data + start, in, n );
+		buffer->head += n;
+		in += n;
+		len -= n;
+	}
+
+	demoWork.notify_one();
+}
+
+/*
+==================
+SV_DemoClose
+
+Waits for the writer to finish the demo and closes the file
+==================
+*/
+void SV_DemoClose( client_t *cl ) {
+	demoBuffer_t	*buffer = cl->demo.buffer;
+
+	if ( buffer ) {
+		{
+			std::unique_lock<std::mutex> lock( demoMutex );
+			demoSpace.wait( lock, [buffer] { return buffer->head == buffer->tail; } );
+			demoBuffers[cl - svs.clients] = NULL;
+		}
+
+		if ( buffer->failed ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: SV_DemoClose: couldn't write all of %s's demo\n", cl->name );
+		}
+		Z_Free( buffer->data );
+		Z_Free( buffer );
+		cl->demo.buffer = NULL;
+	}
+
+	FS_FCloseFile( cl->demo.demofile );
+	cl->demo.demofile = 0;
+}
+
+/*
+==================
+SV_DemoWriterFlush
+
+Waits until the writer has emptied every ring. The writer then sits idle until
+the server writes more, so this is called before the filesystem restarts.
+==================
+*/
+void SV_DemoWriterFlush( void ) {
+	if ( !demoThread.joinable() ) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock( demoMutex );
+
+	demoWork.notify_one();
+	demoSpace.wait( lock, [] {
+		for ( int i = 0 ; i < MAX_CLIENTS ; i++ ) {
+			if ( demoBuffers[i] && demoBuffers[i]->head != demoBuffers[i]->tail ) {
+				return false;
+			}
+		}
+		return true;
+	} );
+
+	for ( int i = 0 ; i < MAX_CLIENTS ; i++ ) {
+		if ( demoBuffers[i] ) {
+			fflush( demoBuffers[i]->file );
+		}
+	}
+}
+
+/*
+==================
+SV_DemoWriterShutdown
+
+Flushes whatever is still buffered and stops the writer. Demos still open at
+this point (the server went down on an error) are closed without a trailer.
+==================
+*/
+void SV_DemoWriterShutdown( void ) {
+	if ( !demoThread.joinable() ) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( demoMutex );
+		demoQuit = true;
+	}
+	demoWork.notify_one();
+	demoThread.join();
+
+	for ( int i = 0 ; i < MAX_CLIENTS ; i++ ) {
+		if ( demoBuffers[i] ) {
+			FS_FCloseFile( demoBuffers[i]->handle );
+			Z_Free( demoBuffers[i]->data );
+			Z_Free( demoBuffers[i] );
+			demoBuffers[i] = NULL;
+		}
+	}
+}
@@ -1493,6 +1493,12 @@ static qboolean SV_G2API_GetBoltMatrix_NoRecNoRot( void *ghoul2, const int model
 	return re->G2API_GetBoltMatrix( *((CGhoul2Info_v *)ghoul2), modelIndex, boltIndex, matrix, angles, position, frameNum, modelList, scale );
 }
 
+static void SV_G2API_ConstructGhoulSkeletons( void **ghoul2, vec3_t *scales, int count, int frameNum ) {
+	// without workers to spread them over, the skeletons are just built on demand
+	if ( !sv_parallelSkeletons->integer || !Com_JobThreads() || !re->G2API_ConstructGhoulSkeletons ) return;
+	re->G2API_ConstructGhoulSkeletons( (CGhoul2Info_v **)ghoul2, scales, count, frameNum );
+}
+
 static int SV_G2API_InitGhoul2Model( void **ghoul2Ptr, const char *fileName, int modelIndex, qhandle_t customSkin, qhandle_t customShader, int modelFlags, int lodBias ) {
 #ifdef _FULL_G2_LEAK_CHECKING
 		g_G2AllocServer = 1;
@@ -1916,6 +1922,12 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case G_TRACECAPSULE:
 		SV_Trace( (trace_t *)VMA(1), (const float *)VMA(2), (const float *)VMA(3), (const float *)VMA(4), (const float *)VMA(5), args[6], args[7], /*int capsule*/ qtrue, args[8], args[9]  );
 		return 0;
+	case G_TRACEBATCH:
+		SV_TraceBatch( (trace_t *)VMA(1), (const traceRequest_t *)VMA(2), args[3] );
+		return 0;
+	case G_G2_CONSTRUCTGHOULSKELETONS:
+		SV_G2API_ConstructGhoulSkeletons( (void **)VMA(1), (vec3_t *)VMA(2), args[3], args[4] );
+		return 0;
 	case G_POINT_CONTENTS:
 		return SV_PointContents( (const float *)VMA(1), args[2] );
 	case G_SET_SERVER_CULL:
@@ -3118,6 +3130,8 @@ void SV_BindGame( void ) {
 		gi.G2API_CleanEntAttachments			= SV_G2API_CleanEntAttachments;
 		gi.G2API_OverrideServer					= SV_G2API_OverrideServer;
 		gi.G2API_GetSurfaceName					= SV_G2API_GetSurfaceName;
+		gi.TraceBatch							= SV_TraceBatch;
+		gi.G2API_ConstructGhoulSkeletons		= SV_G2API_ConstructGhoulSkeletons;
 
 		GetGameAPI = (GetGameAPI_t)gvm->GetModuleAPI;
 		ret = GetGameAPI( GAME_API_VERSION, &gi );
@@ -588,6 +588,7 @@ Ghoul2 Insert End
 	// get a new checksum feed and restart the file system
 	srand(Com_Milliseconds());
 	sv.checksumFeed = ( ((int) rand() << 16) ^ rand() ) ^ Com_Milliseconds();
+	SV_DemoWriterFlush();
 	FS_Restart( sv.checksumFeed );
 
 	CM_LoadMap( va("maps/%s.bsp", server), qfalse, &checksum );
@@ -909,6 +910,8 @@ static void SV_InitRef( void ) {
 	ri.GetG2VertSpaceServer = GetG2VertSpaceServer;
 	G2VertSpaceServer = &IHeapAllocator_singleton;
 
+	ri.Com_RunJobs = Com_RunJobs;
+
 	ret = GetRefAPI( REF_API_VERSION, &ri );
 
 //	Com_Printf( "-------------------------------\n");
@@ -1005,6 +1008,7 @@ void SV_Init (void) {
 	sv_autoDemo = Cvar_Get( "sv_autoDemo", "0", CVAR_ARCHIVE_ND | CVAR_SERVERINFO, "Automatically take server-side demos" );
 	sv_autoDemoBots = Cvar_Get( "sv_autoDemoBots", "0", CVAR_ARCHIVE_ND, "Record server-side demos for bots" );
 	sv_autoDemoMaxMaps = Cvar_Get( "sv_autoDemoMaxMaps", "0", CVAR_ARCHIVE_ND );
+	sv_demoWriteBuffer = Cvar_Get( "sv_demoWriteBuffer", "512", CVAR_ARCHIVE_ND, "Kilobytes buffered per server-side demo for the background writer, 0 to write on the server thread" );
 
 	sv_legacyFixes = Cvar_Get( "sv_legacyFixes", "1", CVAR_ARCHIVE );
 
@@ -1013,6 +1017,9 @@ void SV_Init (void) {
 	sv_maxOOBRate = Cvar_Get("sv_maxOOBRate", "1000", CVAR_ARCHIVE, "Maximum rate of handling incoming server commands" );
 	sv_maxOOBRateIP = Cvar_Get("sv_maxOOBRateIP", "1", CVAR_ARCHIVE, "Maximum rate of handling incoming server commands per IP address" );
 	sv_autoWhitelist = Cvar_Get("sv_autoWhitelist", "1", CVAR_ARCHIVE, "Save player IPs to allow them using server during DOS attack" );
+	sv_parallelSnapshots = Cvar_Get( "sv_parallelSnapshots", "1", CVAR_ARCHIVE_ND, "Build and encode client snapshots on the com_jobThreads workers" );
+	sv_parallelTraces = Cvar_Get( "sv_parallelTraces", "1", CVAR_ARCHIVE_ND, "Split up batched game traces between the com_jobThreads workers" );
+	sv_parallelSkeletons = Cvar_Get( "sv_parallelSkeletons", "1", CVAR_ARCHIVE_ND, "Build the game's Ghoul2 skeletons for the frame on the com_jobThreads workers" );
 
 	// initialize bot cvars so they are listed and can be set before loading the botlib
 	SV_BotInitCvars();
@@ -1092,6 +1099,8 @@ void SV_Shutdown( char *finalmsg )
 	SV_ChallengeShutdown();
 	SV_ShutdownGameProgs();
 	svs.gameStarted = qfalse;
+
+	SV_DemoWriterShutdown();
 /*
 Ghoul2 Insert Start
 */
@@ -72,6 +72,10 @@ cvar_t	*sv_banFile;
 cvar_t	*sv_maxOOBRate;
 cvar_t	*sv_maxOOBRateIP;
 cvar_t	*sv_autoWhitelist;
+cvar_t	*sv_parallelSnapshots;
+cvar_t	*sv_parallelTraces;
+cvar_t	*sv_parallelSkeletons;
+cvar_t	*sv_demoWriteBuffer;
 
 serverBan_t serverBans[SERVER_MAXBANS];
 int serverBansCount = 0;
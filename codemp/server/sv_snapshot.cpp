@@ -23,6 +23,9 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "server.h"
 #include "qcommon/cm_public.h"
+#include "qcommon/jobs.h"
+
+#include <atomic>
 
 /*
 =============================================================================
@@ -46,6 +49,165 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+Delta cache
+
+While SV_SendClientMessages runs the game can't change any entity, so every
+client that deltas an entity from the same state writes the same bits. The
+first one to encode a transition keeps the bits here and the others copy
+them. Entries only live for one call of SV_SendClientMessages.
+
+=============================================================================
+*/
+
+#define DELTA_CACHE_WAYS		4			// cached source states per entity
+#define DELTA_CACHE_BYTES		0x40000		// encoded bits for all entries
+#define DELTA_CACHE_MAXBYTES	2048		// a bigger single delta isn't cached
+
+typedef enum {
+	DELTA_EMPTY,
+	DELTA_CLAIMED,		// being filled in, or the data didn't fit
+	DELTA_READY
+} deltaCacheState_t;
+
+typedef struct deltaCacheEntry_s {
+	std::atomic<int>	state;
+	int					fromIndex;		// into svs.snapshotEntities, or -1 for the baseline
+	int					toIndex;
+	int					ofs;			// into sv_deltaCacheData
+	int					numBits;
+} deltaCacheEntry_t;
+
+static deltaCacheEntry_t	sv_deltaCache[MAX_GENTITIES][DELTA_CACHE_WAYS];
+static byte					sv_deltaCacheData[DELTA_CACHE_BYTES];
+static std::atomic<int>		sv_deltaCacheUsed;
+static qboolean				sv_deltaCacheActive = qfalse;
+
+/*
+=============
+SV_ClearDeltaCache
+=============
+*/
+static void SV_ClearDeltaCache( void ) {
+	int		i, j;
+
+	for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+		for ( j = 0 ; j < DELTA_CACHE_WAYS ; j++ ) {
+			sv_deltaCache[i][j].state.store( DELTA_EMPTY, std::memory_order_relaxed );
+		}
+	}
+	sv_deltaCacheUsed = 0;
+}
+
+/*
+=============
+SV_DeltaCacheState
+
+Returns the state at an absolute svs.snapshotEntities index, or NULL if a
+newer snapshot may have been written over it since
+=============
+*/
+static entityState_t *SV_DeltaCacheState( int index ) {
+	if ( index <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
+		return NULL;
+	}
+	return &svs.snapshotEntities[index % svs.numSnapshotEntities];
+}
+
+/*
+=============
+SV_DeltaCacheMatch
+=============
+*/
+static qboolean SV_DeltaCacheMatch( const deltaCacheEntry_t *entry, entityState_t *from, int fromIndex, entityState_t *to ) {
+	entityState_t	*cached;
+
+	if ( (fromIndex < 0) != (entry->fromIndex < 0) ) {
+		return qfalse;
+	}
+
+	if ( entry->fromIndex >= 0 ) {
+		cached = SV_DeltaCacheState( entry->fromIndex );
+		if ( !cached || memcmp( cached, from, sizeof( *from ) ) ) {
+			return qfalse;
+		}
+	}
+
+	cached = SV_DeltaCacheState( entry->toIndex );
+	if ( !cached || memcmp( cached, to, sizeof( *to ) ) ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+=============
+SV_WriteCachedDeltaEntity
+
+MSG_WriteDeltaEntity from one of the snapshot states, or the baseline when
+fromIndex is -1, to a snapshot state
+=============
+*/
+static void SV_WriteCachedDeltaEntity( msg_t *msg, entityState_t *from, int fromIndex, entityState_t *to, int toIndex ) {
+	deltaCacheEntry_t	*ways, *entry;
+	msg_t				encoded;
+	byte				encodedData[DELTA_CACHE_MAXBYTES];
+	qboolean			force = ( fromIndex < 0 ) ? qtrue : qfalse;
+	int					i, expected, bytes, ofs;
+
+	if ( !sv_deltaCacheActive ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	ways = sv_deltaCache[to->number];
+	for ( i = 0 ; i < DELTA_CACHE_WAYS ; i++ ) {
+		entry = &ways[i];
+		if ( entry->state.load( std::memory_order_acquire ) != DELTA_READY ) {
+			continue;
+		}
+		if ( SV_DeltaCacheMatch( entry, from, fromIndex, to ) ) {
+			MSG_WriteEncodedBits( msg, sv_deltaCacheData + entry->ofs, entry->numBits );
+			return;
+		}
+	}
+
+	MSG_Init( &encoded, encodedData, sizeof( encodedData ) );
+	encoded.allowoverflow = qtrue;
+	MSG_WriteDeltaEntity( &encoded, from, to, force );
+	if ( encoded.overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+	MSG_WriteEncodedBits( msg, encodedData, encoded.bit );
+
+	// keep it if there's a free way and room for the bits
+	for ( i = 0 ; i < DELTA_CACHE_WAYS ; i++ ) {
+		entry = &ways[i];
+		expected = DELTA_EMPTY;
+		if ( !entry->state.compare_exchange_strong( expected, DELTA_CLAIMED ) ) {
+			continue;
+		}
+
+		bytes = (encoded.bit + 7) >> 3;
+		ofs = sv_deltaCacheUsed.fetch_add( bytes );
+		if ( ofs + bytes > DELTA_CACHE_BYTES ) {
+			return;		// full, the way stays claimed until the next clear
+		}
+
+		Com_Memcpy( sv_deltaCacheData + ofs, encodedData, bytes );
+		entry->fromIndex = fromIndex;
+		entry->toIndex = toIndex;
+		entry->ofs = ofs;
+		entry->numBits = encoded.bit;
+		entry->state.store( DELTA_READY, std::memory_order_release );
+		return;
+	}
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -58,6 +220,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 	int		oldindex, newindex;
 	int		oldnum, newnum;
 	int		from_num_entities;
+	int		oldent_index, newent_index;
 
 	// generate the delta update
 	if ( !from ) {
@@ -68,20 +231,24 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 	newent = NULL;
 	oldent = NULL;
+	newent_index = 0;
+	oldent_index = 0;
 	newindex = 0;
 	oldindex = 0;
 	while ( newindex < to->num_entities || oldindex < from_num_entities ) {
 		if ( newindex >= to->num_entities ) {
 			newnum = 9999;
 		} else {
-			newent = &svs.snapshotEntities[(to->first_entity+newindex) % svs.numSnapshotEntities];
+			newent_index = to->first_entity+newindex;
+			newent = &svs.snapshotEntities[newent_index % svs.numSnapshotEntities];
 			newnum = newent->number;
 		}
 
 		if ( oldindex >= from_num_entities ) {
 			oldnum = 9999;
 		} else {
-			oldent = &svs.snapshotEntities[(from->first_entity+oldindex) % svs.numSnapshotEntities];
+			oldent_index = from->first_entity+oldindex;
+			oldent = &svs.snapshotEntities[oldent_index % svs.numSnapshotEntities];
 			oldnum = oldent->number;
 		}
 
@@ -89,7 +256,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteCachedDeltaEntity( msg, oldent, oldent_index, newent, newent_index );
 			oldindex++;
 			newindex++;
 			continue;
@@ -97,7 +264,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteCachedDeltaEntity( msg, &sv.svEntities[newnum].baseline, -1, newent, newent_index );
 			newindex++;
 			continue;
 		}
@@ -309,6 +476,7 @@ Build a client snapshot structure
 typedef struct snapshotEntityNumbers_s {
 	int		numSnapshotEntities;
 	int		snapshotEntities[MAX_SNAPSHOT_ENTITIES];
+	int		added[MAX_GENTITIES/32];	// used to prevent double adding from portal views
 } snapshotEntityNumbers_t;
 
 /*
@@ -339,12 +507,14 @@ static int QDECL SV_QsortEntityNumbers( const void *a, const void *b ) {
 SV_AddEntToSnapshot
 ===============
 */
-static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+static void SV_AddEntToSnapshot( sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+	int		e = gEnt->s.number;
+
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( eNums->added[e >> 5] & (1 << (e & 31)) ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[e >> 5] |= 1 << (e & 31);
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
@@ -355,6 +525,80 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapsh
 	eNums->numSnapshotEntities++;
 }
 
+/*
+===============
+SV_BuildBroadcastEntities
+
+Marks the linked entities that may be sent without being in the PVS. The game
+can change these flags at any time, but not while snapshots are being built, so
+SV_SendClientMessages only does this once for all clients.
+===============
+*/
+static int		sv_broadcastEntities[MAX_GENTITIES/32];
+static qboolean	sv_broadcastEntitiesValid = qfalse;
+
+static void SV_BuildBroadcastEntities( void ) {
+	int				e;
+	sharedEntity_t	*ent;
+
+	Com_Memset( sv_broadcastEntities, 0, sizeof( sv_broadcastEntities ) );
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		ent = SV_GentityNum(e);
+
+		if ( !ent->r.linked ) {
+			continue;
+		}
+
+		if ( (ent->r.svFlags & SVF_BROADCAST) || ent->s.isPortalEnt
+			|| ent->r.broadcastClients[0] || ent->r.broadcastClients[1] )
+		{
+			sv_broadcastEntities[e >> 5] |= 1 << (e & 31);
+		}
+	}
+}
+
+/*
+===============
+SV_GatherSnapshotCandidates
+
+Sets a bit for every entity that could pass the checks in
+SV_AddEntitiesVisibleFromPoint: the ones linked into a cluster visible
+from clientpvs plus those that are sent or checked regardless.
+===============
+*/
+static void SV_GatherSnapshotCandidates( const byte *clientpvs, int clientNum, int *candidates ) {
+	int				i, c, clusterBytes;
+	int				bits;
+	svClusterLink_t	*link;
+
+	if ( !sv_broadcastEntitiesValid ) {
+		SV_BuildBroadcastEntities();
+	}
+
+	for ( i = 0 ; i < MAX_GENTITIES/32 ; i++ ) {
+		candidates[i] = sv_broadcastEntities[i] | sv.overflowEntities[i];
+	}
+	candidates[clientNum >> 5] |= 1 << (clientNum & 31);
+
+	if ( !sv.clusterEntities ) {
+		return;
+	}
+
+	clusterBytes = (sv.numClusters + 7) >> 3;
+	for ( i = 0 ; i < clusterBytes ; i++ ) {
+		bits = clientpvs[i];
+		for ( c = i << 3 ; bits ; c++, bits >>= 1 ) {
+			if ( !(bits & 1) || c >= sv.numClusters ) {
+				continue;
+			}
+			for ( link = sv.clusterEntities[c] ; link ; link = link->next ) {
+				candidates[link->entityNum >> 5] |= 1 << (link->entityNum & 31);
+			}
+		}
+	}
+}
+
 /*
 ===============
 SV_AddEntitiesVisibleFromPoint
@@ -364,6 +608,7 @@ float g_svCullDist = -1.0f;
 static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
 									snapshotEntityNumbers_t *eNums, qboolean portal ) {
 	int		e, i;
+	int		candidates[MAX_GENTITIES/32];
 	sharedEntity_t *ent;
 	svEntity_t	*svEnt;
 	int		l;
@@ -390,7 +635,17 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 	clientpvs = CM_ClusterPVS (clientcluster);
 
+	SV_GatherSnapshotCandidates( clientpvs, frame->ps.clientNum, candidates );
+
 	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		// only look at entities in visible clusters, skipping empty words whole
+		if ( !(candidates[e >> 5] & (1 << (e & 31))) ) {
+			if ( !candidates[e >> 5] ) {
+				e |= 31;
+			}
+			continue;
+		}
+
 		ent = SV_GentityNum(e);
 
 		// never send entities that aren't linked in
@@ -429,7 +684,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		svEnt = SV_SvEntityForGentity( ent );
 
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( eNums->added[e >> 5] & (1 << (e & 31)) ) {
 			continue;
 		}
 
@@ -443,13 +698,13 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		if ( (ent->r.svFlags & SVF_BROADCAST) || e == frame->ps.clientNum
 			|| (ent->r.broadcastClients[frame->ps.clientNum/32] & (1 << (frame->ps.clientNum % 32))) )
 		{
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( ent, eNums );
 			continue;
 		}
 
 		if (ent->s.isPortalEnt)
 		{ //rww - portal entities are always sent as well
-			SV_AddEntToSnapshot( svEnt, ent, eNums );
+			SV_AddEntToSnapshot( ent, eNums );
 			continue;
 		}
 
@@ -511,7 +766,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		}
 
 		// add it
-		SV_AddEntToSnapshot( svEnt, ent, eNums );
+		SV_AddEntToSnapshot( ent, eNums );
 
 		// if its a portal entity, add everything visible from its camera position
 		if ( ent->r.svFlags & SVF_PORTAL ) {
@@ -529,43 +784,41 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 /*
 =============
-SV_BuildClientSnapshot
+SV_GatherClientSnapshot
 
 Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+copies off the playerstate and areabits. Returns qfalse if the client
+has nothing to see this frame.
 
 This properly handles multiple recursive portals, but the render
 currently doesn't.
 
 For viewing through other player's eyes, client can be something other than client->gentity
+
+Only reads shared server state, so SV_SendClientMessages can run it for
+several clients at once.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
+static qboolean SV_GatherClientSnapshot( client_t *client, snapshotEntityNumbers_t *entityNumbers ) {
 	vec3_t						org;
 	clientSnapshot_t			*frame;
-	snapshotEntityNumbers_t		entityNumbers;
 	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
-	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	playerState_t				*ps;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	entityNumbers->numSnapshotEntities = 0;
+	Com_Memset( entityNumbers->added, 0, sizeof( entityNumbers->added ) );
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	frame->num_entities = 0;
 
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
@@ -599,8 +852,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
 	}
-	svEnt = &sv.svEntities[ clientNum ];
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	entityNumbers->added[clientNum >> 5] |= 1 << (clientNum & 31);
 
 
 	// find the client's viewpoint
@@ -609,14 +861,14 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	SV_AddEntitiesVisibleFromPoint( org, frame, entityNumbers, qfalse );
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
 	// to work correctly.  This also catches the error condition
 	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities,
-		sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	qsort( entityNumbers->snapshotEntities, entityNumbers->numSnapshotEntities,
+		sizeof( entityNumbers->snapshotEntities[0] ), SV_QsortEntityNumbers );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -624,22 +876,64 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
-	frame->num_entities = 0;
+	return qtrue;
+}
+
+/*
+=============
+SV_ReserveClientSnapshot
+
+Claims the range of svs.snapshotEntities the gathered entities will be copied to
+=============
+*/
+static void SV_ReserveClientSnapshot( client_t *client, const snapshotEntityNumbers_t *entityNumbers ) {
+	clientSnapshot_t	*frame;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
-		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
-		*state = ent->s;
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
-			Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
-		}
-		frame->num_entities++;
+	svs.nextSnapshotEntities += entityNumbers->numSnapshotEntities;
+	// this should never hit, map should always be restarted first in SV_Frame
+	if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
+		Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
 	}
 }
 
+/*
+=============
+SV_StoreClientSnapshot
+
+Copies the entity states out into the reserved range
+=============
+*/
+static void SV_StoreClientSnapshot( client_t *client, const snapshotEntityNumbers_t *entityNumbers ) {
+	clientSnapshot_t	*frame;
+	int					i;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
+	for ( i = 0 ; i < entityNumbers->numSnapshotEntities ; i++ ) {
+		svs.snapshotEntities[(frame->first_entity + i) % svs.numSnapshotEntities] =
+			SV_GentityNum(entityNumbers->snapshotEntities[i])->s;
+	}
+	frame->num_entities = entityNumbers->numSnapshotEntities;
+}
+
+/*
+=============
+SV_BuildClientSnapshot
+=============
+*/
+static void SV_BuildClientSnapshot( client_t *client ) {
+	snapshotEntityNumbers_t		entityNumbers;
+
+	if ( !SV_GatherClientSnapshot( client, &entityNumbers ) ) {
+		return;
+	}
+	SV_ReserveClientSnapshot( client, &entityNumbers );
+	SV_StoreClientSnapshot( client, &entityNumbers );
+}
+
 
 /*
 ====================
@@ -762,62 +1056,64 @@ void SV_SendMessageToClient( msg_t *msg, client_t *client ) {
 
 /*
 =======================
-SV_SendClientSnapshot
-
-Also called by SV_FinalMessage
+SV_SendClientGamedir
 
+rww - if the client hasn't been told the game dir yet then make sure there
+is an svc_setgame sent before the next snapshot
 =======================
 */
 extern cvar_t	*fs_gamedirvar;
-void SV_SendClientSnapshot( client_t *client ) {
+static void SV_SendClientGamedir( client_t *client ) {
 	byte		msg_buf[MAX_MSGLEN];
 	msg_t		msg;
+	int			i = 0;
 
-	if (!client->sentGamedir)
-	{ //rww - if this is the case then make sure there is an svc_setgame sent before this snap
-		int i = 0;
-
-		MSG_Init (&msg, msg_buf, sizeof(msg_buf));
+	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
 
-		//have to include this for each message.
-		MSG_WriteLong( &msg, client->lastClientCommand );
+	//have to include this for each message.
+	MSG_WriteLong( &msg, client->lastClientCommand );
 
-		MSG_WriteByte (&msg, svc_setgame);
+	MSG_WriteByte (&msg, svc_setgame);
 
-		const char *gamedir = FS_GetCurrentGameDir(true);
+	const char *gamedir = FS_GetCurrentGameDir(true);
 
-		while (gamedir[i])
-		{
-			MSG_WriteByte(&msg, gamedir[i]);
-			i++;
-		}
-		MSG_WriteByte(&msg, 0);
+	while (gamedir[i])
+	{
+		MSG_WriteByte(&msg, gamedir[i]);
+		i++;
+	}
+	MSG_WriteByte(&msg, 0);
 
-		// MW - my attempt to fix illegible server message errors caused by
-		// packet fragmentation of initial snapshot.
-		//rww - reusing this code here
-		while(client->state&&client->netchan.unsentFragments)
-		{
-			// send additional message fragments if the last message
-			// was too large to send at once
-			Com_Printf ("[ISM]SV_SendClientGameState() [1] for %s, writing out old fragments\n", client->name);
-			SV_Netchan_TransmitNextFragment(&client->netchan);
-		}
+	// MW - my attempt to fix illegible server message errors caused by
+	// packet fragmentation of initial snapshot.
+	//rww - reusing this code here
+	while(client->state&&client->netchan.unsentFragments)
+	{
+		// send additional message fragments if the last message
+		// was too large to send at once
+		Com_Printf ("[ISM]SV_SendClientGameState() [1] for %s, writing out old fragments\n", client->name);
+		SV_Netchan_TransmitNextFragment(&client->netchan);
+	}
 
-		// record information about the message
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = msg.cursize;
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSent = svs.time;
-		client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageAcked = -1;
+	// record information about the message
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSize = msg.cursize;
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageSent = svs.time;
+	client->frames[client->netchan.outgoingSequence & PACKET_MASK].messageAcked = -1;
 
-		// send the datagram
-		SV_Netchan_Transmit( client, &msg );	//msg->cursize, msg->data );
+	// send the datagram
+	SV_Netchan_Transmit( client, &msg );	//msg->cursize, msg->data );
 
-		client->sentGamedir = qtrue;
-	}
+	client->sentGamedir = qtrue;
+}
 
-	// build the snapshot
-	SV_BuildClientSnapshot( client );
+/*
+=======================
+SV_CheckAutoDemo
 
+Returns qfalse for bots that only need their snapshot built
+=======================
+*/
+static qboolean SV_CheckAutoDemo( client_t *client ) {
 	if ( sv_autoDemo->integer && !client->demo.demorecording ) {
 		if ( client->netchan.remoteAddress.type != NA_BOT || sv_autoDemoBots->integer ) {
 			SV_BeginAutoRecordDemos();
@@ -827,33 +1123,155 @@ void SV_SendClientSnapshot( client_t *client ) {
 	// bots need to have their snapshots built, but
 	// they query them directly without needing to be sent
 	if ( client->netchan.remoteAddress.type == NA_BOT && !client->demo.demorecording ) {
-		return;
+		return qfalse;
 	}
+	return qtrue;
+}
 
-	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
-	msg.allowoverflow = qtrue;
+/*
+=======================
+SV_WriteClientSnapshot
+
+Writes everything but the download data into msg
+=======================
+*/
+static void SV_WriteClientSnapshot( client_t *client, msg_t *msg, byte *msg_buf, int msg_bufSize ) {
+	MSG_Init (msg, msg_buf, msg_bufSize);
+	msg->allowoverflow = qtrue;
 
 	// NOTE, MRE: all server->client messages now acknowledge
 	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	MSG_WriteLong( msg, client->lastClientCommand );
 
 	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_UpdateServerCommandsToClient( client, msg );
 
 	// send over all the relevant entityState_t
 	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+	SV_WriteSnapshotToClient( client, msg );
+}
 
+/*
+=======================
+SV_FinishClientSnapshot
+=======================
+*/
+static void SV_FinishClientSnapshot( client_t *client, msg_t *msg ) {
 	// Add any download data if the client is downloading
-	SV_WriteDownloadToClient( client, &msg );
+	SV_WriteDownloadToClient( client, msg );
 
 	// check for overflow
-	if ( msg.overflowed ) {
+	if ( msg->overflowed ) {
 		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
-		MSG_Clear (&msg);
+		MSG_Clear (msg);
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	SV_SendMessageToClient( msg, client );
+}
+
+/*
+=======================
+SV_SendClientSnapshot
+
+Also called by SV_FinalMessage
+
+=======================
+*/
+void SV_SendClientSnapshot( client_t *client ) {
+	byte		msg_buf[MAX_MSGLEN];
+	msg_t		msg;
+
+	if (!client->sentGamedir)
+	{
+		SV_SendClientGamedir( client );
+	}
+
+	// build the snapshot
+	SV_BuildClientSnapshot( client );
+
+	if ( !SV_CheckAutoDemo( client ) ) {
+		return;
+	}
+
+	SV_WriteClientSnapshot( client, &msg, msg_buf, sizeof(msg_buf) );
+	SV_FinishClientSnapshot( client, &msg );
+}
+
+/*
+=============================================================================
+
+Parallel snapshots
+
+With com_jobThreads workers running, the entity gathering and the message
+encoding of each client are done as jobs. Everything that touches the
+network, the file system, demos or svs.nextSnapshotEntities stays on the
+main thread, in client order, in between the batches.
+
+=============================================================================
+*/
+
+typedef struct snapshotJob_s {
+	client_t				*client;
+	qboolean				built;		// the gather found something to store
+	qboolean				send;		// not a bot that only needs the snapshot built
+	snapshotEntityNumbers_t	entityNumbers;
+	msg_t					msg;
+	byte					msg_buf[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t	sv_snapshotJobs[MAX_CLIENTS];
+
+static void SV_GatherSnapshotJob( void *data, int index ) {
+	snapshotJob_t	*job = (snapshotJob_t *)data + index;
+
+	job->built = SV_GatherClientSnapshot( job->client, &job->entityNumbers );
+}
+
+static void SV_EncodeSnapshotJob( void *data, int index ) {
+	snapshotJob_t	*job = (snapshotJob_t *)data + index;
+
+	if ( job->built ) {
+		SV_StoreClientSnapshot( job->client, &job->entityNumbers );
+	}
+	if ( job->send ) {
+		SV_WriteClientSnapshot( job->client, &job->msg, job->msg_buf, sizeof(job->msg_buf) );
+	}
+}
+
+/*
+=======================
+SV_SendClientSnapshotsParallel
+
+Same as calling SV_SendClientSnapshot for each job's client in turn, except
+that the "out of date entities" check in SV_WriteSnapshotToClient sees the
+ranges reserved for every client this frame rather than only the earlier ones
+=======================
+*/
+static void SV_SendClientSnapshotsParallel( snapshotJob_t *jobs, int numJobs ) {
+	int		i;
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		if ( !jobs[i].client->sentGamedir ) {
+			SV_SendClientGamedir( jobs[i].client );
+		}
+	}
+
+	Com_RunJobs( SV_GatherSnapshotJob, jobs, numJobs );
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		if ( jobs[i].built ) {
+			SV_ReserveClientSnapshot( jobs[i].client, &jobs[i].entityNumbers );
+		}
+		jobs[i].send = SV_CheckAutoDemo( jobs[i].client );
+	}
+
+	Com_RunJobs( SV_EncodeSnapshotJob, jobs, numJobs );
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		if ( jobs[i].send ) {
+			SV_FinishClientSnapshot( jobs[i].client, &jobs[i].msg );
+		}
+	}
 }
 
 
@@ -865,6 +1283,22 @@ SV_SendClientMessages
 void SV_SendClientMessages( void ) {
 	int			i;
 	client_t	*c;
+	qboolean	parallel;
+	int			numJobs;
+
+	// entity flags can't change until all snapshots are out
+	SV_BuildBroadcastEntities();
+	sv_broadcastEntitiesValid = qtrue;
+
+	// and neither can their states
+	SV_ClearDeltaCache();
+	sv_deltaCacheActive = qtrue;
+
+	// everything sent here goes out in one batch at the end
+	NET_BeginPacketQueue();
+
+	parallel = ( sv_parallelSnapshots->integer && Com_JobThreads() > 0 ) ? qtrue : qfalse;
+	numJobs = 0;
 
 	// send a message to each connected client
 	for (i=0, c = svs.clients ; i < sv_maxclients->integer ; i++, c++) {
@@ -886,7 +1320,21 @@ void SV_SendClientMessages( void ) {
 		}
 
 		// generate and send a new message
-		SV_SendClientSnapshot( c );
+		if ( parallel ) {
+			sv_snapshotJobs[numJobs++].client = c;
+		} else {
+			SV_SendClientSnapshot( c );
+		}
 	}
-}
 
+	if ( numJobs == 1 ) {
+		SV_SendClientSnapshot( sv_snapshotJobs[0].client );
+	} else if ( numJobs > 1 ) {
+		SV_SendClientSnapshotsParallel( sv_snapshotJobs, numJobs );
+	}
+
+	NET_FlushPacketQueue();
+
+	sv_broadcastEntitiesValid = qfalse;
+	sv_deltaCacheActive = qfalse;
+}
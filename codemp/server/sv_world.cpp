@@ -26,6 +26,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include "server.h"
 #include "ghoul2/ghoul2_shared.h"
 #include "qcommon/cm_public.h"
+#include "qcommon/jobs.h"
 
 /*
 ================
@@ -36,18 +37,22 @@ given entity.  If the entity is a bsp model, the headnode will
 be returned, otherwise a custom box tree will be constructed.
 ================
 */
-clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
+clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent, cmTraceContext_t *context ) {
 	if ( ent->r.bmodel ) {
 		// explicit hulls in the BSP model
 		return CM_InlineModel( ent->s.modelindex );
 	}
 	if ( ent->r.svFlags & SVF_CAPSULE ) {
 		// create a temp capsule from bounding box sizes
-		return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qtrue );
+		return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qtrue, context );
 	}
 
 	// create a temp tree from bounding box sizes
-	return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qfalse );
+	return CM_TempBoxModel( ent->r.mins, ent->r.maxs, qfalse, context );
+}
+
+clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
+	return SV_ClipHandleForEntity( ent, CM_TraceContext( 0 ) );
 }
 
 
@@ -58,88 +63,112 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
 ENTITY CHECKING
 
 To avoid linearly searching through lists of entities during environment testing,
-the world is carved up with an evenly spaced, axially aligned bsp tree.  Entities
-are kept in chains either at the final leafs, or at the first node that splits
-them, which prevents having to deal with multiple fragments of a single entity.
+the world is carved up into a few loose grids of increasing cell size. Each entity
+is kept in a single chain, in the finest grid whose cells are at least as wide as
+the entity, in the cell that holds the center of its bounds. An entity can then
+only stick out half a cell past its own cell, so a query only has to walk the
+cells its bounds overlap once grown by half a cell. Entities wider than the
+coarsest cells, or centered off the grid, go in one chain every query checks.
+
+Unlike an axial tree, entities crossing a cell border don't end up in a chain
+near the top that every query has to go through.
 
 ===============================================================================
 */
 
 typedef struct worldSector_s {
-	int		axis;		// -1 = leaf node
-	float	dist;
-	struct worldSector_s	*children[2];
 	svEntity_t	*entities;
 } worldSector_t;
 
-#define	AREA_DEPTH	4
-#define	AREA_NODES	64
+#define	AREA_LEVELS			3
+#define	AREA_MIN_CELL		128.0f	// cell size of the finest grid
+#define	AREA_MAX_CELLS		128		// the finest cells grow to keep the grid under this many per axis
+#define	AREA_LEVEL_SCALE	4.0f	// cell size ratio between grids
+
+typedef struct areaGrid_s {
+	float			cellSize;
+	int				dims[2];
+	worldSector_t	*cells;
+} areaGrid_t;
 
-worldSector_t	sv_worldSectors[AREA_NODES];
-int			sv_numworldSectors;
+static areaGrid_t		sv_areaGrids[AREA_LEVELS];
+static worldSector_t	sv_areaOversize;
+static vec2_t			sv_areaOrigin;
 
 
 /*
 ===============
-SV_SectorList_f
+SV_SectorCount
 ===============
 */
-void SV_SectorList_f( void ) {
-	int				i, c;
-	worldSector_t	*sec;
+static int SV_SectorCount( const worldSector_t *sec ) {
+	int				c;
 	svEntity_t		*ent;
 
-	for ( i = 0 ; i < AREA_NODES ; i++ ) {
-		sec = &sv_worldSectors[i];
-
-		c = 0;
-		for ( ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector ) {
-			c++;
-		}
-		Com_Printf( "sector %i: %i entities\n", i, c );
+	c = 0;
+	for ( ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector ) {
+		c++;
 	}
+	return c;
 }
 
 /*
 ===============
-SV_CreateworldSector
-
-Builds a uniformly subdivided tree for the given world size
+SV_SectorList_f
 ===============
 */
-worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs ) {
-	worldSector_t	*anode;
-	vec3_t		size;
-	vec3_t		mins1, maxs1, mins2, maxs2;
-
-	anode = &sv_worldSectors[sv_numworldSectors];
-	sv_numworldSectors++;
+void SV_SectorList_f( void ) {
+	int				i, level, c, used, total;
+	areaGrid_t		*grid;
 
-	if (depth == AREA_DEPTH) {
-		anode->axis = -1;
-		anode->children[0] = anode->children[1] = NULL;
-		return anode;
-	}
+	for ( level = 0 ; level < AREA_LEVELS ; level++ ) {
+		grid = &sv_areaGrids[level];
+		if ( !grid->cells ) {
+			continue;
+		}
 
-	VectorSubtract (maxs, mins, size);
-	if (size[0] > size[1]) {
-		anode->axis = 0;
-	} else {
-		anode->axis = 1;
+		used = total = 0;
+		for ( i = 0 ; i < grid->dims[0] * grid->dims[1] ; i++ ) {
+			c = SV_SectorCount( &grid->cells[i] );
+			if ( c ) {
+				Com_Printf( "grid %i sector %i,%i: %i entities\n", level, i % grid->dims[0], i / grid->dims[0], c );
+				used++;
+				total += c;
+			}
+		}
+		Com_Printf( "grid %i: %ix%i sectors of %.0f units, %i entities in %i sectors\n",
+			level, grid->dims[0], grid->dims[1], grid->cellSize, total, used );
 	}
 
-	anode->dist = 0.5 * (maxs[anode->axis] + mins[anode->axis]);
-	VectorCopy (mins, mins1);
-	VectorCopy (mins, mins2);
-	VectorCopy (maxs, maxs1);
-	VectorCopy (maxs, maxs2);
-
-	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
+	Com_Printf( "oversize: %i entities\n", SV_SectorCount( &sv_areaOversize ) );
+}
 
-	anode->children[0] = SV_CreateworldSector (depth+1, mins2, maxs2);
-	anode->children[1] = SV_CreateworldSector (depth+1, mins1, maxs1);
+/*
+===============
+SV_CreateAreaGrids
 
-	return anode;
+Sizes the loose grids to cover the given world bounds
+===============
+*/
+static void SV_CreateAreaGrids( const vec3_t mins, const vec3_t maxs ) {
+	int			i, level;
+	float		size, cellSize;
+	areaGrid_t	*grid;
+
+	size = Q_max( maxs[0] - mins[0], maxs[1] - mins[1] );
+	cellSize = Q_max( AREA_MIN_CELL, size / AREA_MAX_CELLS );
+
+	sv_areaOrigin[0] = mins[0];
+	sv_areaOrigin[1] = mins[1];
+
+	for ( level = 0 ; level < AREA_LEVELS ; level++, cellSize *= AREA_LEVEL_SCALE ) {
+		grid = &sv_areaGrids[level];
+		grid->cellSize = cellSize;
+		for ( i = 0 ; i < 2 ; i++ ) {
+			grid->dims[i] = (int)( ( maxs[i] - mins[i] ) / cellSize ) + 1;
+		}
+		grid->cells = (worldSector_t *)Hunk_Alloc( grid->dims[0] * grid->dims[1] * sizeof( *grid->cells ), h_high );
+	}
 }
 
 /*
@@ -152,15 +181,129 @@ void SV_ClearWorld( void ) {
 	clipHandle_t	h;
 	vec3_t			mins, maxs;
 
-	Com_Memset( sv_worldSectors, 0, sizeof(sv_worldSectors) );
-	sv_numworldSectors = 0;
+	Com_Memset( &sv_areaOversize, 0, sizeof( sv_areaOversize ) );
+
+	// per-cluster entity lists for snapshot culling
+	sv.numClusters = CM_NumClusters();
+	sv.clusterEntities = (svClusterLink_t **)Hunk_Alloc( sv.numClusters * sizeof( *sv.clusterEntities ), h_high );
+	Com_Memset( sv.overflowEntities, 0, sizeof( sv.overflowEntities ) );
 
 	// get world map bounds
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
-	SV_CreateworldSector( 0, mins, maxs );
+	SV_CreateAreaGrids( mins, maxs );
+}
+
+/*
+===============
+SV_SectorForBounds
+
+Picks the one sector an entity with the given bounds is linked into
+===============
+*/
+static worldSector_t *SV_SectorForBounds( const vec3_t absmin, const vec3_t absmax ) {
+	int			level, x, y;
+	float		size, cx, cy;
+	areaGrid_t	*grid;
+
+	size = Q_max( absmax[0] - absmin[0], absmax[1] - absmin[1] );
+	cx = 0.5f * ( absmin[0] + absmax[0] ) - sv_areaOrigin[0];
+	cy = 0.5f * ( absmin[1] + absmax[1] ) - sv_areaOrigin[1];
+
+	for ( level = 0 ; level < AREA_LEVELS ; level++ ) {
+		grid = &sv_areaGrids[level];
+		if ( !grid->cells ) {
+			break;
+		}
+		if ( size > grid->cellSize ) {
+			continue;
+		}
+
+		if ( cx < 0 || cy < 0 ) {
+			break;
+		}
+		x = (int)( cx / grid->cellSize );
+		y = (int)( cy / grid->cellSize );
+		if ( x >= grid->dims[0] || y >= grid->dims[1] ) {
+			break;
+		}
+		return &grid->cells[y * grid->dims[0] + x];
+	}
+
+	return &sv_areaOversize;
+}
+
+/*
+===============
+SV_UnlinkEntityClusters
+
+Removes the entity from the per-cluster snapshot lists
+===============
+*/
+static void SV_UnlinkEntityClusters( svEntity_t *ent ) {
+	int				i;
+	svClusterLink_t	*link;
+
+	for ( i = 0 ; i < ent->numClusterLinks ; i++ ) {
+		link = &ent->clusterLinks[i];
+		*link->prev = link->next;
+		if ( link->next ) {
+			link->next->prev = link->prev;
+		}
+	}
+	ent->numClusterLinks = 0;
+
+	i = ent - sv.svEntities;
+	sv.overflowEntities[i >> 5] &= ~(1 << (i & 31));
 }
 
+/*
+===============
+SV_LinkEntityClusters
+
+Adds the entity to the snapshot list of every cluster it touches
+===============
+*/
+static void SV_LinkEntityClusters( svEntity_t *ent ) {
+	int				i, j, cluster;
+	const int		entityNum = ent - sv.svEntities;
+	svClusterLink_t	*link;
+
+	if ( !sv.clusterEntities ) {
+		return;
+	}
+
+	for ( i = 0 ; i < ent->numClusters ; i++ ) {
+		cluster = ent->clusternums[i];
+		if ( cluster < 0 || cluster >= sv.numClusters ) {
+			continue;
+		}
+
+		// several leafs may share a cluster
+		for ( j = 0 ; j < i ; j++ ) {
+			if ( ent->clusternums[j] == cluster ) {
+				break;
+			}
+		}
+		if ( j != i ) {
+			continue;
+		}
+
+		link = &ent->clusterLinks[ent->numClusterLinks++];
+		link->entityNum = entityNum;
+		link->prev = &sv.clusterEntities[cluster];
+		link->next = sv.clusterEntities[cluster];
+		if ( link->next ) {
+			link->next->prev = &link->next;
+		}
+		sv.clusterEntities[cluster] = link;
+	}
+
+	// clusters past clusternums are only known as a range, so these always get checked
+	if ( ent->lastCluster ) {
+		sv.overflowEntities[entityNum >> 5] |= 1 << (entityNum & 31);
+	}
+}
 
 /*
 ===============
@@ -177,6 +320,8 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linked = qfalse;
 
+	SV_UnlinkEntityClusters( ent );
+
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;		// not linked in anywhere
@@ -343,25 +488,14 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linkcount++;
 
-	// find the first world sector node that the ent's box crosses
-	node = sv_worldSectors;
-	while (1)
-	{
-		if (node->axis == -1)
-			break;
-		if ( gEnt->r.absmin[node->axis] > node->dist)
-			node = node->children[0];
-		else if ( gEnt->r.absmax[node->axis] < node->dist)
-			node = node->children[1];
-		else
-			break;		// crosses the node
-	}
-
 	// link it in
+	node = SV_SectorForBounds( gEnt->r.absmin, gEnt->r.absmax );
 	ent->worldSector = node;
 	ent->nextEntityInWorldSector = node->entities;
 	node->entities = ent;
 
+	SV_LinkEntityClusters( ent );
+
 	gEnt->r.linked = qtrue;
 }
 
@@ -380,23 +514,24 @@ typedef struct areaParms_s {
 	const float	*maxs;
 	int			*list;
 	int			count, maxcount;
+	int			tested;
 } areaParms_t;
 
 
 /*
 ====================
-SV_AreaEntities_r
+SV_AreaEntitiesInSector
 
+Returns qfalse once the list is full
 ====================
 */
-void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
-	svEntity_t	*check, *next;
+static qboolean SV_AreaEntitiesInSector( const worldSector_t *sec, areaParms_t *ap ) {
+	svEntity_t	*check;
 	sharedEntity_t *gcheck;
 
-	for ( check = node->entities  ; check ; check = next ) {
-		next = check->nextEntityInWorldSector;
-
+	for ( check = sec->entities ; check ; check = check->nextEntityInWorldSector ) {
 		gcheck = SV_GEntityForSvEntity( check );
+		ap->tested++;
 
 		if ( gcheck->r.absmin[0] > ap->maxs[0]
 		|| gcheck->r.absmin[1] > ap->maxs[1]
@@ -409,23 +544,71 @@ void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 
 		if ( ap->count == ap->maxcount ) {
 			Com_DPrintf ("SV_AreaEntities: MAXCOUNT\n");
-			return;
+			return qfalse;
 		}
 
 		ap->list[ap->count] = check - sv.svEntities;
 		ap->count++;
 	}
 
-	if (node->axis == -1) {
-		return;		// terminal node
+	return qtrue;
+}
+
+/*
+====================
+SV_AreaCellRange
+
+Range of cells along one axis whose loose bounds touch [mins, maxs]
+====================
+*/
+static qboolean SV_AreaCellRange( const areaGrid_t *grid, int axis, float mins, float maxs, int *first, int *last ) {
+	float	half, lo, hi;
+
+	// entities reach at most half a cell out of their own
+	half = 0.5f * grid->cellSize;
+	lo = ( mins - half - sv_areaOrigin[axis] ) / grid->cellSize;
+	hi = ( maxs + half - sv_areaOrigin[axis] ) / grid->cellSize;
+
+	if ( hi < 0 || lo >= grid->dims[axis] ) {
+		return qfalse;
 	}
 
-	// recurse down both sides
-	if ( ap->maxs[node->axis] > node->dist ) {
-		SV_AreaEntities_r ( node->children[0], ap );
+	*first = lo < 0 ? 0 : (int)lo;
+	*last = hi >= grid->dims[axis] ? grid->dims[axis] - 1 : (int)hi;
+	return qtrue;
+}
+
+/*
+====================
+SV_AreaEntitiesParms
+====================
+*/
+static void SV_AreaEntitiesParms( areaParms_t *ap ) {
+	int			level, x, y, x0, x1, y0, y1;
+	areaGrid_t	*grid;
+
+	if ( !SV_AreaEntitiesInSector( &sv_areaOversize, ap ) ) {
+		return;
 	}
-	if ( ap->mins[node->axis] < node->dist ) {
-		SV_AreaEntities_r ( node->children[1], ap );
+
+	for ( level = 0 ; level < AREA_LEVELS ; level++ ) {
+		grid = &sv_areaGrids[level];
+		if ( !grid->cells ) {
+			return;
+		}
+
+		if ( !SV_AreaCellRange( grid, 0, ap->mins[0], ap->maxs[0], &x0, &x1 )
+			|| !SV_AreaCellRange( grid, 1, ap->mins[1], ap->maxs[1], &y0, &y1 ) ) {
+			continue;
+		}
+
+		for ( y = y0 ; y <= y1 ; y++ ) {
+			for ( x = x0 ; x <= x1 ; x++ ) {
+				if ( !SV_AreaEntitiesInSector( &grid->cells[y * grid->dims[0] + x], ap ) ) {
+					return;
+				}
+			}
+		}
 	}
 }
 
@@ -442,12 +625,114 @@ int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int
 	ap.list = entityList;
 	ap.count = 0;
 	ap.maxcount = maxcount;
+	ap.tested = 0;
 
-	SV_AreaEntities_r( sv_worldSectors, &ap );
+	SV_AreaEntitiesParms( &ap );
 
 	return ap.count;
 }
 
+/*
+================
+SV_AreaBench_f
+
+Runs SV_AreaEntities for boxes the size of short moves around every linked
+entity and reports how many entities each query had to look at
+================
+*/
+void SV_AreaBench_f( void ) {
+	int				i, j, k, n, rounds, queries, linked, brute;
+	int				list[MAX_GENTITIES];
+	int				start, msec;
+	int64_t			tested, found;
+	vec3_t			mins, maxs;
+	sharedEntity_t	*gEnt, *check;
+	areaParms_t		ap;
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	rounds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 100;
+	if ( rounds < 1 ) {
+		rounds = 1;
+	}
+
+	linked = 0;
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		if ( SV_GentityNum( i )->r.linked ) {
+			linked++;
+		}
+	}
+
+	// first check the grid finds the same entities a linear search does
+	queries = 0;
+	tested = found = 0;
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		gEnt = SV_GentityNum( i );
+		if ( !gEnt->r.linked ) {
+			continue;
+		}
+
+		for ( k = 0 ; k < 3 ; k++ ) {
+			mins[k] = gEnt->r.absmin[k] - 64;
+			maxs[k] = gEnt->r.absmax[k] + 64;
+		}
+
+		n = SV_AreaEntities( mins, maxs, list, MAX_GENTITIES );
+
+		brute = 0;
+		for ( j = 0 ; j < sv.num_entities ; j++ ) {
+			check = SV_GentityNum( j );
+			if ( check->r.linked && SV_SvEntityForGentity( check )->worldSector
+				&& check->r.absmin[0] <= maxs[0] && check->r.absmin[1] <= maxs[1] && check->r.absmin[2] <= maxs[2]
+				&& check->r.absmax[0] >= mins[0] && check->r.absmax[1] >= mins[1] && check->r.absmax[2] >= mins[2] ) {
+				brute++;
+			}
+		}
+		if ( brute != n ) {
+			Com_Printf( S_COLOR_YELLOW "entity %i: grid found %i entities, linear search %i\n", i, n, brute );
+		}
+	}
+
+	start = Sys_Milliseconds();
+	for ( j = 0 ; j < rounds ; j++ ) {
+		for ( i = 0 ; i < sv.num_entities ; i++ ) {
+			gEnt = SV_GentityNum( i );
+			if ( !gEnt->r.linked ) {
+				continue;
+			}
+
+			// a box like SV_Trace builds for a move of up to 256 units
+			for ( k = 0 ; k < 3 ; k++ ) {
+				mins[k] = gEnt->r.absmin[k] - ( ( i + j * 7 + k * 3 ) & 255 );
+				maxs[k] = gEnt->r.absmax[k] + ( ( i * 3 + j + k * 5 ) & 255 );
+			}
+
+			ap.mins = mins;
+			ap.maxs = maxs;
+			ap.list = list;
+			ap.count = 0;
+			ap.maxcount = MAX_GENTITIES;
+			ap.tested = 0;
+			SV_AreaEntitiesParms( &ap );
+
+			queries++;
+			tested += ap.tested;
+			found += ap.count;
+		}
+	}
+	msec = Sys_Milliseconds() - start;
+
+	if ( !queries ) {
+		Com_Printf( "No linked entities.\n" );
+		return;
+	}
+
+	Com_Printf( "%i queries, %i linked entities: %.1f tested and %.1f found per query, %i msec\n",
+		queries, linked, (double)tested / queries, (double)found / queries, msec );
+}
 
 
 //===========================================================================
@@ -470,6 +755,7 @@ Ghoul2 Insert Start
 
 	int			traceFlags;
 	int			useLod;
+	cmTraceContext_t	*context;
 	trace_t		trace;			// make sure nothing goes under here for Ghoul2 collision purposes
 /*
 Ghoul2 Insert End
@@ -535,9 +821,8 @@ static float VectorDistance(vec3_t p1, vec3_t p2)
 }
 #endif
 
-static void SV_ClipMoveToEntities( moveclip_t *clip ) {
-	static int	touchlist[MAX_GENTITIES];
-	int			i, num;
+static void SV_ClipMoveToEntityList( moveclip_t *clip, const int *touchlist, int num ) {
+	int			i;
 	sharedEntity_t *touch;
 	int			passOwnerNum;
 	trace_t		trace, oldTrace= {0};
@@ -545,8 +830,6 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 	float		*origin, *angles;
 	int			thisOwnerShared = 1;
 
-	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
-
 	if ( clip->passEntityNum != ENTITYNUM_NONE ) {
 		passOwnerNum = ( SV_GentityNum( clip->passEntityNum ) )->r.ownerNum;
 		if ( passOwnerNum == ENTITYNUM_NONE ) {
@@ -612,7 +895,7 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 		}
 
 		// might intersect, so do an exact clip
-		clipHandle = SV_ClipHandleForEntity (touch);
+		clipHandle = SV_ClipHandleForEntity (touch, clip->context);
 
 		origin = touch->r.currentOrigin;
 		angles = touch->r.currentAngles;
@@ -624,7 +907,7 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 
 		CM_TransformedBoxTrace ( &trace, (float *)clip->start, (float *)clip->end,
 			(float *)clip->mins, (float *)clip->maxs, clipHandle,  clip->contentmask,
-			origin, angles, clip->capsule);
+			origin, angles, clip->capsule, clip->context);
 
 
 		if (clip->traceFlags & G2TRFLAG_DOGHOULTRACE)
@@ -804,22 +1087,24 @@ Ghoul2 Insert End
 	}
 }
 
+static void SV_ClipMoveToEntities( moveclip_t *clip ) {
+	static int	touchlist[MAX_GENTITIES];
+	int			num;
+
+	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
+
+	SV_ClipMoveToEntityList( clip, touchlist, num );
+}
+
 /*
 ==================
-SV_Trace
+SV_SetupMoveClip
 
-Moves the given mins/maxs volume through the world from start to end.
-passEntityNum and entities owned by passEntityNum are explicitly not checked.
+Clips the move to the world and sets up clip for SV_ClipMoveToEntities.
+Returns qfalse if the world blocks the move right away, the trace is final then.
 ==================
 */
-/*
-Ghoul2 Insert Start
-*/
-void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod ) {
-/*
-Ghoul2 Insert End
-*/
-	moveclip_t	clip;
+static qboolean SV_SetupMoveClip( moveclip_t *clip, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod, cmTraceContext_t *context ) {
 	int			i;
 
 	if ( !mins ) {
@@ -829,32 +1114,32 @@ Ghoul2 Insert End
 		maxs = vec3_origin;
 	}
 
-	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
+	Com_Memset ( clip, 0, sizeof ( moveclip_t ) );
+	clip->context = context;
 
 	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
-	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
-	if ( clip.trace.fraction == 0 ) {
-		*results = clip.trace;
-		return;		// blocked immediately by the world
+	CM_BoxTrace( &clip->trace, start, end, mins, maxs, 0, contentmask, capsule, context );
+	clip->trace.entityNum = clip->trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+	if ( clip->trace.fraction == 0 ) {
+		return qfalse;		// blocked immediately by the world
 	}
 
-	clip.contentmask = contentmask;
+	clip->contentmask = contentmask;
 /*
 Ghoul2 Insert Start
 */
-	VectorCopy( start, clip.start );
-	clip.traceFlags = traceFlags;
-	clip.useLod = useLod;
+	VectorCopy( start, clip->start );
+	clip->traceFlags = traceFlags;
+	clip->useLod = useLod;
 /*
 Ghoul2 Insert End
 */
-//	VectorCopy( clip.trace.endpos, clip.end );
-	VectorCopy( end, clip.end );
-	clip.mins = mins;
-	clip.maxs = maxs;
-	clip.passEntityNum = passEntityNum;
-	clip.capsule = capsule;
+//	VectorCopy( clip->trace.endpos, clip->end );
+	VectorCopy( end, clip->end );
+	clip->mins = mins;
+	clip->maxs = maxs;
+	clip->passEntityNum = passEntityNum;
+	clip->capsule = capsule;
 
 	// create the bounding box of the entire move
 	// we can limit it to the part of the move not
@@ -862,20 +1147,215 @@ Ghoul2 Insert End
 	// a significant savings for line of sight and shot traces
 	for ( i=0 ; i<3 ; i++ ) {
 		if ( end[i] > start[i] ) {
-			clip.boxmins[i] = clip.start[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.end[i] + clip.maxs[i] + 1;
+			clip->boxmins[i] = clip->start[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->end[i] + clip->maxs[i] + 1;
 		} else {
-			clip.boxmins[i] = clip.end[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.start[i] + clip.maxs[i] + 1;
+			clip->boxmins[i] = clip->end[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->start[i] + clip->maxs[i] + 1;
 		}
 	}
 
-	// clip to other solid entities
-	SV_ClipMoveToEntities ( &clip );
+	return qtrue;
+}
+
+/*
+==================
+SV_Trace
+
+Moves the given mins/maxs volume through the world from start to end.
+passEntityNum and entities owned by passEntityNum are explicitly not checked.
+==================
+*/
+/*
+Ghoul2 Insert Start
+*/
+void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule, int traceFlags, int useLod ) {
+/*
+Ghoul2 Insert End
+*/
+	moveclip_t	clip;
+
+	if ( SV_SetupMoveClip( &clip, start, mins, maxs, end, passEntityNum, contentmask, capsule, traceFlags, useLod, CM_TraceContext( 0 ) ) ) {
+		// clip to other solid entities
+		SV_ClipMoveToEntities ( &clip );
+	}
 
 	*results = clip.trace;
 }
 
+/*
+==================
+SV_TraceBatch
+
+Same as calling SV_Trace for each request. Requests near each other share
+one SV_AreaEntities query for the union of their move boxes; each request
+then only clips against the entities that touch its own box, in the order
+its own query would have returned them.
+
+With sv_parallelTraces the requests are split into contiguous runs, one
+per job, each tracing with its own collision trace context. Ghoul2 traces
+are left for the main thread, the Ghoul2 collision code is not reentrant.
+==================
+*/
+#define	TRACE_BATCH_GROUP	32		// requests sharing one area query at most
+#define	TRACE_BATCH_SPAN	1024	// max width of a shared query box
+#define	TRACE_BATCH_JOB_MIN	16		// don't bother a worker with fewer requests
+
+typedef struct traceBatch_s {
+	moveclip_t	clips[TRACE_BATCH_GROUP];
+	int			indices[TRACE_BATCH_GROUP];
+	int			numClips;
+	vec3_t		mins, maxs;
+	int			touchlist[MAX_GENTITIES];
+	int			cliplist[MAX_GENTITIES];
+} traceBatch_t;
+
+typedef struct traceBatchJob_s {
+	trace_t					*results;
+	const traceRequest_t	*requests;
+	int						count;
+	int						numJobs;
+} traceBatchJob_t;
+
+static void SV_FlushTraceBatch( traceBatch_t *batch, trace_t *results ) {
+	int				i, j, num, numClip;
+	moveclip_t		*clip;
+	sharedEntity_t	*touch;
+
+	if ( batch->numClips == 1 ) {
+		clip = &batch->clips[0];
+		num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, batch->touchlist, MAX_GENTITIES );
+		SV_ClipMoveToEntityList( clip, batch->touchlist, num );
+		results[batch->indices[0]] = clip->trace;
+	} else if ( batch->numClips ) {
+		num = SV_AreaEntities( batch->mins, batch->maxs, batch->touchlist, MAX_GENTITIES );
+
+		for ( i = 0 ; i < batch->numClips ; i++ ) {
+			clip = &batch->clips[i];
+
+			numClip = 0;
+			for ( j = 0 ; j < num ; j++ ) {
+				touch = SV_GentityNum( batch->touchlist[j] );
+				if ( touch->r.absmin[0] > clip->boxmaxs[0]
+				|| touch->r.absmin[1] > clip->boxmaxs[1]
+				|| touch->r.absmin[2] > clip->boxmaxs[2]
+				|| touch->r.absmax[0] < clip->boxmins[0]
+				|| touch->r.absmax[1] < clip->boxmins[1]
+				|| touch->r.absmax[2] < clip->boxmins[2] ) {
+					continue;
+				}
+				batch->cliplist[numClip++] = batch->touchlist[j];
+			}
+
+			SV_ClipMoveToEntityList( clip, batch->cliplist, numClip );
+			results[batch->indices[i]] = clip->trace;
+		}
+	}
+
+	batch->numClips = 0;
+}
+
+/*
+==================
+SV_TraceBatchRange
+
+Traces requests [first, last) with the given context, skipping
+Ghoul2 traces if skipGhoul2 is set
+==================
+*/
+static void SV_TraceBatchRange( trace_t *results, const traceRequest_t *requests, int first, int last, qboolean skipGhoul2, cmTraceContext_t *context ) {
+	int					i, j;
+	moveclip_t			*clip;
+	const traceRequest_t *req;
+	traceBatch_t		batch;
+	vec3_t				mins, maxs;
+
+	batch.numClips = 0;
+
+	for ( i = first ; i < last ; i++ ) {
+		req = &requests[i];
+
+		if ( skipGhoul2 && ( req->traceFlags & G2TRFLAG_DOGHOULTRACE ) ) {
+			continue;
+		}
+
+		clip = &batch.clips[batch.numClips];
+		if ( !SV_SetupMoveClip( clip, req->start, req->mins, req->maxs, req->end, req->passEntityNum, req->contentmask, req->capsule, req->traceFlags, req->useLod, context ) ) {
+			results[i] = clip->trace;
+			continue;
+		}
+
+		if ( batch.numClips ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				mins[j] = Q_min( batch.mins[j], clip->boxmins[j] );
+				maxs[j] = Q_max( batch.maxs[j], clip->boxmaxs[j] );
+			}
+
+			if ( maxs[0] - mins[0] > TRACE_BATCH_SPAN || maxs[1] - mins[1] > TRACE_BATCH_SPAN ) {
+				// too far from the rest, start a new group with this one
+				moveclip_t	pending = *clip;
+
+				SV_FlushTraceBatch( &batch, results );
+				batch.clips[0] = pending;
+				VectorCopy( pending.boxmins, mins );
+				VectorCopy( pending.boxmaxs, maxs );
+			}
+		} else {
+			VectorCopy( clip->boxmins, mins );
+			VectorCopy( clip->boxmaxs, maxs );
+		}
+
+		VectorCopy( mins, batch.mins );
+		VectorCopy( maxs, batch.maxs );
+		batch.indices[batch.numClips++] = i;
+
+		if ( batch.numClips == TRACE_BATCH_GROUP ) {
+			SV_FlushTraceBatch( &batch, results );
+		}
+	}
+
+	SV_FlushTraceBatch( &batch, results );
+}
+
+static void SV_TraceBatchJob( void *data, int index ) {
+	traceBatchJob_t	*job = (traceBatchJob_t *)data;
+	int				first, last;
+
+	first = (int)( (long long)job->count * index / job->numJobs );
+	last = (int)( (long long)job->count * ( index + 1 ) / job->numJobs );
+
+	SV_TraceBatchRange( job->results, job->requests, first, last, qtrue, CM_TraceContext( index ) );
+}
+
+void SV_TraceBatch( trace_t *results, const traceRequest_t *requests, int count ) {
+	traceBatchJob_t		job;
+	const traceRequest_t *req;
+	int					i;
+
+	job.numJobs = 1;
+	if ( sv_parallelTraces->integer && !Com_JobsActive() ) {
+		job.numJobs = Q_min( Com_JobThreads() + 1, CM_NumTraceContexts() );
+		job.numJobs = Q_min( job.numJobs, count / TRACE_BATCH_JOB_MIN );
+	}
+
+	if ( job.numJobs <= 1 ) {
+		SV_TraceBatchRange( results, requests, 0, count, qfalse, CM_TraceContext( 0 ) );
+		return;
+	}
+
+	job.results = results;
+	job.requests = requests;
+	job.count = count;
+	Com_RunJobs( SV_TraceBatchJob, &job, job.numJobs );
+
+	for ( i = 0 ; i < count ; i++ ) {
+		req = &requests[i];
+		if ( req->traceFlags & G2TRFLAG_DOGHOULTRACE ) {
+			SV_Trace( &results[i], req->start, req->mins, req->maxs, req->end, req->passEntityNum, req->contentmask, req->capsule, req->traceFlags, req->useLod );
+		}
+	}
+}
+
 
 
 /*
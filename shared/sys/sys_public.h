@@ -152,6 +152,10 @@ void	Sys_FreeFileList( char **fileList );
 
 time_t Sys_FileTime( const char *path );
 
+// maps a whole file read only, NULL if it is empty or can't be mapped
+void	*Sys_MapFile( const char *path, int *length );
+void	Sys_UnmapFile( void *base, int length );
+
 qboolean Sys_LowPhysicalMemory();
 
 void Sys_SetProcessorAffinity( void );
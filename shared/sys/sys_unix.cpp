@@ -28,6 +28,7 @@ along with this program; if not, see <http://www.gnu.org/licenses/>.
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <pwd.h>
 #include <libgen.h>
 #include <sched.h>
@@ -421,6 +422,50 @@ void Sys_Sleep( int msec )
 	}
 }
 
+/*
+==================
+Sys_MapFile
+==================
+*/
+void *Sys_MapFile( const char *path, int *length )
+{
+	struct stat	st;
+	void		*base;
+	int			fd;
+
+	*length = 0;
+
+	fd = open( path, O_RDONLY );
+	if ( fd == -1 )
+		return NULL;
+
+	if ( fstat( fd, &st ) == -1 || st.st_size <= 0 || st.st_size > INT_MAX )
+	{
+		close( fd );
+		return NULL;
+	}
+
+	base = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );	// the mapping keeps the file open
+
+	if ( base == MAP_FAILED )
+		return NULL;
+
+	*length = (int)st.st_size;
+	return base;
+}
+
+/*
+==================
+Sys_UnmapFile
+==================
+*/
+void Sys_UnmapFile( void *base, int length )
+{
+	if ( base )
+		munmap( base, (size_t)length );
+}
+
 /*
 ==================
 Sys_Mkdir
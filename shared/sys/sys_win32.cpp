@@ -244,6 +244,52 @@ qboolean Sys_LowPhysicalMemory(void) {
 	return (stat.ullTotalPhys <= MEM_THRESHOLD) ? qtrue : qfalse;
 }
 
+/*
+==============
+Sys_MapFile
+==============
+*/
+void *Sys_MapFile( const char *path, int *length ) {
+	HANDLE			file, mapping;
+	LARGE_INTEGER	size;
+	void			*base;
+
+	*length = 0;
+
+	file = CreateFile( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		return NULL;
+
+	if ( !GetFileSizeEx( file, &size ) || size.QuadPart <= 0 || size.QuadPart > INT_MAX ) {
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( !mapping )
+		return NULL;
+
+	// the view keeps the mapping and the file open
+	base = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if ( !base )
+		return NULL;
+
+	*length = (int)size.QuadPart;
+	return base;
+}
+
+/*
+==============
+Sys_UnmapFile
+==============
+*/
+void Sys_UnmapFile( void *base, int length ) {
+	if ( base )
+		UnmapViewOfFile( base );
+}
+
 /*
 ==============
 Sys_Mkdir